@@ -0,0 +1,46 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/backtest.h"
+
+// Walk-forward backtest over a synthetic universe: symbols x 2520 bars
+// (ten years of trading days) of independent random walks.
+
+namespace {
+
+const std::vector<quant::BarSeries>& history(size_t symbols) {
+    static std::vector<quant::BarSeries> cache;
+    if (cache.size() < symbols) {
+        std::mt19937_64 rng(7);
+        std::normal_distribution<double> step(0.0003, 0.015);
+        for (size_t s = cache.size(); s < symbols; ++s) {
+            quant::BarSeries cols;
+            cols.reserve(2520);
+            double px = 50.0;
+            for (int d = 0; d < 2520; ++d) {
+                cols.push_back(15000 + d, px, px, px, px, px, 0);
+                px *= std::exp(step(rng));
+            }
+            cache.push_back(std::move(cols));
+        }
+    }
+    return cache;
+}
+
+void BM_backtest(benchmark::State& state) {
+    size_t symbols = static_cast<size_t>(state.range(0));
+    const auto& cols = history(symbols);
+    std::vector<quant::BarView> universe;
+    for (size_t s = 0; s < symbols; ++s) universe.push_back(cols[s].view("S"));
+    backtest::Config config;
+    config.threads = static_cast<unsigned>(state.range(1));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(backtest::run(universe, config));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(symbols) * 2520);
+}
+BENCHMARK(BM_backtest)->Args({300, 1})->Args({3000, 1})->Args({3000, 0})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Shared fixtures for the benchmark suite. QUANT_BENCH_FIXTURES is set by
+// CMake to bench/fixtures in the source tree.
+
+namespace bench {
+
+inline std::string read_fixture(const std::string& name) {
+    std::string path = std::string(QUANT_BENCH_FIXTURES) + "/" + name;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("missing fixture " + path);
+    std::ostringstream buf;
+    buf << in.rdbuf();
+    return buf.str();
+}
+
+// Deterministic random-walk OHLC series, oldest first
+struct Series {
+    std::vector<double> high, low, close, returns;
+};
+
+// Series are cached per length so the 10M-bar cases are generated once
+inline const Series& series(size_t n) {
+    static std::map<size_t, Series> cache;
+    auto it = cache.find(n);
+    if (it != cache.end()) return it->second;
+
+    Series s;
+    s.high.resize(n);
+    s.low.resize(n);
+    s.close.resize(n);
+    s.returns.resize(n > 0 ? n - 1 : 0);
+    std::mt19937_64 rng(42);
+    std::normal_distribution<double> step(0.0, 0.01);
+    double price = 100.0;
+    for (size_t i = 0; i < n; ++i) {
+        double next = price * std::exp(step(rng));
+        if (i > 0) s.returns[i - 1] = next / price - 1.0;
+        price = next;
+        s.close[i] = price;
+        s.high[i] = price * 1.005;
+        s.low[i] = price * 0.995;
+    }
+    return cache.emplace(n, std::move(s)).first->second;
+}
+
+} // namespace bench
@@ -0,0 +1,196 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "bench_common.h"
+#include "../include/fused.h"
+#include "../include/indicators.h"
+#include "../include/rolling.h"
+
+// Every indicator over 100 to 10M bars. For indicators that scan the whole
+// series, items processed = bars, so items_per_second is bars/s.
+
+namespace {
+
+void series_lengths(benchmark::internal::Benchmark* b) {
+    b->RangeMultiplier(10)->Range(100, 10'000'000);
+}
+
+// scans = false for indicators that only read the last `period` bars, whose
+// cost should stay flat as the series grows
+template <class F>
+void run(benchmark::State& state, F&& fn, bool scans = true) {
+    const auto& s = bench::series(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        fn(s);
+    }
+    if (scans) state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_sma(benchmark::State& state) {
+    run(state, [](const bench::Series& s) { benchmark::DoNotOptimize(quant::sma(s.close, 50)); }, false);
+}
+
+void BM_ema(benchmark::State& state) {
+    run(state, [](const bench::Series& s) { benchmark::DoNotOptimize(quant::ema(s.close, 20)); });
+}
+
+void BM_rsi(benchmark::State& state) {
+    run(state, [](const bench::Series& s) { benchmark::DoNotOptimize(quant::rsi(s.close, 14)); });
+}
+
+void BM_rsi_wilder(benchmark::State& state) {
+    run(state, [](const bench::Series& s) { benchmark::DoNotOptimize(quant::rsi_wilder(s.close, 14)); });
+}
+
+void BM_atr(benchmark::State& state) {
+    run(state, [](const bench::Series& s) { benchmark::DoNotOptimize(quant::atr(s.high, s.low, s.close, 14)); });
+}
+
+void BM_realized_vol(benchmark::State& state) {
+    run(state, [](const bench::Series& s) { benchmark::DoNotOptimize(quant::realized_vol(s.returns)); });
+}
+
+void BM_slope_logprice(benchmark::State& state) {
+    run(state, [](const bench::Series& s) { benchmark::DoNotOptimize(quant::slope_logprice(s.close)); });
+}
+
+void BM_max_drawdown(benchmark::State& state) {
+    run(state, [](const bench::Series& s) { benchmark::DoNotOptimize(quant::max_drawdown(s.close)); });
+}
+
+void BM_sma_series(benchmark::State& state) {
+    std::vector<double> out(state.range(0));
+    run(state, [&out](const bench::Series& s) {
+        quant::sma_series(s.close.data(), s.close.size(), 50, out.data());
+        benchmark::ClobberMemory();
+    });
+}
+
+void BM_ema_series(benchmark::State& state) {
+    std::vector<double> out(state.range(0));
+    run(state, [&out](const bench::Series& s) {
+        quant::ema_series(s.close.data(), s.close.size(), 20, out.data());
+        benchmark::ClobberMemory();
+    });
+}
+
+void BM_rsi_series(benchmark::State& state) {
+    std::vector<double> out(state.range(0));
+    run(state, [&out](const bench::Series& s) {
+        quant::rsi_series(s.close.data(), s.close.size(), 14, out.data());
+        benchmark::ClobberMemory();
+    });
+}
+
+void BM_atr_series(benchmark::State& state) {
+    std::vector<double> out(state.range(0));
+    run(state, [&out](const bench::Series& s) {
+        quant::atr_series(s.high.data(), s.low.data(), s.close.data(), s.close.size(), 14, out.data());
+        benchmark::ClobberMemory();
+    });
+}
+
+// Streaming indicators: cost of pushing every bar through one instance
+template <class Rolling, class Push>
+void rolling(benchmark::State& state, int period, Push&& push) {
+    run(state, [&](const bench::Series& s) {
+        Rolling r(period);
+        for (size_t i = 0; i < s.close.size(); ++i) push(r, s, i);
+        benchmark::DoNotOptimize(r.value());
+    });
+}
+
+void BM_rolling_sma(benchmark::State& state) {
+    rolling<quant::RollingSMA>(state, 50, [](auto& r, const bench::Series& s, size_t i) { r.push(s.close[i]); });
+}
+
+void BM_rolling_ema(benchmark::State& state) {
+    rolling<quant::RollingEMA>(state, 20, [](auto& r, const bench::Series& s, size_t i) { r.push(s.close[i]); });
+}
+
+void BM_rolling_rsi(benchmark::State& state) {
+    rolling<quant::RollingRSI>(state, 14, [](auto& r, const bench::Series& s, size_t i) { r.push(s.close[i]); });
+}
+
+void BM_rolling_atr(benchmark::State& state) {
+    rolling<quant::RollingATR>(state, 14, [](auto& r, const bench::Series& s, size_t i) {
+        r.push(s.high[i], s.low[i], s.close[i]);
+    });
+}
+
+void BM_rolling_variance(benchmark::State& state) {
+    run(state, [](const bench::Series& s) {
+        quant::RollingVariance r(20);
+        for (double x : s.returns) r.push(x);
+        benchmark::DoNotOptimize(r.stddev());
+    });
+}
+
+// The signal service's indicator set (monthly return, volatility of every
+// return, MA5, MA20): one call per indicator against the fused kernel
+void BM_signal_indicators_separate(benchmark::State& state) {
+    run(state, [](const bench::Series& s) {
+        size_t n = s.close.size();
+        double base = s.close[n - std::min<size_t>(30, n)];
+        quant::RollingVariance returns;
+        for (size_t i = 1; i < n; ++i) returns.push((s.close[i] - s.close[i-1]) / s.close[i-1]);
+        benchmark::DoNotOptimize((s.close.back() - base) / base);
+        benchmark::DoNotOptimize(returns.stddev());
+        benchmark::DoNotOptimize(quant::sma(s.close, 5));
+        benchmark::DoNotOptimize(quant::sma(s.close, 20));
+    });
+}
+
+void BM_signal_indicators_fused(benchmark::State& state) {
+    using namespace quant::fused;
+    run(state, [](const bench::Series& s) {
+        Kernel<Change<29, true>, Vol<0>, Sma<5>, Sma<20, true>> k(s.close);
+        benchmark::DoNotOptimize(k.get<Vol<0>>());
+    });
+}
+
+// quant_core's feature row: separate calls with a returns buffer, as the CLI
+// used to compute it, against the fused kernel
+void BM_feature_row_separate(benchmark::State& state) {
+    run(state, [](const bench::Series& s) {
+        size_t n = s.close.size();
+        std::vector<double> returns20;
+        for (size_t i = n - 20; i < n; ++i) returns20.push_back((s.close[i] - s.close[i-1]) / s.close[i-1]);
+        benchmark::DoNotOptimize(quant::sma(s.close, 50));
+        benchmark::DoNotOptimize(quant::sma(s.close, 200));
+        benchmark::DoNotOptimize(quant::ema(s.close, 20));
+        benchmark::DoNotOptimize(quant::slope_logprice(quant::Span<const double>(s.close).last(20)));
+        benchmark::DoNotOptimize(quant::realized_vol(returns20));
+    });
+}
+
+void BM_feature_row_fused(benchmark::State& state) {
+    using namespace quant::fused;
+    run(state, [](const bench::Series& s) {
+        Kernel<Sma<50>, Sma<200>, Ema<20>, Slope<20>, Vol<20>> k(s.close);
+        benchmark::DoNotOptimize(k.get<Ema<20>>());
+    });
+}
+
+}
+
+BENCHMARK(BM_sma)->Apply(series_lengths);
+BENCHMARK(BM_ema)->Apply(series_lengths);
+BENCHMARK(BM_rsi)->Apply(series_lengths);
+BENCHMARK(BM_rsi_wilder)->Apply(series_lengths);
+BENCHMARK(BM_atr)->Apply(series_lengths);
+BENCHMARK(BM_realized_vol)->Apply(series_lengths);
+BENCHMARK(BM_slope_logprice)->Apply(series_lengths);
+BENCHMARK(BM_max_drawdown)->Apply(series_lengths);
+BENCHMARK(BM_sma_series)->Apply(series_lengths);
+BENCHMARK(BM_ema_series)->Apply(series_lengths);
+BENCHMARK(BM_rsi_series)->Apply(series_lengths);
+BENCHMARK(BM_atr_series)->Apply(series_lengths);
+BENCHMARK(BM_rolling_sma)->Apply(series_lengths);
+BENCHMARK(BM_rolling_ema)->Apply(series_lengths);
+BENCHMARK(BM_rolling_rsi)->Apply(series_lengths);
+BENCHMARK(BM_rolling_atr)->Apply(series_lengths);
+BENCHMARK(BM_rolling_variance)->Apply(series_lengths);
+BENCHMARK(BM_signal_indicators_separate)->Apply(series_lengths);
+BENCHMARK(BM_signal_indicators_fused)->Apply(series_lengths);
+BENCHMARK(BM_feature_row_separate)->Apply(series_lengths);
+BENCHMARK(BM_feature_row_fused)->Apply(series_lengths);
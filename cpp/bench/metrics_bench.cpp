@@ -0,0 +1,63 @@
+#include <benchmark/benchmark.h>
+#include "../include/metrics.h"
+
+// Cost of the instrumentation left on in production; the threaded runs
+// share one metric across threads.
+
+namespace {
+
+metrics::Registry& bench_registry() {
+    static metrics::Registry registry;
+    return registry;
+}
+
+void BM_counter_inc(benchmark::State& state) {
+    static metrics::Counter& counter = bench_registry().counter("bench_counter_total", "bench");
+    for (auto _ : state) {
+        counter.inc();
+    }
+}
+
+void BM_histogram_record(benchmark::State& state) {
+    static metrics::Histogram& histogram = bench_registry().histogram("bench_record_seconds", "bench");
+    uint64_t nanos = 1;
+    for (auto _ : state) {
+        histogram.record(nanos);
+        nanos = nanos * 7 % 1'000'003;
+    }
+}
+
+void BM_scoped_timer(benchmark::State& state) {
+    static metrics::Histogram& histogram = bench_registry().timer("bench_timer_seconds", "bench");
+    for (auto _ : state) {
+        metrics::ScopedTimer timer(histogram);
+    }
+}
+
+// As the signal service times its per-symbol kernels: one call in 16
+void BM_scoped_timer_sampled(benchmark::State& state) {
+    static metrics::Histogram& histogram = bench_registry().timer("bench_sampled_timer_seconds", "bench");
+    thread_local uint32_t calls = 0;
+    for (auto _ : state) {
+        metrics::ScopedTimer timer(histogram, metrics::sample(calls, 16));
+    }
+}
+
+void BM_expose(benchmark::State& state) {
+    metrics::Registry registry;
+    for (int i = 0; i < 10; ++i) {
+        registry.histogram("route_seconds", "bench", {{"route", std::to_string(i)}}).record(1000 * i);
+        registry.counter("events_total", "bench", {{"event", std::to_string(i)}}).inc();
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(registry.expose());
+    }
+}
+
+}
+
+BENCHMARK(BM_counter_inc)->ThreadRange(1, 4);
+BENCHMARK(BM_histogram_record)->ThreadRange(1, 4);
+BENCHMARK(BM_scoped_timer)->ThreadRange(1, 4);
+BENCHMARK(BM_scoped_timer_sampled)->ThreadRange(1, 4);
+BENCHMARK(BM_expose);
@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "bench_common.h"
+#include "../include/alphavantage.h"
+#include "../include/csv_ingest.h"
+
+// Parse throughput over the fixture files. Bytes processed = input size, so
+// bytes_per_second is the parse rate.
+
+namespace {
+
+const std::string& daily_json() {
+    static const std::string body = bench::read_fixture("daily_adjusted.json");
+    return body;
+}
+
+// The fixture CSV repeated under distinct symbols until it is large enough
+// for the parallel ingest path to split it
+const std::string& large_csv() {
+    static const std::string text = [] {
+        std::string fixture = bench::read_fixture("prices.csv");
+        std::string rows = fixture.substr(fixture.find('\n') + 1);
+        std::string out = fixture.substr(0, fixture.find('\n') + 1);
+        for (int copy = 0; out.size() < (16u << 20); ++copy) {
+            std::string prefix = "C" + std::to_string(copy) + "_";
+            size_t pos = 0;
+            while (pos < rows.size()) {
+                size_t nl = rows.find('\n', pos);
+                out += prefix;
+                out.append(rows, pos, nl - pos + 1);
+                pos = nl + 1;
+            }
+        }
+        return out;
+    }();
+    return text;
+}
+
+// Pre-streaming implementation (DOM + stod + sort into per-bar records
+// with string dates), kept as the baseline
+struct DomBar {
+    std::string date;
+    double open, high, low, close, adj_close;
+    long volume;
+};
+
+std::vector<DomBar> parse_dom(const std::string& json_str) {
+    std::vector<DomBar> bars;
+    auto json = nlohmann::json::parse(json_str);
+    for (auto& [date, data] : json["Time Series (Daily)"].items()) {
+        DomBar bar;
+        bar.date = date;
+        bar.open = std::stod(data["1. open"].get<std::string>());
+        bar.high = std::stod(data["2. high"].get<std::string>());
+        bar.low = std::stod(data["3. low"].get<std::string>());
+        bar.close = std::stod(data["4. close"].get<std::string>());
+        bar.adj_close = std::stod(data["5. adjusted close"].get<std::string>());
+        bar.volume = std::stol(data["6. volume"].get<std::string>());
+        bars.push_back(bar);
+    }
+    std::sort(bars.begin(), bars.end(),
+        [](const DomBar& a, const DomBar& b) { return a.date < b.date; });
+    return bars;
+}
+
+void BM_json_dom_baseline(benchmark::State& state) {
+    const auto& body = daily_json();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parse_dom(body));
+    }
+    state.SetBytesProcessed(state.iterations() * body.size());
+}
+
+void BM_parse_daily_response(benchmark::State& state) {
+    const auto& body = daily_json();
+    for (auto _ : state) {
+        auto result = alphavantage::Client::parse_daily_response(body);
+        if (!result.ok()) state.SkipWithError(result.error.c_str());
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetBytesProcessed(state.iterations() * body.size());
+}
+
+void BM_parse_daily_columns(benchmark::State& state) {
+    const auto& body = daily_json();
+    quant::BarSeries cols;
+    std::string error;
+    for (auto _ : state) {
+        if (!alphavantage::Client::parse_daily_columns(body, cols, error)) state.SkipWithError(error.c_str());
+        benchmark::DoNotOptimize(cols.close.data());
+    }
+    state.SetBytesProcessed(state.iterations() * body.size());
+}
+
+void BM_parse_price_csv_fixture(benchmark::State& state) {
+    static const std::string text = bench::read_fixture("prices.csv");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(quant::parse_price_csv(text, 1));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+// range(0) = ingest threads (0 = all cores)
+void BM_parse_price_csv_large(benchmark::State& state) {
+    const auto& text = large_csv();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(quant::parse_price_csv(text, static_cast<unsigned>(state.range(0))));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+}
+
+BENCHMARK(BM_json_dom_baseline);
+BENCHMARK(BM_parse_daily_response);
+BENCHMARK(BM_parse_daily_columns);
+BENCHMARK(BM_parse_price_csv_fixture);
+BENCHMARK(BM_parse_price_csv_large)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,139 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bench_common.h"
+#include "../include/bar_cache.h"
+#include "../include/cross_section.h"
+#include "../include/signals.h"
+
+// End-to-end signal computation against a canned-data client: the cache's
+// fetch function parses the fixture response instead of calling the API.
+
+namespace {
+
+alphavantage::FetchResult canned_fetch(const std::string&, const std::string&) {
+    static const std::string body = bench::read_fixture("daily_adjusted.json");
+    return alphavantage::Client::parse_daily_response(body);
+}
+
+std::vector<std::string> universe(size_t n) {
+    std::vector<std::string> symbols;
+    for (size_t i = 0; i < n; ++i) symbols.push_back("SYM" + std::to_string(i));
+    return symbols;
+}
+
+// Every call misses the cache: parse + indicators
+void BM_compute_signal_cold(benchmark::State& state) {
+    alphavantage::BarCache cache(canned_fetch, std::chrono::seconds(3600));
+    signals::SignalService service(cache);
+    for (auto _ : state) {
+        cache.clear();
+        benchmark::DoNotOptimize(service.compute_signal("IBM"));
+    }
+}
+
+// Bars already cached: indicators only
+void BM_compute_signal_warm(benchmark::State& state) {
+    alphavantage::BarCache cache(canned_fetch, std::chrono::seconds(3600));
+    signals::SignalService service(cache);
+    service.compute_signal("IBM");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(service.compute_signal("IBM"));
+    }
+}
+
+// range(0) = symbols per request, all cold
+void BM_compute_signals_batch(benchmark::State& state) {
+    alphavantage::BarCache cache(canned_fetch, std::chrono::seconds(3600));
+    signals::SignalService service(cache);
+    auto symbols = universe(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        cache.clear();
+        benchmark::DoNotOptimize(service.compute_signals(symbols));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// As-of sweep over every fixture date with a full signal window, across
+// range(0) symbols. range(1) = 1 keeps the memo from earlier sweeps.
+void BM_as_of_sweep(benchmark::State& state) {
+    alphavantage::BarCache cache(canned_fetch, std::chrono::seconds(3600));
+    cache.set_local_fetch(canned_fetch);
+    auto symbols = universe(static_cast<size_t>(state.range(0)));
+    const bool warm = state.range(1) != 0;
+    auto history = canned_fetch("IBM", "full").bars;
+    std::vector<int32_t> days(history.date.begin() + signals::kSignalWindow - 1, history.date.end());
+
+    auto service = std::make_unique<signals::SignalService>(cache);
+    for (auto _ : state) {
+        if (!warm) {
+            state.PauseTiming();
+            service = std::make_unique<signals::SignalService>(cache);
+            state.ResumeTiming();
+        }
+        for (int32_t day : days) {
+            benchmark::DoNotOptimize(service->compute_signals(symbols, day));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * days.size() * symbols.size());
+}
+
+std::vector<signals::Signal> synthetic_signals(size_t n) {
+    std::vector<signals::Signal> signals(n);
+    uint64_t seed = 42;
+    for (size_t i = 0; i < n; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        auto& signal = signals[i];
+        signal.symbol = "SYM" + std::to_string(i);
+        signal.trend = "neutral";
+        signal.prob_up = 0.5;
+        signal.current_price = static_cast<double>(seed >> 44) / 100.0 + 1.0;
+        signal.ma5 = signal.ma20 = signal.current_price;
+        signal.data_points = 100;
+        signal.monthly_return = static_cast<double>(seed >> 40) / (1 << 24) * 40.0 - 20.0;
+        signal.volatility = static_cast<double>(seed >> 20 & 0xfffff) / (1 << 20) * 80.0;
+    }
+    return signals;
+}
+
+// Cross-sectional ranks and z-scores over range(0) synthetic signals
+void BM_cross_section(benchmark::State& state) {
+    auto columns = signals::SignalColumns::of(synthetic_signals(static_cast<size_t>(state.range(0))));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(signals::cross_section(columns));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Response body for range(0) signals: through a json tree and dump(), or
+// appended directly into a reused buffer
+void BM_signals_json_dom(benchmark::State& state) {
+    auto signals = synthetic_signals(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(signals::SignalService::to_json(signals, "2024-01-02").dump());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_signals_json_writer(benchmark::State& state) {
+    auto signals = synthetic_signals(static_cast<size_t>(state.range(0)));
+    std::string body;
+    for (auto _ : state) {
+        body.clear();
+        signals::SignalService::write_json(body, signals, "2024-01-02");
+        benchmark::DoNotOptimize(body.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}
+
+BENCHMARK(BM_compute_signal_cold);
+BENCHMARK(BM_compute_signal_warm);
+BENCHMARK(BM_compute_signals_batch)->RangeMultiplier(4)->Range(1, 256);
+BENCHMARK(BM_as_of_sweep)->Args({16, 0})->Args({16, 1})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_cross_section)->Arg(100)->Arg(3000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_signals_json_dom)->Arg(100)->Arg(3000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_signals_json_writer)->Arg(100)->Arg(3000)->Unit(benchmark::kMicrosecond);
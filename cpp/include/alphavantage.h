@@ -3,44 +3,107 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <optional>
+#include <chrono>
+#include <functional>
+#include <string_view>
 #include <nlohmann/json.hpp>
+#include "bar_series.h"
+#include "rate_limiter.h"
 
 namespace alphavantage {
 
-struct PriceBar {
-    std::string date;
-    double open;
-    double high;
-    double low;
-    double close;
-    double adj_close;
-    long volume;
+// Bars and error travel together so concurrent callers never share error state
+struct FetchResult {
+    quant::BarSeries bars;          // columns sorted by date ascending; empty on error
+    std::string error;              // empty if no error
+
+    bool ok() const { return error.empty(); }
+
+    static FetchResult failure(std::string message) {
+        FetchResult result;
+        result.error = std::move(message);
+        return result;
+    }
+};
+
+// Retries for requests the upstream rejected for rate limiting. The wait
+// before retry n is uniform in [0, min(cap, base * 2^n)] ("full jitter"), so
+// callers that were throttled together do not retry together.
+struct RetryPolicy {
+    int max_attempts = 4;
+    std::chrono::milliseconds base{2000};
+    std::chrono::milliseconds cap{60000};
 };
 
+// All fetch methods are const and reentrant: one Client can be shared by any
+// number of threads without external locking.
 class Client {
 public:
-    explicit Client(const std::string& api_key);
+    // Called once per symbol as its transfer finishes: (index into symbols, result)
+    using BatchCallback = std::function<void(size_t index, FetchResult result)>;
+
+    // max_in_flight bounds concurrent transfers in fetch_many; every request,
+    // including retries, takes a token from a limiter built from `limits`
+    explicit Client(const std::string& api_key, int max_in_flight = 8,
+                    RateLimits limits = {}, RetryPolicy retry = {});
+    ~Client();
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
 
     // Fetch daily adjusted prices for a symbol
-    // Returns prices sorted by date ascending (oldest first)
-    std::vector<PriceBar> fetch_daily_adjusted(const std::string& symbol);
+    // outputsize is "compact" (latest 100 bars) or "full" (20+ years)
+    // Returns prices sorted by date ascending (oldest first), or an error
+    FetchResult fetch_daily_adjusted(const std::string& symbol,
+                                     const std::string& outputsize = "compact",
+                                     Priority priority = Priority::Interactive) const;
+
+    // Fetch many symbols concurrently over one curl multi handle, keeping at
+    // most max_in_flight transfers open. on_done runs on the calling thread
+    // as soon as each symbol's response has been parsed. Transfers are paced
+    // by the rate limiter and yield to interactive requests.
+    void fetch_many(const std::vector<std::string>& symbols, const std::string& outputsize,
+                    const BatchCallback& on_done, Priority priority = Priority::Bulk) const;
+
+    int max_in_flight() const { return max_in_flight_; }
+    const RateLimiter& rate_limiter() const { return *limiter_; }
+
+    // True for results the upstream rejected for rate limiting (a "Note" or
+    // rate-limit "Information" payload, or HTTP 429)
+    static bool is_rate_limited(const FetchResult& result);
+    // True for results refused because the daily quota is spent, locally or
+    // by the server's "requests per day" notice; these are never retried
+    static bool is_quota_exhausted(const FetchResult& result);
 
     // Check if client is configured with valid API key
     bool is_configured() const;
 
-    // Get last error message
-    const std::string& last_error() const;
+    // Parse an AlphaVantage TIME_SERIES_DAILY(_ADJUSTED) JSON body
+    static FetchResult parse_daily_response(const std::string& json_str);
+
+    // The same, into caller-owned columns: streamed oldest first without
+    // building a JSON document. Returns false and sets error on failure.
+    static bool parse_daily_columns(std::string_view json_str, quant::BarSeries& out, std::string& error);
 
 private:
+    // Connection cache, TLS sessions and DNS shared by every transfer
+    struct CurlShare;
+
     std::string api_key_;
-    std::string last_error_;
+    int max_in_flight_;
+    std::unique_ptr<CurlShare> share_;
+    std::unique_ptr<RateLimiter> limiter_;
+    RetryPolicy retry_;
+
+    // Jittered wait before retry number `attempt` (0-based)
+    std::chrono::milliseconds retry_delay(int attempt) const;
 
-    // HTTP GET request helper
-    std::optional<std::string> http_get(const std::string& url);
+    std::string build_url(const std::string& symbol, const std::string& outputsize) const;
 
-    // Parse AlphaVantage JSON response
-    std::vector<PriceBar> parse_daily_response(const std::string& json_str);
+    // HTTP GET request helper; sets error and returns nullopt on failure
+    std::optional<std::string> http_get(const std::string& url, std::string& error) const;
 };
 
 } // namespace alphavantage
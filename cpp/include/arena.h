@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace quant {
+
+struct ArenaStats {
+    uint64_t allocations = 0;   // requests served from the arena
+    uint64_t heap_blocks = 0;   // blocks drawn from the heap
+    size_t capacity = 0;        // bytes held across all blocks
+    size_t high_water = 0;      // most bytes in use at once
+};
+
+// Process-wide totals across every thread's arena
+struct ArenaTotals {
+    uint64_t scopes = 0;        // ArenaScopes closed
+    uint64_t heap_blocks = 0;
+    uint64_t heap_bytes = 0;
+};
+
+// Monotonic bump allocator for request-scoped scratch. Deallocation is a
+// no-op; rewind() releases everything allocated after a mark in one step
+// and keeps the blocks, so once an arena has grown to a request's peak,
+// later requests of the same shape never touch the heap.
+class Arena final : public std::pmr::memory_resource {
+public:
+    struct Mark {
+        size_t block = 0;
+        size_t offset = 0;
+    };
+
+    explicit Arena(size_t block_size = 64 << 10);
+    ~Arena() override;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    Mark mark() const { return Mark{current_, offset_}; }
+    void rewind(const Mark& mark);
+    void reset() { rewind(Mark{}); }
+
+    ArenaStats stats() const { return stats_; }
+
+private:
+    struct Block {
+        std::byte* data;
+        size_t size;
+    };
+
+    size_t block_size_;
+    std::vector<Block> blocks_;
+    size_t current_ = 0;        // block being bumped
+    size_t offset_ = 0;         // next free byte in that block
+    size_t base_ = 0;           // bytes in the blocks before current_
+    ArenaStats stats_;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+// The calling thread's arena
+Arena& thread_arena();
+
+ArenaTotals arena_totals();
+
+// Rewinds the thread's arena to where it stood on entry. Scopes nest, so a
+// callee may open its own; containers allocated in an outer scope must not
+// grow while an inner one is open, or the inner rewind reclaims their storage.
+class ArenaScope {
+public:
+    ArenaScope();
+    ~ArenaScope();
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    std::pmr::memory_resource* resource() { return &arena_; }
+
+private:
+    Arena& arena_;
+    Arena::Mark mark_;
+};
+
+} // namespace quant
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bar_series.h"
+
+namespace backtest {
+
+struct Config {
+    int horizon = 20;               // forward return horizon, in bars
+    int folds = 5;                  // contiguous walk-forward date ranges
+    size_t min_cross_section = 10;  // symbols a date needs to count towards IC and deciles
+    unsigned threads = 0;           // 0 = all cores
+};
+
+struct Metrics {
+    int32_t first_date = 0;
+    int32_t last_date = 0;
+    size_t observations = 0;        // (symbol, date) signals with a known forward return
+    size_t dates = 0;               // dates with at least min_cross_section symbols
+    double hit_rate = NAN;          // directional calls (prob_up != 0.5) with the right sign
+    double mean_ic = NAN;           // mean per-date Spearman rank IC of prob_up vs forward return
+    double ic_ir = NAN;             // mean_ic / stddev of the per-date IC
+    std::array<double, 10> decile_returns{};   // mean forward return by prob_up decile, lowest first
+    double decile_spread = NAN;     // top minus bottom decile
+};
+
+struct Report {
+    Metrics overall;
+    std::vector<Metrics> folds;     // oldest first
+};
+
+// Replay every symbol's bars (oldest first) with the SignalService rules
+// (incremental MA5/MA20 and a 30-bar monthly return, so each signal sees only
+// bars up to its own date), label it with the forward `horizon`-bar return and score
+// the signals cross-sectionally per date. Symbols are replayed in parallel,
+// then dates are scored in parallel and aggregated into folds.
+// The close column drives the signal, as in SignalService; forward returns
+// use adj_close (close if that column is empty).
+Report run(const std::vector<quant::BarView>& universe, const Config& config = {});
+
+} // namespace backtest
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "alphavantage.h"
+
+namespace alphavantage {
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t coalesced = 0;     // lookups that joined an in-flight fetch
+    size_t entries = 0;
+    double oldest_age_seconds = 0;
+};
+
+struct CacheEntryInfo {
+    std::string symbol;
+    std::string outputsize;
+    size_t bars = 0;
+    double age_seconds = 0;
+};
+
+// Thread-safe, TTL-bounded cache of daily bars keyed by (symbol, outputsize).
+// Concurrent lookups for the same key share a single upstream fetch.
+class BarCache {
+public:
+    using Bars = std::shared_ptr<const quant::BarSeries>;
+
+    struct Result {
+        Bars bars;              // never null; empty on error
+        std::string error;      // empty if no error
+        bool hit = false;
+    };
+
+    // Upstream fetch for a single key
+    using FetchFn = std::function<FetchResult(const std::string& symbol, const std::string& outputsize)>;
+
+    // Batched upstream fetch: calls on_done once per symbol, in completion order
+    using BatchFetchFn = std::function<void(const std::vector<std::string>& symbols,
+                                            const std::string& outputsize,
+                                            const Client::BatchCallback& on_done,
+                                            Priority priority)>;
+
+    // Called once per requested symbol as soon as its bars are available
+    using ReadyFn = std::function<void(size_t index, const Result& result)>;
+
+    BarCache(const Client& client, std::chrono::seconds ttl);
+    BarCache(FetchFn fetch, std::chrono::seconds ttl, BatchFetchFn batch_fetch = nullptr);
+
+    // Errors from get_local for history that is neither cached nor stored
+    // locally start with this
+    static constexpr const char* kNotCached = "History not cached";
+    static bool is_not_cached(const std::string& error);
+
+    // Reads local storage only (the price store), for get_local. Set before
+    // serving requests; without one get_local serves cache hits only.
+    void set_local_fetch(FetchFn local_fetch);
+
+    // Return cached bars if younger than the TTL, otherwise fetch them.
+    // Failed fetches are shared with concurrent waiters but never cached.
+    Result get(const std::string& symbol, const std::string& outputsize = "compact");
+
+    // Resolve many symbols at once. Fresh entries are reported first, cold
+    // keys are fetched together through the batch fetcher at `priority`, and
+    // keys already being fetched by another caller are waited on last.
+    // on_ready runs on the calling thread.
+    void get_many(const std::vector<std::string>& symbols, const std::string& outputsize,
+                  const ReadyFn& on_ready, Priority priority = Priority::Bulk);
+
+    // As get_many, but never goes upstream: misses are read through the
+    // local fetcher (and cached), or fail with kNotCached
+    void get_local(const std::vector<std::string>& symbols, const std::string& outputsize,
+                   const ReadyFn& on_ready);
+
+    // Whether get would be a hit, without counting it as one
+    bool fresh(const std::string& symbol, const std::string& outputsize) const;
+
+    void invalidate(const std::string& symbol);
+    void clear();
+
+    CacheStats stats() const;
+    std::vector<CacheEntryInfo> entries() const;
+
+    std::chrono::seconds ttl() const { return ttl_; }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string symbol;
+        std::string outputsize;
+        Bars bars;
+        clock::time_point fetched_at;
+    };
+
+    FetchFn fetch_;
+    BatchFetchFn batch_fetch_;
+    FetchFn local_fetch_;
+    std::chrono::seconds ttl_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::unordered_map<std::string, std::shared_future<Result>> in_flight_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t coalesced_ = 0;
+    clock::time_point last_purge_ = clock::now();
+
+    // Writes into `key` so batch lookups can reuse one buffer
+    static void make_key(const std::string& symbol, const std::string& outputsize, std::string& key);
+    Result publish(const std::string& key, const std::string& symbol, const std::string& outputsize,
+                   FetchResult fetched);
+    // Drops expired entries, at most once per TTL
+    void purge_expired_locked(clock::time_point now);
+};
+
+} // namespace alphavantage
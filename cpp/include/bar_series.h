@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "span.h"
+
+namespace quant {
+
+struct BarSeries;
+
+// Zero-copy view of one symbol's columns, over a BarSeries or straight into
+// a mapped BarStore
+struct BarView {
+    std::string_view symbol;
+    Span<const int32_t> date;
+    Span<const double> open;
+    Span<const double> high;
+    Span<const double> low;
+    Span<const double> close;
+    Span<const double> adj_close;
+    Span<const int64_t> volume;
+
+    size_t size() const { return close.size(); }
+    bool empty() const { return close.empty(); }
+
+    // Rows [begin, end); columns left empty stay empty
+    BarView slice(size_t begin, size_t end) const;
+
+    // Bars dated on or before `day`, found by binary search on the date column
+    BarView as_of(int32_t day) const {
+        return slice(0, static_cast<size_t>(std::upper_bound(date.begin(), date.end(), day) - date.begin()));
+    }
+
+    // The most recent n bars (all of them if fewer)
+    BarView last(size_t n) const { return slice(size() - std::min(n, size()), size()); }
+
+    BarSeries to_series() const;
+};
+
+// Struct-of-arrays daily bars for one symbol, oldest first. Indicators read
+// only the columns they need, and each column is contiguous.
+struct BarSeries {
+    std::vector<int32_t> date;          // days since 1970-01-01 (see dates.h)
+    std::vector<double> open;
+    std::vector<double> high;
+    std::vector<double> low;
+    std::vector<double> close;
+    std::vector<double> adj_close;
+    std::vector<int64_t> volume;
+
+    size_t size() const { return close.size(); }
+    bool empty() const { return close.empty(); }
+
+    BarView view(std::string_view symbol = {}) const {
+        return BarView{symbol, date, open, high, low, close, adj_close, volume};
+    }
+
+    void resize(size_t n) {
+        date.resize(n); open.resize(n); high.resize(n); low.resize(n);
+        close.resize(n); adj_close.resize(n); volume.resize(n);
+    }
+
+    void reserve(size_t n) {
+        date.reserve(n); open.reserve(n); high.reserve(n); low.reserve(n);
+        close.reserve(n); adj_close.reserve(n); volume.reserve(n);
+    }
+
+    void push_back(int32_t d, double o, double h, double l, double c, double adj, int64_t v) {
+        date.push_back(d); open.push_back(o); high.push_back(h); low.push_back(l);
+        close.push_back(c); adj_close.push_back(adj); volume.push_back(v);
+    }
+
+    // Move row `from` to row `to` (used when compacting in place)
+    void move_row(size_t from, size_t to) {
+        date[to] = date[from]; open[to] = open[from]; high[to] = high[from]; low[to] = low[from];
+        close[to] = close[from]; adj_close[to] = adj_close[from]; volume[to] = volume[from];
+    }
+};
+
+inline BarView BarView::slice(size_t begin, size_t end) const {
+    auto cut = [begin, end](auto column) { return column.empty() ? column : column.subspan(begin, end - begin); };
+    return BarView{symbol, cut(date), cut(open), cut(high), cut(low), cut(close), cut(adj_close), cut(volume)};
+}
+
+inline BarSeries BarView::to_series() const {
+    BarSeries s;
+    s.date.assign(date.begin(), date.end());
+    s.open.assign(open.begin(), open.end());
+    s.high.assign(high.begin(), high.end());
+    s.low.assign(low.begin(), low.end());
+    s.close.assign(close.begin(), close.end());
+    s.adj_close.assign(adj_close.begin(), adj_close.end());
+    s.volume.assign(volume.begin(), volume.end());
+    return s;
+}
+
+} // namespace quant
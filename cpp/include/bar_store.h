@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "bar_series.h"
+#include "mapped_file.h"
+
+namespace quant {
+
+// On-disk columnar bar store (".qbars"). Layout, all little-endian and every
+// array 8-byte aligned:
+//
+//   header    magic "QBARS\0\0\0", u32 version, u32 symbol_count,
+//             u64 index_offset, u64 names_offset, u64 file_size
+//   columns   per symbol: i32 date[rows] (padded to 8 bytes),
+//             f64 open/high/low/close/adj_close[rows], i64 volume[rows]
+//   names     symbol names, concatenated
+//   index     symbol_count entries sorted by name:
+//             u32 name_offset, u32 name_length, u64 rows, u64 data_offset
+//
+// Readers map the file and hand out pointers straight into the mapping, so
+// opening a store costs one mmap regardless of history length and the pages
+// are shared by every process reading the same file.
+
+class BarStore {
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    // Write `symbols` to `path` (via a temporary file and rename, so readers
+    // never observe a partial store). Returns false and sets error on failure.
+    static bool write(const std::string& path, const std::map<std::string, BarSeries>& symbols,
+                      std::string& error);
+
+    // Map and validate a store; returns false and sets error on failure
+    bool open(const std::string& path, std::string& error);
+
+    // True if the file starts with the store magic
+    static bool is_bar_store(const std::string& path);
+
+    size_t size() const { return count_; }
+    BarView at(size_t i) const;
+    std::optional<BarView> find(std::string_view symbol) const;
+
+private:
+    struct IndexEntry {
+        uint32_t name_offset;
+        uint32_t name_length;
+        uint64_t rows;
+        uint64_t data_offset;
+    };
+
+    MappedFile file_;
+    const IndexEntry* index_ = nullptr;
+    const char* names_ = nullptr;
+    size_t count_ = 0;
+
+    std::string_view name_of(const IndexEntry& entry) const;
+};
+
+} // namespace quant
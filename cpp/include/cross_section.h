@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include "signals.h"
+
+namespace signals {
+
+// Where each symbol sits within its universe on monthly return and
+// volatility. Per-symbol vectors run parallel to the input; symbols left out
+// of the ranking (failed signals) hold NaN and decile 0.
+struct CrossSection {
+    explicit CrossSection(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : return_percentile(resource), return_zscore(resource), volatility_percentile(resource),
+          volatility_zscore(resource), return_decile(resource) {}
+
+    size_t scored = 0;                      // symbols ranked
+
+    double return_mean = 0.0;               // monthly return, percent
+    double return_std = 0.0;                // population standard deviation
+    double volatility_mean = 0.0;
+    double volatility_std = 0.0;
+
+    std::pmr::vector<double> return_percentile;  // 0 (lowest) to 100 (highest); ties share
+    std::pmr::vector<double> return_zscore;      // 0 when the universe has no spread
+    std::pmr::vector<double> volatility_percentile;
+    std::pmr::vector<double> volatility_zscore;
+    std::pmr::vector<uint8_t> return_decile;     // 1 (lowest) to 10 (highest)
+};
+
+// One pass over column-major inputs: the valid rows are packed into
+// contiguous columns once, then moments come from the SIMD reductions and
+// ranks from a single packed-key sort per column. Ranking is at float
+// precision. Results are allocated from `resource` (e.g. an enclosing
+// ArenaScope's), scratch from the thread's arena.
+CrossSection cross_section(const double* monthly_return, const double* volatility, const uint8_t* valid,
+                           size_t n, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+// Ranks the signals the columns were filled from
+CrossSection cross_section(const SignalColumns& columns,
+                           std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+} // namespace signals
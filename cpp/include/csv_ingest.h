@@ -0,0 +1,30 @@
+#pragma once
+#include <map>
+#include <string>
+#include <string_view>
+#include "bar_series.h"
+
+namespace quant {
+
+// Columnar price history for a whole CSV export, keyed by symbol (sorted).
+// Rows keep file order within each symbol.
+struct PriceTable {
+    std::map<std::string, BarSeries> symbols;
+    size_t rows = 0;            // rows loaded
+    size_t skipped = 0;         // rows dropped because close did not parse
+    std::string error;          // empty if no error
+
+    bool ok() const { return error.empty(); }
+};
+
+// Load a CSV with header symbol,date,open,high,low,close,adj_close,volume.
+// The file is memory-mapped and split on line boundaries across `threads`
+// workers (0 = hardware concurrency). A first pass counts rows per symbol so
+// the columns are allocated once at their final size; a second pass parses
+// fields with std::from_chars straight into place.
+PriceTable load_price_csv(const std::string& path, unsigned threads = 0);
+
+// Same as load_price_csv for text already in memory (header line included)
+PriceTable parse_price_csv(std::string_view text, unsigned threads = 0);
+
+} // namespace quant
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace quant {
+
+// Dates are stored as int32 day numbers (days since 1970-01-01), which keeps
+// bar columns compact, sortable and free of per-bar string allocations.
+
+constexpr int32_t kInvalidDate = INT32_MIN;
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+constexpr int32_t days_from_civil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int32_t>(doe) - 719468;
+}
+
+// Days in month `m` (1-12) of year `y`, leap years included
+constexpr int days_in_month(int y, int m) {
+    constexpr int days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+    return m == 2 && leap ? 29 : days[m - 1];
+}
+
+// Parse "YYYY-MM-DD"; returns kInvalidDate if malformed or not a real day
+// (2023-02-29, 2024-04-31)
+int32_t parse_date(std::string_view text);
+
+// Format a day number as "YYYY-MM-DD"
+std::string format_date(int32_t days);
+
+} // namespace quant
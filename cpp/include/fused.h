@@ -0,0 +1,219 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include "span.h"
+
+namespace quant {
+namespace fused {
+
+// Single-pass evaluation of several indicators over the same close series.
+// The indicator set is a compile-time list, e.g.
+//
+//     fused::Kernel<fused::Sma<5>, fused::Sma<20>, fused::Vol<20>> k(closes);
+//     double ma5 = k.get<fused::Sma<5>>();
+//
+// and the kernel walks the closes once, from the oldest bar any indicator
+// needs, handing each bar (and its return and log price, computed only if
+// some indicator reads them) to every indicator that covers it. Nothing allocates;
+// each indicator keeps a few scalars. Results match the scalar functions in
+// indicators.h up to summation order.
+
+// One bar as seen by the indicators
+struct Bar {
+    size_t t;           // index into the series
+    size_t n;           // series length
+    double close;
+    double ret;         // simple return from the previous close; NAN at t = 0 and where unread
+    double log;         // log(close); NAN where no indicator reads it
+};
+
+// Mean of the last Period closes, as quant::sma. Partial averages the whole
+// series when it is shorter instead of returning NAN.
+template <int Period, bool Partial = false>
+struct Sma {
+    static_assert(Period > 0, "Sma period must be positive");
+    static constexpr size_t kLookback = Period;
+    static constexpr bool kUsesReturn = false;
+    static constexpr bool kUsesLog = false;
+
+    double sum = 0.0;
+    size_t count = 0;
+
+    void push(const Bar& bar) {
+        if (bar.t + Period >= bar.n) {
+            sum += bar.close;
+            ++count;
+        }
+    }
+    double value() const {
+        if (count == 0 || (!Partial && count < static_cast<size_t>(Period))) return NAN;
+        return sum / count;
+    }
+};
+
+// Exponential average seeded with the SMA of the first Period closes, as
+// quant::ema; it needs the whole series
+template <int Period>
+struct Ema {
+    static_assert(Period > 0, "Ema period must be positive");
+    static constexpr size_t kLookback = 0;
+    static constexpr bool kUsesReturn = false;
+    static constexpr bool kUsesLog = false;
+    static constexpr double kAlpha = 2.0 / (Period + 1.0);
+
+    double ema = 0.0;
+    size_t count = 0;
+
+    void push(const Bar& bar) {
+        if (count < static_cast<size_t>(Period)) {
+            ema += bar.close;
+            if (++count == static_cast<size_t>(Period)) ema /= Period;
+        } else {
+            ema = bar.close * kAlpha + ema * (1.0 - kAlpha);
+            ++count;
+        }
+    }
+    double value() const { return count < static_cast<size_t>(Period) ? NAN : ema; }
+};
+
+// Sample standard deviation of the last Window daily returns (Welford);
+// Window = 0 takes every return in the series
+template <int Window>
+struct Vol {
+    static_assert(Window >= 0, "Vol window must not be negative");
+    static constexpr size_t kLookback = Window;
+    static constexpr bool kUsesReturn = true;
+    static constexpr bool kUsesLog = false;
+
+    size_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    void push(const Bar& bar) {
+        if (bar.t == 0 || (Window > 0 && bar.t + Window < bar.n)) return;
+        ++count;
+        double delta = bar.ret - mean;
+        mean += delta / count;
+        m2 += delta * (bar.ret - mean);
+    }
+    double value() const {
+        if (count == 0) return NAN;
+        return count < 2 ? 0.0 : std::sqrt(std::max(0.0, m2) / (count - 1));
+    }
+};
+
+// Least-squares slope of log price against bar index over the last Window
+// closes, as quant::slope_logprice (NAN when fewer than two). With x
+// centred, the slope is sum((i - mean_i) * log p_i) / sum((i - mean_i)^2),
+// so one pass suffices.
+template <int Window>
+struct Slope {
+    static_assert(Window >= 2, "Slope needs at least two points");
+    static constexpr size_t kLookback = Window;
+    static constexpr bool kUsesReturn = false;
+    static constexpr bool kUsesLog = true;
+
+    double num = 0.0;
+    size_t count = 0;
+    double x_mean = 0.0;
+
+    void push(const Bar& bar) {
+        if (bar.t + Window < bar.n) return;
+        if (count == 0) x_mean = (std::min<size_t>(Window, bar.n) - 1) / 2.0;
+        num += (static_cast<double>(count) - x_mean) * bar.log;
+        ++count;
+    }
+    double value() const {
+        if (count < 2) return NAN;
+        double m = static_cast<double>(count);
+        return num / (m * (m * m - 1.0) / 12.0);
+    }
+};
+
+// Relative change from the close Lag bars back to the last one,
+// (last - base) / base. Partial falls back to the first close when the
+// series is shorter.
+template <int Lag, bool Partial = false>
+struct Change {
+    static_assert(Lag > 0, "Change lag must be positive");
+    static constexpr size_t kLookback = Lag + 1;
+    static constexpr bool kUsesReturn = false;
+    static constexpr bool kUsesLog = false;
+
+    double base = NAN;
+    double last = NAN;
+
+    void push(const Bar& bar) {
+        if (bar.t + Lag + 1 == bar.n || (Partial && bar.t == 0 && bar.n <= Lag)) base = bar.close;
+        if (bar.t + 1 == bar.n) last = bar.close;
+    }
+    double value() const { return (last - base) / base; }
+};
+
+template <class... Indicators>
+class Kernel {
+public:
+    static_assert(sizeof...(Indicators) > 0, "Kernel needs at least one indicator");
+
+    // Bars from the end that windowed indicators read
+    static constexpr size_t kWindow = std::max({size_t(1), Indicators::kLookback...});
+    // Bars from the end the kernel visits; 0 when an indicator reads the
+    // whole series
+    static constexpr size_t kLookback = ((Indicators::kLookback == 0) || ...) ? 0 : kWindow;
+    static constexpr bool kUsesLog = (Indicators::kUsesLog || ...);
+
+    explicit Kernel(Span<const double> closes) { run(closes); }
+
+    template <class Indicator>
+    double get() const { return std::get<Indicator>(state_).value(); }
+
+private:
+    std::tuple<Indicators...> state_;
+
+    // Bars from the end whose return or log price some indicator reads
+    // (SIZE_MAX = every bar), so a long SMA window does not pay for logs
+    static constexpr size_t window_of(bool uses, size_t lookback) {
+        return uses ? (lookback == 0 ? SIZE_MAX : lookback) : 0;
+    }
+    static constexpr size_t kReturnWindow = std::max({window_of(Indicators::kUsesReturn, Indicators::kLookback)...});
+    static constexpr size_t kLogWindow = std::max({window_of(Indicators::kUsesLog, Indicators::kLookback)...});
+
+    template <size_t Window>
+    static bool covered(size_t t, size_t n) { return Window == SIZE_MAX || t + Window >= n; }
+
+    // Feeds bars [begin, end) to every indicator, or to the whole-series ones
+    // only, computing the return and log price only when a recipient reads it
+    template <bool WholeSeriesOnly>
+    void pass(const double* p, size_t begin, size_t end, size_t n) {
+        constexpr bool uses_return = ((Indicators::kUsesReturn && (!WholeSeriesOnly || Indicators::kLookback == 0)) || ...);
+        constexpr bool uses_log = ((Indicators::kUsesLog && (!WholeSeriesOnly || Indicators::kLookback == 0)) || ...);
+        for (size_t t = begin; t < end; ++t) {
+            Bar bar{t, n, p[t], NAN, NAN};
+            if constexpr (uses_return) {
+                if (t > 0 && covered<kReturnWindow>(t, n)) bar.ret = (p[t] - p[t - 1]) / p[t - 1];
+            }
+            if constexpr (uses_log) {
+                if (covered<kLogWindow>(t, n)) bar.log = std::log(p[t]);
+            }
+            std::apply([&bar](auto&... indicator) {
+                ((!WholeSeriesOnly || std::decay_t<decltype(indicator)>::kLookback == 0 ? indicator.push(bar) : void()), ...);
+            }, state_);
+        }
+    }
+
+    // Whole-series indicators run alone up to the trailing window, then
+    // every indicator sees the window
+    void run(Span<const double> closes) {
+        const size_t n = closes.size();
+        const size_t window_start = n > kWindow ? n - kWindow : 0;
+        if constexpr (kLookback == 0) pass<true>(closes.data(), 0, window_start, n);
+        pass<false>(closes.data(), window_start, n, n);
+    }
+};
+
+} // namespace fused
+} // namespace quant
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace http {
+
+enum class Encoding { Identity, Gzip, Deflate };
+
+// A response body prepared once and served many times: the identity bytes,
+// their compressed forms and a strong ETag over the identity bytes.
+struct CachedBody {
+    std::string identity;
+    std::string gzip;           // empty if not precompressed
+    std::string deflate;        // empty if not precompressed
+    std::string etag;           // quoted, e.g. "\"9f3c...\""
+
+    static CachedBody make(std::string body, bool precompress = true);
+    // A body served once: compressed only for the negotiated `encoding`
+    static CachedBody make_for(std::string body, Encoding encoding);
+
+    // Encoding actually served for a negotiated one: identity if that
+    // encoding was not precompressed
+    Encoding available(Encoding encoding) const;
+    const std::string& encoded(Encoding encoding) const;
+
+    // Each representation gets its own strong ETag ("<hash>-gzip" etc.)
+    std::string etag_for(Encoding encoding) const;
+};
+
+// Quoted strong ETag derived from the content (64-bit FNV-1a)
+std::string content_etag(std::string_view body);
+
+// True if an If-None-Match header value matches etag (weak comparison,
+// comma-separated lists and "*" are supported)
+bool etag_matches(std::string_view if_none_match, std::string_view etag);
+
+// Best encoding accepted by an Accept-Encoding header, preferring gzip
+Encoding negotiate_encoding(std::string_view accept_encoding);
+
+// Header value for Content-Encoding, or empty for identity
+const char* encoding_name(Encoding encoding);
+
+// Compress with zlib; returns an empty string on failure
+std::string compress(std::string_view data, Encoding encoding);
+
+} // namespace http
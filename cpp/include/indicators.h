@@ -1,16 +1,32 @@
 #pragma once
+#include <cstddef>
 #include <vector>
 #include <optional>
+#include "span.h"
 
 namespace quant {
 
-// Simple indicator utilities. Input is a vector of doubles (close prices or volumes).
-double sma(const std::vector<double>& data, int period);
-double ema(const std::vector<double>& data, int period);
-double realized_vol(const std::vector<double>& returns); // sample stddev
-std::optional<double> slope_logprice(const std::vector<double>& prices);
-double atr(const std::vector<double>& high, const std::vector<double>& low, const std::vector<double>& close, int period);
-double rsi(const std::vector<double>& closes, int period);
-double max_drawdown(const std::vector<double>& prices);
+// Simple indicator utilities. Input is a span of doubles (close prices or
+// volumes): a std::vector, a BarSeries column or a mapped BarStore column.
+double sma(Span<const double> data, int period);
+double ema(Span<const double> data, int period);
+double realized_vol(Span<const double> returns); // sample stddev
+std::optional<double> slope_logprice(Span<const double> prices);
+double atr(Span<const double> high, Span<const double> low, Span<const double> close, int period);
+double rsi(Span<const double> closes, int period); // average of the first 'period' changes
+double rsi_wilder(Span<const double> closes, int period); // rsi seed, then Wilder smoothing to the end
+double max_drawdown(Span<const double> prices);
+
+// Full-series variants: out[i] equals the scalar indicator over data[0..i]
+// (NAN until enough history). One pass, no allocation; out must hold n values.
+void sma_series(const double* data, size_t n, int period, double* out);
+void ema_series(const double* data, size_t n, int period, double* out);
+void rsi_series(const double* closes, size_t n, int period, double* out);   // rsi_wilder
+void atr_series(const double* high, const double* low, const double* close, size_t n, int period, double* out);
+
+std::vector<double> sma_series(const std::vector<double>& data, int period);
+std::vector<double> ema_series(const std::vector<double>& data, int period);
+std::vector<double> rsi_series(const std::vector<double>& closes, int period);
+std::vector<double> atr_series(const std::vector<double>& high, const std::vector<double>& low, const std::vector<double>& close, int period);
 
 } // namespace quant
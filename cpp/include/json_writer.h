@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace http {
+
+// Streaming JSON writer that appends straight to a caller-owned buffer, so
+// a reused buffer never allocates once it has grown to the largest
+// response. Output is byte-for-byte what nlohmann::json::dump() produces
+// for the same document, provided keys are written in sorted order (the
+// order nlohmann's std::map objects serialize in):
+//   - numbers go through dump()'s own Grisu2 formatter (round-trip digits,
+//     exponents outside [-4, 15), ".0" on integral values); NaN and
+//     infinities become null
+//   - strings escape '"', '\\' and control characters only
+// Invalid UTF-8, which dump() rejects with an exception, is written as
+// U+FFFD instead. Opening a container deeper than kMaxDepth throws
+// std::length_error.
+class JsonWriter {
+public:
+    static constexpr int kMaxDepth = 63;
+
+    explicit JsonWriter(std::string& out) : out_(out) {}
+
+    void begin_object() { open('{'); }
+    void end_object() { close('}'); }
+    void begin_array() { open('['); }
+    void end_array() { close(']'); }
+
+    void key(std::string_view name);
+
+    void string(std::string_view value);
+    void number(double value);
+    void integer(int64_t value);
+    void uinteger(uint64_t value);
+    void boolean(bool value);
+    void null();
+
+    // Formatting primitives, for callers assembling fragments by hand
+    static void append_number(std::string& out, double value);
+    static void append_string(std::string& out, std::string_view value);
+
+private:
+    std::string& out_;
+    uint64_t has_items_ = 0;    // bit d: the container at depth d has an item
+    int depth_ = 0;
+    bool after_key_ = false;
+
+    void separate();
+    void open(char bracket);
+    void close(char bracket);
+};
+
+} // namespace http
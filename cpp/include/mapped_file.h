@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace quant {
+
+// Read-only memory mapping of a whole file. Pages are shared with every other
+// process mapping the same file and are faulted in on demand.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map `path`; on failure returns false and sets error
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    bool is_open() const { return fd_ >= 0; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+    // Hint that the mapping will be read front to back
+    void advise_sequential() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    int fd_ = -1;
+};
+
+} // namespace quant
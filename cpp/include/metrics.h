@@ -0,0 +1,216 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace metrics {
+
+// Counters and histograms are split into cache-line shards and each thread
+// updates its own, so recording is a few uncontended relaxed atomic adds
+constexpr size_t kShards = 8;
+
+namespace detail {
+    extern std::atomic<size_t> next_shard;
+}
+
+// Shard for the calling thread, assigned round-robin on first use
+inline size_t this_thread_shard() {
+    thread_local size_t shard = detail::next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shard;
+}
+
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+class Counter {
+public:
+    void inc(uint64_t n = 1) {
+        shards_[this_thread_shard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, kShards> shards_;
+};
+
+namespace detail {
+    // Timestamp counter for ScopedTimer: the TSC on x86 (invariant on any
+    // recent CPU, and about half the cost of steady_clock::now()),
+    // steady_clock nanoseconds elsewhere
+    inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // Measured once against steady_clock on first use
+    double calibrate_ns_per_tick();
+
+    inline double ns_per_tick() {
+        static const double value = calibrate_ns_per_tick();
+        return value;
+    }
+}
+
+// HDR-style latency histogram: exact below 16 units, then 8 log-linear
+// buckets per power of two (at most 12.5% relative error) up to 2^41 units.
+// Larger values land in the last bucket. The unit is nanoseconds, or raw
+// ticks() for timer histograms, which ScopedTimer fills without converting;
+// snapshots and the exposition convert to time.
+class Histogram {
+public:
+    enum class Unit { Nanoseconds, Ticks };
+
+    static constexpr size_t kSubBuckets = 8;
+    static constexpr size_t kMaxExponent = 40;
+    static constexpr size_t kBuckets = 16 + (kMaxExponent - 3) * kSubBuckets;
+
+    static size_t bucket_index(uint64_t value);
+    static uint64_t bucket_lower(size_t index);
+    static uint64_t bucket_upper(size_t index);    // exclusive
+
+    explicit Histogram(Unit unit = Unit::Nanoseconds) : unit_(unit) {}
+    Unit unit() const { return unit_; }
+    double ns_per_unit() const { return unit_ == Unit::Ticks ? detail::ns_per_tick() : 1.0; }
+
+    // `value` is in the histogram's unit
+    void record(uint64_t value) {
+        Shard& shard = shards_[this_thread_shard()];
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+        shard.buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    }
+    void record(std::chrono::nanoseconds elapsed) {
+        uint64_t nanos = elapsed.count() > 0 ? static_cast<uint64_t>(elapsed.count()) : 0;
+        record(unit_ == Unit::Ticks ? static_cast<uint64_t>(nanos / detail::ns_per_tick()) : nanos);
+    }
+
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t sum = 0;                           // nanoseconds
+        std::array<uint64_t, kBuckets> buckets{};   // in the histogram's unit
+        double ns_per_unit = 1.0;
+
+        uint64_t count_below(double nanos) const;   // values in buckets ending at or below nanos
+        double quantile(double q) const;            // nanoseconds, bucket midpoint; NAN if empty
+    };
+    Snapshot snapshot() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> sum{0};
+        std::array<std::atomic<uint64_t>, kBuckets> buckets{};
+    };
+    std::array<Shard, kShards> shards_;
+    Unit unit_;
+};
+
+inline size_t Histogram::bucket_index(uint64_t value) {
+    if (value < 16) return static_cast<size_t>(value);
+    size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(value));
+    if (exponent > kMaxExponent) return kBuckets - 1;
+    size_t sub = static_cast<size_t>(value >> (exponent - 3)) & (kSubBuckets - 1);
+    return 16 + (exponent - 4) * kSubBuckets + sub;
+}
+
+// Records the lifetime of the scope into a histogram: the raw tick delta
+// for timer histograms, nanoseconds otherwise. A timer constructed with
+// enabled = false records nothing and never reads the clock, for sampling
+// hot per-item scopes.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram, bool enabled = true)
+        : histogram_(enabled ? &histogram : nullptr), start_(enabled ? detail::ticks() : 0) {}
+    ~ScopedTimer() {
+        if (!histogram_) return;
+        uint64_t end = detail::ticks();
+        uint64_t elapsed = end > start_ ? end - start_ : 0;
+        if (histogram_->unit() == Histogram::Unit::Ticks) {
+            histogram_->record(elapsed);
+        } else {
+            histogram_->record(static_cast<uint64_t>(elapsed * detail::ns_per_tick()));
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram* histogram_;
+    uint64_t start_;
+};
+
+// True on every `every`th call through `calls` (a per-thread counter owned by
+// the call site), to pick which iterations of a hot loop get a ScopedTimer
+inline bool sample(uint32_t& calls, uint32_t every) {
+    if (++calls < every) return false;
+    calls = 0;
+    return true;
+}
+
+// Named metric families with label sets, exported in the Prometheus text
+// format. Registering the same name and labels again returns the existing
+// metric, so hot paths can look theirs up once into a static reference.
+// Metrics live as long as the registry.
+class Registry {
+public:
+    Counter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+    Histogram& histogram(const std::string& name, const std::string& help, const Labels& labels = {});
+    // A histogram in ticks for ScopedTimer; exported in seconds like the rest
+    Histogram& timer(const std::string& name, const std::string& help, const Labels& labels = {});
+
+    // Sampled at scrape time, for values another component already keeps.
+    // The callback must stay valid for the registry's lifetime.
+    void counter_fn(const std::string& name, const std::string& help, const Labels& labels,
+                    std::function<double()> sample);
+    void gauge_fn(const std::string& name, const std::string& help, const Labels& labels,
+                  std::function<double()> sample);
+
+    // Text exposition format 0.0.4. Histograms are reported in seconds, with
+    // `le` bounds on the bucket edges nearest a 1-2.5-5 ladder from 1us to 10s.
+    std::string expose() const;
+
+private:
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Series {
+        std::string labels;         // rendered, e.g. route="/api/signals"
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Histogram> histogram;
+        std::function<double()> sample;
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        Type type;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Family>> families_;
+
+    Series& series_locked(const std::string& name, const std::string& help, Type type, const Labels& labels);
+    Histogram& histogram_locked(const std::string& name, const std::string& help, const Labels& labels,
+                                Histogram::Unit unit);
+};
+
+// Process-wide registry served on /metrics
+Registry& registry();
+
+} // namespace metrics
@@ -0,0 +1,60 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace quant {
+
+// Number of workers to use for a requested thread count (0 = all cores)
+inline unsigned resolve_threads(unsigned requested) {
+    if (requested > 0) return requested;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Run fn(i) for every i in [0, n) on up to `threads` workers (0 = all cores).
+// Workers claim small batches of indices from a shared atomic counter, so
+// uneven per-item costs balance out across threads. The first exception
+// thrown by fn is rethrown on the calling thread after all workers stop.
+template <class F>
+void parallel_for(size_t n, unsigned threads, F&& fn, size_t grain = 1) {
+    if (n == 0) return;
+    size_t workers = std::min<size_t>(resolve_threads(threads), n);
+    if (workers == 1) {
+        for (size_t i = 0; i < n; ++i) fn(i);
+        return;
+    }
+
+    grain = std::max<size_t>(1, grain);
+    std::atomic<size_t> next{0};
+    std::exception_ptr failure;
+    std::mutex failure_mutex;
+
+    auto work = [&]() {
+        try {
+            for (;;) {
+                size_t begin = next.fetch_add(grain, std::memory_order_relaxed);
+                if (begin >= n) break;
+                size_t end = std::min(n, begin + grain);
+                for (size_t i = begin; i < end; ++i) fn(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failure_mutex);
+            if (!failure) failure = std::current_exception();
+            next.store(n, std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (size_t t = 1; t < workers; ++t) pool.emplace_back(work);
+    work();
+    for (auto& th : pool) th.join();
+
+    if (failure) std::rethrow_exception(failure);
+}
+
+} // namespace quant
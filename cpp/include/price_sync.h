@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bar_cache.h"
+#include "price_store.h"
+
+namespace store {
+
+struct IngestReport {
+    size_t symbols = 0;
+    size_t records_written = 0;
+    std::vector<std::string> failed;    // "SYMBOL: error"
+};
+
+// Keeps the price store current and serves bars from it. Symbols with no
+// stored history (or a gap longer than a compact response covers) are
+// fetched in full; everything else is topped up with the compact series.
+// fetch/fetch_many match BarCache's upstream signatures, so the cache and
+// the signal service read local storage and only go upstream for top-ups.
+// A failed sync is remembered for a short while (kFailureRetry, at most
+// max_age) so a bad symbol does not go upstream on every lookup.
+class PriceSync {
+public:
+    static constexpr std::chrono::seconds kFailureRetry{60};
+
+    // Bars served from storage are considered current for max_age after the
+    // symbol was last synced
+    PriceSync(PriceStore& store, const alphavantage::Client& client, std::chrono::seconds max_age);
+    PriceSync(PriceStore& store, alphavantage::BarCache::FetchFn fetch, std::chrono::seconds max_age,
+              alphavantage::BarCache::BatchFetchFn batch_fetch = nullptr);
+
+    alphavantage::FetchResult fetch(const std::string& symbol, const std::string& outputsize);
+    // on_done runs for current symbols first, then for each stale one as
+    // soon as its sync finishes
+    void fetch_many(const std::vector<std::string>& symbols, const std::string& outputsize,
+                    const alphavantage::Client::BatchCallback& on_done,
+                    alphavantage::Priority priority = alphavantage::Priority::Bulk);
+
+    // Stored bars only, never going upstream
+    alphavantage::FetchResult stored(const std::string& symbol, const std::string& outputsize);
+
+    // Sync every symbol now, regardless of age
+    IngestReport ingest(const std::vector<std::string>& symbols);
+
+    // "full" when there is no stored history or the newest stored bar is too
+    // old for a compact (100 trading day) response to close the gap
+    static std::string upstream_outputsize(int32_t last_date, int32_t today);
+
+    PriceStore& store() { return store_; }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    PriceStore& store_;
+    alphavantage::BarCache::FetchFn fetch_;
+    alphavantage::BarCache::BatchFetchFn batch_fetch_;
+    std::chrono::seconds max_age_;
+
+    struct SyncState {
+        clock::time_point at;
+        std::string error;      // empty after a successful sync
+    };
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, SyncState> synced_;
+    // Symbols being synced now, and the error their sync finishes with
+    std::unordered_map<std::string, std::shared_future<std::string>> syncing_;
+
+    // True if `symbol` synced within max_age or failed within the retry
+    // delay; `error` gets that recent failure
+    bool recent(const std::string& symbol, std::string& error);
+    // Fetch and upsert `symbols`, calling on_synced(index, error) as each
+    // finishes (empty error = ok). A symbol already being synced by another
+    // caller is not fetched again; its result is reported once that sync ends.
+    using SyncedFn = std::function<void(size_t index, const std::string& error)>;
+    void sync(const std::vector<std::string>& symbols, size_t* written, alphavantage::Priority priority,
+              const SyncedFn& on_synced);
+    alphavantage::FetchResult load(const std::string& symbol, const std::string& outputsize,
+                                   const std::string& sync_error);
+};
+
+} // namespace store
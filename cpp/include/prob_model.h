@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "bar_series.h"
+
+namespace model {
+
+// Per-bar features, each computed from closes up to and including that bar.
+// All fit in the 100-bar compact series the signal service reads.
+enum Feature : size_t {
+    kMa50Gap,       // close / SMA50 - 1
+    kEma20Gap,      // close / EMA20 - 1
+    kMa5Ma20Gap,    // SMA5 / SMA20 - 1
+    kSlope20,       // slope of log close over the last 20 bars
+    kRv20,          // sample stddev of the last 20 daily returns
+    kReturn20,      // close / close 20 bars ago - 1
+    kFeatureCount
+};
+
+extern const std::array<const char*, kFeatureCount> kFeatureNames;
+
+// Bars needed before the first complete feature row
+constexpr size_t kMinHistory = 50;
+
+// Struct-of-arrays feature matrix: kFeatureCount contiguous columns of
+// `rows` values, so scoring and training run as straight column loops.
+// Scoring builds it in a request arena; training uses the heap.
+struct FeatureMatrix {
+    size_t rows = 0;
+    std::pmr::vector<double> values;
+
+    FeatureMatrix() = default;
+    explicit FeatureMatrix(std::pmr::memory_resource* memory) : values(memory) {}
+
+    void resize(size_t n) { rows = n; values.assign(n * kFeatureCount, NAN); }
+    double* column(size_t j) { return values.data() + j * rows; }
+    const double* column(size_t j) const { return values.data() + j * rows; }
+    double at(size_t row, size_t j) const { return values[j * rows + row]; }
+};
+
+// Features for every bar of `close` (oldest first), written as kFeatureCount
+// columns of `stride` values starting at `out`. Bars before kMinHistory - 1
+// get NAN.
+void feature_series(quant::Span<const double> close, double* out, size_t stride);
+
+// Features of the last bar into row `row` of `x`; false (row left NAN) if
+// the history is shorter than kMinHistory
+bool latest_features(quant::Span<const double> close, FeatureMatrix& x, size_t row);
+
+// Labelled rows for training: features at each bar and whether the forward
+// `horizon`-bar return was positive
+struct TrainingSet {
+    FeatureMatrix x;
+    std::vector<double> y;          // 1 = up, 0 = not up
+    std::vector<int32_t> date;
+
+    // Rows dated before `cutoff` and the rest
+    std::pair<TrainingSet, TrainingSet> split(int32_t cutoff) const;
+};
+
+// Built in parallel across symbols (threads 0 = all cores)
+TrainingSet build_training_set(const std::vector<quant::BarView>& universe, int horizon, unsigned threads = 0);
+
+// Logistic regression on raw features: p = 1 / (1 + exp(-(intercept + w.x)))
+struct ProbModel {
+    std::string version;
+    int horizon = 20;
+    std::array<double, kFeatureCount> weights{};
+    double intercept = 0.0;
+    size_t trained_rows = 0;
+
+    double predict(const FeatureMatrix& x, size_t row) const;
+    // One pass over the whole matrix into x.rows values at `out`; rows with
+    // missing features give NAN
+    void predict(const FeatureMatrix& x, double* out) const;
+    void predict(const FeatureMatrix& x, std::vector<double>& out) const;
+
+    std::string to_json() const;
+    static bool from_json(std::string_view text, ProbModel& out, std::string& error);
+
+    bool save(const std::string& path, std::string& error) const;
+    static bool load(const std::string& path, ProbModel& out, std::string& error);
+};
+
+struct TrainOptions {
+    double l2 = 1e-4;               // ridge penalty on standardized weights
+    int max_iterations = 50;
+    double tolerance = 1e-8;        // stop when no coefficient moves more than this
+    unsigned threads = 0;           // 0 = all cores
+};
+
+struct TrainResult {
+    ProbModel model;
+    int iterations = 0;
+    bool converged = false;
+    double log_loss = NAN;          // mean, on the training rows
+    std::string error;              // empty if no error
+
+    bool ok() const { return error.empty(); }
+};
+
+// Fit by IRLS (Newton's method). Features are standardized for the fit and
+// the scaling folded back into the weights, so inference stays a plain dot
+// product. Each iteration is one pass over the rows, split across threads
+// in fixed chunks and reduced in order, so results do not depend on the
+// thread count.
+TrainResult train(FeatureMatrix x, const std::vector<double>& y, const TrainOptions& options = {});
+
+// Area under the ROC curve (ties count half)
+double auc(const std::vector<double>& scores, const std::vector<double>& labels);
+
+// Mean negative log-likelihood of probabilities against 0/1 labels
+double log_loss(const std::vector<double>& probs, const std::vector<double>& labels);
+
+} // namespace model
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace quant {
+
+// Maps a float onto an unsigned key with the same ordering
+inline uint32_t order_key(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+// Average 0-based ranks (ties share the mean rank) of n values into `ranks`.
+// Sorts packed (key, index) integers, radix sorted once n is in the
+// hundreds, which is several times faster than an indirect sort; `sorted`
+// (n entries) is left in ascending value order with the original index in
+// the low 32 bits. Scratch comes from the thread's arena.
+void rank(const float* values, size_t n, uint64_t* sorted, double* ranks);
+
+} // namespace quant
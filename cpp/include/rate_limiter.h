@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+
+namespace alphavantage {
+
+// Interactive requests (a user waiting on one symbol) are served before bulk
+// work (ingest, background refresh) whenever both are waiting for a token.
+enum class Priority { Interactive = 0, Bulk = 1 };
+
+struct RateLimits {
+    int per_minute = 0;     // 0 = unlimited
+    int per_day = 0;        // 0 = unlimited
+};
+
+// Token buckets for the upstream per-minute and per-day quotas. The minute
+// bucket refills continuously (per_minute tokens per 60s, burst up to
+// per_minute); the day bucket is a fixed 24h window from the first request.
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit RateLimiter(RateLimits limits);
+
+    // Block until a request may be sent. Returns false without waiting once
+    // the daily quota is spent.
+    bool acquire(Priority priority);
+
+    // Take a token if one is free now and no higher-priority caller is
+    // waiting. Returns zero on success, the time to wait before trying again
+    // otherwise, or nullopt once the daily quota is spent. An Interactive
+    // caller that is told to wait holds off Bulk callers until it retries.
+    std::optional<Clock::duration> try_acquire(Priority priority);
+
+    // The server rejected a request: empty the minute bucket so callers slow
+    // down instead of burning the rest of the quota on rejections
+    void on_rate_limited();
+
+    // The server reported its daily quota spent: refuse every request until
+    // the next UTC midnight, when the upstream quota resets
+    void on_quota_exhausted();
+
+    const RateLimits& limits() const { return limits_; }
+    int used_today() const;
+    // Callers of `priority` currently blocked in acquire()
+    int waiting(Priority priority) const;
+
+private:
+    RateLimits limits_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    double tokens_;
+    Clock::time_point last_refill_;
+    int day_used_ = 0;
+    Clock::time_point day_start_;
+    Clock::time_point exhausted_until_ = Clock::time_point::min();
+    int waiting_[2] = {0, 0};
+    // Interactive try_acquire callers due back by then, counted as waiting
+    Clock::time_point interactive_claim_until_ = Clock::time_point::min();
+
+    void refill_locked(Clock::time_point now);
+    bool day_exhausted_locked(Clock::time_point now);
+    // Zero if a token can be taken now by `priority`, else time to wait
+    Clock::duration wait_locked(Priority priority, Clock::time_point now);
+};
+
+} // namespace alphavantage
@@ -0,0 +1,192 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace quant {
+
+// Streaming counterparts of the batch indicators in indicators.h. Each push()
+// is O(1) and value() after pushing a series matches the batch function over
+// the same series. snapshot()/restore() capture and reinstate the full state,
+// e.g. to persist indicators across restarts or rewind a replay.
+
+// Fixed-size window of the most recent values
+class RingWindow {
+public:
+    explicit RingWindow(int capacity = 0);
+
+    void push(double x);                 // overwrites the oldest value when full
+    bool full() const { return count_ == values_.size() && !values_.empty(); }
+    size_t size() const { return count_; }
+    size_t capacity() const { return values_.size(); }
+    double oldest() const;               // value that the next push() evicts
+    double sum() const;                  // exact sum of the stored values
+    double sum_sq_dev(double mean) const; // sum of squared deviations from mean
+
+    std::vector<double> values() const;  // oldest first
+    void assign(const std::vector<double>& values);
+
+private:
+    std::vector<double> values_;
+    size_t head_ = 0;                    // index of the oldest value
+    size_t count_ = 0;
+};
+
+// Simple moving average of the last `period` values; matches quant::sma
+class RollingSMA {
+public:
+    struct State {
+        int period = 0;
+        std::vector<double> window;      // oldest first
+    };
+
+    explicit RollingSMA(int period);
+
+    void push(double x);
+    bool ready() const;
+    double value() const;                // NAN until `period` values were pushed
+
+    State snapshot() const;
+    void restore(const State& state);
+
+private:
+    int period_;
+    RingWindow window_;
+    double sum_ = 0.0;
+    size_t since_resum_ = 0;
+};
+
+// EMA seeded with the SMA of the first `period` values; matches quant::ema
+class RollingEMA {
+public:
+    struct State {
+        int period = 0;
+        long count = 0;
+        double value = 0.0;              // running seed sum until count == period
+    };
+
+    explicit RollingEMA(int period);
+
+    void push(double x);
+    bool ready() const { return period_ > 0 && count_ >= period_; }
+    double value() const;
+
+    State snapshot() const;
+    void restore(const State& state);
+
+private:
+    int period_;
+    long count_ = 0;
+    double value_ = 0.0;
+};
+
+// Wilder-smoothed RSI; matches quant::rsi_wilder
+class RollingRSI {
+public:
+    struct State {
+        int period = 0;
+        long count = 0;                  // closes pushed
+        double prev_close = 0.0;
+        double avg_gain = 0.0;           // running sums until the seed completes
+        double avg_loss = 0.0;
+    };
+
+    explicit RollingRSI(int period);
+
+    void push(double close);
+    bool ready() const { return period_ > 0 && count_ > period_; }
+    double value() const;
+
+    State snapshot() const;
+    void restore(const State& state);
+
+private:
+    int period_;
+    long count_ = 0;
+    double prev_close_ = 0.0;
+    double avg_gain_ = 0.0;
+    double avg_loss_ = 0.0;
+};
+
+// Average true range as a simple average of the last `period` true ranges; matches quant::atr
+class RollingATR {
+public:
+    struct State {
+        bool has_prev = false;
+        double prev_close = 0.0;
+        RollingSMA::State true_ranges;
+    };
+
+    explicit RollingATR(int period);
+
+    void push(double high, double low, double close);
+    bool ready() const { return tr_.ready(); }
+    double value() const { return tr_.value(); }
+
+    State snapshot() const;
+    void restore(const State& state);
+
+private:
+    bool has_prev_ = false;
+    double prev_close_ = 0.0;
+    RollingSMA tr_;
+};
+
+// Welford mean/variance, over everything pushed (window 0) or the last
+// `window` values. stddev() matches quant::realized_vol over the same values.
+class RollingVariance {
+public:
+    struct State {
+        int window = 0;
+        long count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+        std::vector<double> values;      // only kept for windowed instances
+    };
+
+    explicit RollingVariance(int window = 0);
+
+    void push(double x);
+    long count() const { return count_; }
+    double mean() const;
+    double variance() const;             // sample variance (n - 1)
+    double stddev() const;
+
+    State snapshot() const;
+    void restore(const State& state);
+
+private:
+    int window_;
+    long count_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    RingWindow values_;
+    long since_recompute_ = 0;
+
+    void recompute();
+};
+
+// Running peak-to-trough drawdown; matches quant::max_drawdown
+class RollingMaxDrawdown {
+public:
+    struct State {
+        bool started = false;
+        double peak = 0.0;
+        double max_drawdown = 0.0;
+        double last = 0.0;
+    };
+
+    void push(double price);
+    double value() const { return max_drawdown_; }
+    double current_drawdown() const;
+
+    State snapshot() const;
+    void restore(const State& state);
+
+private:
+    bool started_ = false;
+    double peak_ = 0.0;
+    double max_drawdown_ = 0.0;
+    double last_ = 0.0;
+};
+
+} // namespace quant
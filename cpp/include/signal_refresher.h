@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "http_cache.h"
+#include "signals.h"
+#include "universe.h"
+
+namespace signals {
+
+// Immutable result of one refresh of the universe. Handlers share it by
+// shared_ptr and never see it change underneath them.
+struct SignalSnapshot {
+    uint64_t version = 0;
+    std::string as_of;
+    std::vector<Signal> signals;
+    http::CachedBody body;                              // to_json(signals, as_of), ETag + precompressed
+    std::chrono::system_clock::time_point computed_at;
+    std::chrono::milliseconds refresh_duration{0};
+};
+
+// Recomputes signals for a fixed universe (and any added ones) on a
+// background thread and publishes each result as a new snapshot with an
+// atomic pointer swap, so readers never wait on upstream fetches or on each
+// other.
+class SignalRefresher {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Snapshot = std::shared_ptr<const SignalSnapshot>;
+    using PublishFn = std::function<void(const Snapshot& snapshot)>;
+
+    // Refreshes run every `interval`. A refresh that hits the upstream rate
+    // limit doubles the wait (up to 8x interval) until one comes back clean.
+    SignalRefresher(SignalService& service, std::vector<std::string> symbols,
+                    std::chrono::seconds interval);
+    ~SignalRefresher();
+
+    SignalRefresher(const SignalRefresher&) = delete;
+    SignalRefresher& operator=(const SignalRefresher&) = delete;
+
+    // Called on the refreshing thread after each snapshot is published.
+    // Register before start().
+    void on_publish(PublishFn fn) { on_publish_ = std::move(fn); }
+
+    // Also refresh `universe` every round, from the same batch of fetches,
+    // and serve it from current(name). Add before start().
+    void add_universe(Universe universe) { universes_.push_back(std::move(universe)); }
+
+    // Start the background thread; the first refresh runs immediately
+    void start();
+    void stop();
+
+    // Compute and publish a snapshot on the calling thread
+    void refresh_now();
+
+    // Seconds until the current snapshot is due to be replaced (0 if overdue)
+    long seconds_until_refresh() const;
+
+    // Latest snapshot, or null before the first refresh completes
+    Snapshot current() const { return std::atomic_load(&snapshot_); }
+    // Latest snapshot of an added universe (by case-insensitive name), or
+    // null if no such universe was added or it is not refreshed yet
+    Snapshot current(std::string_view universe) const;
+    // Latest snapshots of the default and every added universe, skipping
+    // those not refreshed yet
+    std::vector<Snapshot> snapshots() const;
+
+    const std::vector<std::string>& symbols() const { return symbols_; }
+
+    // UTC date snapshots are stamped with, YYYY-MM-DD. The dashboard sends
+    // ?date= as a UTC ISO date too, so "today" never misses the snapshot.
+    static std::string today();
+    std::chrono::seconds interval() const { return interval_; }
+
+private:
+    using Snapshots = std::shared_ptr<const std::vector<Snapshot>>;
+
+    SignalService& service_;
+    std::vector<std::string> symbols_;
+    std::vector<Universe> universes_;
+    std::chrono::seconds interval_;
+
+    Snapshot snapshot_;             // read and written with std::atomic_load/store
+    Snapshots universe_snapshots_;  // parallel to universes_, also atomic
+    std::mutex refresh_mutex_;      // serializes refresh_now callers
+    PublishFn on_publish_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread worker_;
+
+    // Returns true if any symbol was rejected by the upstream rate limit
+    bool refresh();
+    void run();
+};
+
+} // namespace signals
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "signal_refresher.h"
+
+namespace signals {
+
+// Fans signal snapshots out to streaming subscribers as diffs.
+//
+// Each published snapshot is compared with the previous one once, per
+// symbol, and only changed signals are sent. Subscribers are flushed at most
+// once per min_interval; updates that arrive in between are coalesced, so a
+// slow client receives the latest value of every symbol that changed rather
+// than a growing backlog. A client in step with the stream gets the shared
+// pre-serialized diff, so the cost of an update does not grow with the
+// number of open dashboards.
+//
+// The transport queues what it is handed without limit, so subscribers
+// acknowledge what they have processed with ack(). A subscriber holding
+// more than max_queued_bytes unacknowledged gets nothing new; its updates
+// are coalesced into one diff once it acknowledges.
+//
+// Messages:
+//   {"type":"snapshot","version":V,"as_of":"...","signals":[...]}   on subscribe
+//   {"type":"diff","version":V,"as_of":"...","signals":[...]}       changed only
+class SignalStream {
+public:
+    using Clock = std::chrono::steady_clock;
+    // Must not block; called outside the stream's state lock, one message at
+    // a time and in order
+    using SendFn = std::function<void(const std::string& message)>;
+
+    explicit SignalStream(std::chrono::milliseconds min_interval = std::chrono::milliseconds(250),
+                          size_t max_queued_bytes = size_t(1) << 20);
+    ~SignalStream();
+
+    SignalStream(const SignalStream&) = delete;
+    SignalStream& operator=(const SignalStream&) = delete;
+
+    // Register a subscriber and send it the current snapshot
+    uint64_t subscribe(SendFn send);
+    void unsubscribe(uint64_t id);
+
+    // Restrict a subscriber to these symbols (empty = all) and resend its snapshot
+    void set_filter(uint64_t id, const std::vector<std::string>& symbols);
+
+    // The subscriber has processed every message up to `version`
+    void ack(uint64_t id, uint64_t version);
+    // Bytes sent to a subscriber and not yet acknowledged
+    size_t queued_bytes(uint64_t id) const;
+
+    // Diff a new snapshot against the last one and queue changed signals
+    void publish(const SignalRefresher::Snapshot& snapshot);
+
+    // Send queued updates to every subscriber whose interval has elapsed
+    void flush();
+
+    // Flush on a background thread after each publish
+    void start();
+    void stop();
+
+    size_t subscribers() const;
+    uint64_t version() const;
+
+private:
+    struct Fragment {
+        std::string json;           // serialized signal_to_json
+        uint64_t changed_in = 0;    // stream version that last changed it
+    };
+
+    struct Subscriber {
+        SendFn send;
+        uint64_t sent_version = 0;
+        std::unordered_set<std::string> filter;
+        Clock::time_point last_send;
+        std::deque<std::pair<uint64_t, size_t>> unacked;    // (version, bytes) per message sent
+        size_t queued_bytes = 0;
+    };
+
+    using Message = std::shared_ptr<const std::string>;
+    struct Outgoing {
+        SendFn send;
+        Message message;
+    };
+
+    std::chrono::milliseconds min_interval_;
+    size_t max_queued_bytes_;
+
+    // Held while messages are handed to the transport, so each subscriber
+    // sees them in order; taken before mutex_, never after
+    std::mutex send_mutex_;
+    mutable std::mutex mutex_;
+    uint64_t version_ = 0;
+    std::string as_of_;
+    std::vector<std::string> order_;                    // symbols in snapshot order
+    std::unordered_map<std::string, Fragment> fragments_;
+    Message last_diff_;                                 // message for version_ - 1 -> version_
+    std::unordered_map<uint64_t, Subscriber> subscribers_;
+    uint64_t next_id_ = 1;
+
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    bool pending_ = false;
+    std::thread pump_;
+
+    // Message with every fragment visible to `sub` that changed after `since`
+    Message build_message_locked(const char* type, const Subscriber& sub, uint64_t since) const;
+    // Account `message` against `sub` and add it to `out` for sending
+    void queue_locked(Subscriber& sub, Message message, std::vector<Outgoing>& out);
+    static void deliver(const std::vector<Outgoing>& out);
+    void run();
+};
+
+} // namespace signals
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <nlohmann/json.hpp>
 #include "alphavantage.h"
+#include "bar_cache.h"
+#include "prob_model.h"
 
 namespace signals {
 
@@ -18,30 +26,135 @@ struct Signal {
     double ma20;
     int data_points;
     std::string error;          // empty if no error
+    std::string stale_as_of;    // set when carried over from an earlier refresh: that refresh's date
+};
+
+// The fields the cross-section ranks, as columns parallel to a signal
+// vector. The service fills them as it computes each signal, so ranking
+// reads contiguous columns instead of gathering from the Signal structs.
+struct SignalColumns {
+    std::vector<double> monthly_return;
+    std::vector<double> volatility;
+    std::vector<uint8_t> valid;         // 1 = the signal has no error
+
+    void resize(size_t n);
+    void set(size_t row, const Signal& signal);
+    static SignalColumns of(const std::vector<Signal>& signals);
+};
+
+// Bars a signal reads: the length of AlphaVantage's compact series, so
+// as-of signals look at the same window the live ones do
+constexpr size_t kSignalWindow = 100;
+
+struct MemoStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t entries = 0;
 };
 
 class SignalService {
 public:
-    explicit SignalService(alphavantage::Client& client);
+    // Bars are read through the cache so repeated requests skip the upstream fetch
+    explicit SignalService(alphavantage::BarCache& cache);
+
+    // Score prob_up with a trained model instead of the trend lookup table.
+    // Set before serving requests; null restores the lookup table.
+    void set_model(std::shared_ptr<const model::ProbModel> model);
+    const model::ProbModel* model() const { return model_.get(); }
 
-    // Compute signals for a list of symbols
-    std::vector<Signal> compute_signals(const std::vector<std::string>& symbols);
+    // Compute signals for a list of symbols. Cold symbols are fetched
+    // concurrently at `priority` and each signal is computed as soon as its
+    // bars arrive; with a model, prob_up is then scored for all of them in
+    // one pass.
+    std::vector<Signal> compute_signals(const std::vector<std::string>& symbols,
+                                        alphavantage::Priority priority = alphavantage::Priority::Bulk);
+    // Also fills `columns` for write_json
+    std::vector<Signal> compute_signals(const std::vector<std::string>& symbols, SignalColumns* columns,
+                                        alphavantage::Priority priority = alphavantage::Priority::Bulk);
 
     // Compute signal for a single symbol
     Signal compute_signal(const std::string& symbol);
 
-    // Convert signals to JSON
+    // Signals as of the close of `as_of` (days since 1970-01-01), from the
+    // full history already cached or in local storage (never upstream;
+    // otherwise the error is BarCache::kNotCached): a binary search finds
+    // the day and the signal is computed over the kSignalWindow bars up to
+    // it. Results are memoized per (symbol, day) until the history is reread.
+    std::vector<Signal> compute_signals(const std::vector<std::string>& symbols, int32_t as_of,
+                                        SignalColumns* columns = nullptr);
+    Signal compute_signal(const std::string& symbol, int32_t as_of);
+
+    // Streaming forms of compute_signals: on_signal gets each symbol's index
+    // and signal, model-scored, as soon as it is computed (cache hits first,
+    // then fetches as they land). It runs on the calling thread. These serve
+    // requests, so live fetches queue at Interactive priority, and at most
+    // `max_fetches` symbols not already cached go upstream; the rest get an
+    // error starting with kNotFetched.
+    using SignalFn = std::function<void(size_t index, const Signal& signal)>;
+    static constexpr const char* kNotFetched = "Not fetched";
+    void stream_signals(const std::vector<std::string>& symbols, const SignalFn& on_signal,
+                        size_t max_fetches = SIZE_MAX);
+    void stream_signals(const std::vector<std::string>& symbols, int32_t as_of, const SignalFn& on_signal);
+
+    MemoStats memo_stats() const;
+
+    // Convert signals to JSON, ranked using `columns` (gathered from the
+    // signals when not given)
     static nlohmann::json to_json(const std::vector<Signal>& signals, const std::string& as_of);
+    static nlohmann::json to_json(const std::vector<Signal>& signals, const SignalColumns& columns,
+                                  const std::string& as_of);
     static nlohmann::json signal_to_json(const Signal& signal);
 
+    // Append the same documents, byte for byte as dump() prints them,
+    // without building a json tree
+    static void write_json(std::string& out, const std::vector<Signal>& signals, const std::string& as_of);
+    static void write_json(std::string& out, const std::vector<Signal>& signals, const SignalColumns& columns,
+                           const std::string& as_of);
+    static void write_signal_json(std::string& out, const Signal& signal);
+
+    // Trend rule: price against MA5/MA20 and the monthly return (percent)
+    static std::string determine_trend(double price, double ma5, double ma20, double monthly_return);
+
+    // Probability of an upward move implied by a trend and monthly return
+    static double calculate_prob_up(const std::string& trend, double monthly_return);
+
 private:
-    alphavantage::Client& client_;
+    // Memoized as-of signal, kept in least-recently-used order
+    struct MemoEntry {
+        std::string key;
+        std::weak_ptr<const quant::BarSeries> source;  // history the signal was computed from
+        Signal signal;
+    };
+
+    static constexpr size_t kMemoCapacity = 100000;
+
+    alphavantage::BarCache& cache_;
+    std::shared_ptr<const model::ProbModel> model_;
+
+    mutable std::mutex memo_mutex_;
+    std::list<MemoEntry> memo_order_;   // most recent first
+    std::unordered_map<std::string, std::list<MemoEntry>::iterator> memo_;
+    uint64_t memo_hits_ = 0;
+    uint64_t memo_misses_ = 0;
+
+    // Build a signal from already-fetched bars (`error` explains an empty
+    // view); with a model, also writes the latest features into row `row`
+    // of `features`
+    Signal signal_from_bars(const std::string& symbol, quant::BarView bars, const std::string& error,
+                            model::FeatureMatrix* features = nullptr, size_t row = 0);
 
-    // Determine trend based on price action and moving averages
-    std::string determine_trend(double price, double ma5, double ma20, double monthly_return);
+    static std::string memo_key(const std::string& symbol, int32_t as_of);
+    // As-of signal from `cached` history: true if it came from the memo
+    // (already scored), otherwise computed unscored with its features in
+    // row `row`
+    bool as_of_signal(const std::string& symbol, int32_t as_of, const alphavantage::BarCache::Result& cached,
+                      model::FeatureMatrix* features, size_t row, Signal& out);
+    bool memo_find(const std::string& key, const alphavantage::BarCache::Bars& source, Signal& out);
+    void memo_store(const std::string& key, const alphavantage::BarCache::Bars& source, const Signal& signal);
 
-    // Calculate probability of upward movement
-    double calculate_prob_up(const std::string& trend, double monthly_return);
+    // Replace prob_up with the model's score wherever features are complete
+    void apply_model(std::vector<Signal>& signals, const model::FeatureMatrix& features) const;
+    void apply_model(Signal& signal, const model::FeatureMatrix& features, size_t row) const;
 };
 
 } // namespace signals
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+
+namespace quant {
+namespace simd {
+
+// Hot reductions used by the indicator kernels. On x86-64 these dispatch at
+// runtime to AVX2 when the CPU supports it and fall back to a portable
+// scalar loop otherwise. Results may differ from a naive left-to-right sum
+// in the last few ulps because the summation order differs.
+
+double sum(const double* data, size_t n);
+double sum_sq_dev(const double* data, size_t n, double mean);  // sum of (x - mean)^2
+
+// True when the AVX2 kernels are in use
+bool avx2_enabled();
+
+} // namespace simd
+} // namespace quant
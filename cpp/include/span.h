@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace quant {
+
+// Non-owning view of contiguous values (std::span arrives with C++20).
+// Vectors convert implicitly, so APIs taking Span<const double> accept a
+// std::vector<double>, a BarSeries column or a mapped BarStore column alike.
+template <class T>
+class Span {
+public:
+    using value_type = std::remove_const_t<T>;
+
+    constexpr Span() = default;
+    constexpr Span(T* data, size_t size) : data_(data), size_(size) {}
+    Span(const std::vector<value_type>& v) : data_(v.data()), size_(v.size()) {}
+
+    constexpr T* data() const { return data_; }
+    constexpr size_t size() const { return size_; }
+    constexpr bool empty() const { return size_ == 0; }
+
+    constexpr T& operator[](size_t i) const { return data_[i]; }
+    constexpr T& front() const { return data_[0]; }
+    constexpr T& back() const { return data_[size_ - 1]; }
+    constexpr T* begin() const { return data_; }
+    constexpr T* end() const { return data_ + size_; }
+
+    // The first `n` values (n <= size)
+    constexpr Span first(size_t n) const { return Span(data_, n); }
+    // The last `n` values (n <= size)
+    constexpr Span last(size_t n) const { return Span(data_ + size_ - n, n); }
+    constexpr Span subspan(size_t offset, size_t n) const { return Span(data_ + offset, n); }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace quant
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace signals {
+
+// Named list of symbols that /api/signals can be evaluated over
+struct Universe {
+    std::string name;
+    std::vector<std::string> symbols;
+};
+
+// Universe served by the background refresher, built from STOCK_SYMBOLS
+constexpr const char* kDefaultUniverse = "DEFAULT";
+
+// Symbols from a universe file: separated by commas or whitespace, '#'
+// starts a comment. Symbols are upper-cased and duplicates dropped, keeping
+// the first occurrence.
+std::vector<std::string> parse_universe(std::string_view text);
+
+// Symbols from a request: trimmed and upper-cased, with empty entries and
+// duplicates dropped (first occurrence kept). An entry longer than
+// kMaxSymbolLength or with characters other than letters, digits and
+// ".-^=" is an error.
+constexpr size_t kMaxSymbolLength = 16;
+bool normalize_symbols(const std::vector<std::string>& raw, std::vector<std::string>& out, std::string& error);
+
+// Appends one universe per <NAME>.txt file in `dir`, named after the file
+// (upper-cased), in file name order. Empty files are skipped. A missing
+// directory loads nothing; an unreadable one, a file that cannot be read or a
+// name already in `out` is an error, and then `out` is left unchanged.
+bool load_universes(const std::string& dir, std::vector<Universe>& out, std::string& error);
+
+// Case-insensitive lookup; null if no universe has that name
+const Universe* find_universe(const std::vector<Universe>& universes, std::string_view name);
+
+} // namespace signals
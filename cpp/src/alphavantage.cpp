@@ -1,7 +1,16 @@
 #include "alphavantage.h"
+#include "dates.h"
+#include "metrics.h"
 #include <curl/curl.h>
 #include <sstream>
 #include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <mutex>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <thread>
 
 namespace alphavantage {
 
@@ -11,135 +20,616 @@ namespace {
         userp->append(static_cast<char*>(contents), total_size);
         return total_size;
     }
+
+    std::once_flag curl_init_flag;
+
+    // Owning curl handles, so a callback that throws cannot leak transfers
+    struct EasyCleanup {
+        void operator()(CURL* curl) const { curl_easy_cleanup(curl); }
+    };
+    struct MultiCleanup {
+        void operator()(CURLM* multi) const { curl_multi_cleanup(multi); }
+    };
+    using EasyHandle = std::unique_ptr<CURL, EasyCleanup>;
+    using MultiHandle = std::unique_ptr<CURLM, MultiCleanup>;
+
+    constexpr const char* kQuotaExhausted = "Daily request quota exhausted";
+
+    // Rough size of one pretty-printed daily bar, used to presize columns
+    constexpr size_t kBytesPerBar = 200;
+
+    template <class T>
+    bool parse_number(std::string_view s, T& out) {
+        auto res = std::from_chars(s.data(), s.data() + s.size(), out);
+        return res.ec == std::errc() && res.ptr == s.data() + s.size();
+    }
+
+    void append_utf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    // Single-pass parser for daily time series bodies. It walks the text once,
+    // hands out strings as views into the body (escapes are decoded into a
+    // scratch buffer) and converts prices with from_chars as they are read,
+    // so no DOM nodes or per-field strings are built.
+    class DailySeriesParser {
+    public:
+        DailySeriesParser(std::string_view text, quant::BarSeries& out)
+            : p_(text.data()), end_(text.data() + text.size()), out_(out) {}
+
+        std::string error;          // syntax or data error
+        std::string api_error;      // "Error Message"
+        std::string note;           // "Note" (rate limit)
+        std::string information;    // "Information" (quota or plan notices)
+        bool has_series = false;
+
+        bool parse() {
+            if (!parse_object(0, [this](std::string_view key) { return root_member(key); })) return false;
+            skip_ws();
+            return p_ == end_ || fail("trailing characters after JSON value");
+        }
+
+    private:
+        static constexpr int kMaxDepth = 64;
+        enum : unsigned { kOpen = 1, kHigh = 2, kLow = 4, kClose = 8, kAdjClose = 16, kRequired = 15 };
+
+        const char* p_;
+        const char* end_;
+        quant::BarSeries& out_;
+        std::string scratch_;
+
+        bool fail(std::string message) {
+            if (error.empty()) error = "JSON parse error: " + std::move(message);
+            return false;
+        }
+
+        void skip_ws() {
+            while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) ++p_;
+        }
+
+        bool consume(char c) {
+            skip_ws();
+            if (p_ < end_ && *p_ == c) { ++p_; return true; }
+            return false;
+        }
+
+        // Reads a string token. The view points into the body, or into
+        // scratch_ when the string had escapes, so use it before the next read.
+        bool read_string(std::string_view& out) {
+            if (!consume('"')) return fail("expected string");
+            const char* start = p_;
+            while (p_ < end_ && *p_ != '"' && *p_ != '\\') ++p_;
+            if (p_ < end_ && *p_ == '"') {
+                out = std::string_view(start, p_ - start);
+                ++p_;
+                return true;
+            }
+            scratch_.assign(start, p_);
+            while (p_ < end_ && *p_ != '"') {
+                if (*p_ != '\\') { scratch_ += *p_++; continue; }
+                if (++p_ == end_) break;
+                char c = *p_++;
+                switch (c) {
+                    case '"': case '\\': case '/': scratch_ += c; break;
+                    case 'b': scratch_ += '\b'; break;
+                    case 'f': scratch_ += '\f'; break;
+                    case 'n': scratch_ += '\n'; break;
+                    case 'r': scratch_ += '\r'; break;
+                    case 't': scratch_ += '\t'; break;
+                    case 'u': {
+                        uint32_t cp = 0;
+                        if (!read_hex4(cp)) return fail("invalid unicode escape");
+                        if (cp >= 0xD800 && cp < 0xDC00 && end_ - p_ >= 6 && p_[0] == '\\' && p_[1] == 'u') {
+                            p_ += 2;
+                            uint32_t low = 0;
+                            if (!read_hex4(low) || low < 0xDC00 || low > 0xDFFF) return fail("invalid surrogate pair");
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        append_utf8(scratch_, cp);
+                        break;
+                    }
+                    default: return fail("invalid escape");
+                }
+            }
+            if (p_ == end_) return fail("unterminated string");
+            ++p_;
+            out = scratch_;
+            return true;
+        }
+
+        bool read_hex4(uint32_t& cp) {
+            if (end_ - p_ < 4) return false;
+            auto res = std::from_chars(p_, p_ + 4, cp, 16);
+            if (res.ptr != p_ + 4) return false;
+            p_ += 4;
+            return true;
+        }
+
+        // Calls member(key) for each key with the cursor on its value; member
+        // must consume the value
+        template <class F>
+        bool parse_object(int depth, F&& member) {
+            if (depth >= kMaxDepth) return fail("nesting too deep");
+            if (!consume('{')) return fail("expected object");
+            if (consume('}')) return true;
+            do {
+                std::string_view key;
+                if (!read_string(key) || !consume(':')) return fail("expected ':' after key");
+                if (!member(key)) return false;
+            } while (consume(','));
+            return consume('}') || fail("expected ',' or '}'");
+        }
+
+        bool skip_value(int depth) {
+            if (depth >= kMaxDepth) return fail("nesting too deep");
+            skip_ws();
+            if (p_ == end_) return fail("unexpected end of input");
+            std::string_view ignored;
+            switch (*p_) {
+                case '{':
+                    return parse_object(depth, [&](std::string_view) { return skip_value(depth + 1); });
+                case '[':
+                    ++p_;
+                    if (consume(']')) return true;
+                    do {
+                        if (!skip_value(depth + 1)) return false;
+                    } while (consume(','));
+                    return consume(']') || fail("expected ',' or ']'");
+                case '"':
+                    return read_string(ignored);
+                default: {
+                    const char* start = p_;
+                    while (p_ < end_ && (std::isalnum(static_cast<unsigned char>(*p_)) || *p_ == '-' || *p_ == '+' || *p_ == '.')) ++p_;
+                    std::string_view token(start, p_ - start);
+                    double number = 0;
+                    if (token == "true" || token == "false" || token == "null" || parse_number(token, number)) return true;
+                    return fail("invalid literal");
+                }
+            }
+        }
+
+        bool root_member(std::string_view key) {
+            std::string_view value;
+            if (key == "Error Message" || key == "Note" || key == "Information") {
+                skip_ws();
+                if (p_ == end_ || *p_ != '"') return skip_value(1);
+                if (!read_string(value)) return false;
+                (key == "Note" ? note : key == "Information" ? information : api_error).assign(value);
+                return true;
+            }
+            if (key != "Time Series (Daily)") return skip_value(1);
+            has_series = true;
+            return parse_object(1, [this](std::string_view date_key) {
+                int32_t date = quant::parse_date(date_key);
+                if (date == quant::kInvalidDate) return fail("invalid date " + std::string(date_key));
+                return parse_bar(date);
+            });
+        }
+
+        bool parse_bar(int32_t date) {
+            unsigned seen = 0;
+            double open = 0, high = 0, low = 0, close = 0, adj_close = 0;
+            int64_t volume = 0;
+            bool ok = parse_object(2, [&](std::string_view field) {
+                skip_ws();
+                if (p_ == end_ || *p_ != '"') return skip_value(3);
+                double* target = nullptr;
+                unsigned bit = 0;
+                const char* name = nullptr;
+                bool is_volume = false;
+                if (field == "1. open") { target = &open; bit = kOpen; name = "open"; }
+                else if (field == "2. high") { target = &high; bit = kHigh; name = "high"; }
+                else if (field == "3. low") { target = &low; bit = kLow; name = "low"; }
+                else if (field == "4. close") { target = &close; bit = kClose; name = "close"; }
+                else if (field == "5. adjusted close") { target = &adj_close; bit = kAdjClose; name = "adjusted close"; }
+                else if (field == "6. volume" || field == "5. volume") { is_volume = true; }
+                std::string_view value;
+                if (!read_string(value)) return false;
+                if (is_volume && !parse_number(value, volume)) return fail("invalid volume for " + quant::format_date(date));
+                if (target && !parse_number(value, *target)) return fail(std::string("invalid ") + name + " for " + quant::format_date(date));
+                seen |= bit;
+                return true;
+            });
+            if (!ok) return false;
+            if ((seen & kRequired) != kRequired) return fail("missing price fields for " + quant::format_date(date));
+            out_.push_back(date, open, high, low, close, (seen & kAdjClose) ? adj_close : close, volume);
+            return true;
+        }
+    };
+
+    // AlphaVantage lists bars newest first; flip that in O(n) and only fall
+    // back to a sort when the order is anything else
+    void order_oldest_first(quant::BarSeries& cols) {
+        const auto& d = cols.date;
+        if (std::is_sorted(d.begin(), d.end())) return;
+        if (std::is_sorted(d.rbegin(), d.rend())) {
+            std::reverse(cols.date.begin(), cols.date.end());
+            std::reverse(cols.open.begin(), cols.open.end());
+            std::reverse(cols.high.begin(), cols.high.end());
+            std::reverse(cols.low.begin(), cols.low.end());
+            std::reverse(cols.close.begin(), cols.close.end());
+            std::reverse(cols.adj_close.begin(), cols.adj_close.end());
+            std::reverse(cols.volume.begin(), cols.volume.end());
+            return;
+        }
+        std::vector<size_t> order(cols.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(), [&d](size_t a, size_t b) { return d[a] < d[b]; });
+        quant::BarSeries sorted;
+        sorted.reserve(order.size());
+        for (size_t i : order) {
+            sorted.push_back(cols.date[i], cols.open[i], cols.high[i], cols.low[i],
+                             cols.close[i], cols.adj_close[i], cols.volume[i]);
+        }
+        cols = std::move(sorted);
+    }
+}
+
+struct Client::CurlShare {
+    CURLSH* handle = nullptr;
+    std::mutex locks[CURL_LOCK_DATA_LAST];
+
+    CurlShare() {
+        handle = curl_share_init();
+        if (!handle) return;
+        curl_share_setopt(handle, CURLSHOPT_LOCKFUNC, &CurlShare::lock);
+        curl_share_setopt(handle, CURLSHOPT_UNLOCKFUNC, &CurlShare::unlock);
+        curl_share_setopt(handle, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+
+    ~CurlShare() {
+        if (handle) curl_share_cleanup(handle);
+    }
+
+    static void lock(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+        static_cast<CurlShare*>(userptr)->locks[data].lock();
+    }
+
+    static void unlock(CURL*, curl_lock_data data, void* userptr) {
+        static_cast<CurlShare*>(userptr)->locks[data].unlock();
+    }
+};
+
+namespace {
+    void configure_easy(CURL* curl, CURLSH* share, const std::string& url, std::string* body) {
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, body);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        if (share) {
+            curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        }
+    }
+
+    metrics::Counter& upstream_responses(const std::string& status) {
+        return metrics::registry().counter("upstream_responses_total",
+            "AlphaVantage responses by HTTP status (error = transport failure)", {{"status", status}});
+    }
+
+    // Counter for an HTTP status; the common ones are looked up once so only
+    // an unexpected code takes the registry lock
+    metrics::Counter& upstream_status(long http_code) {
+        static metrics::Counter& ok = upstream_responses("200");
+        static metrics::Counter& bad_request = upstream_responses("400");
+        static metrics::Counter& forbidden = upstream_responses("403");
+        static metrics::Counter& not_found = upstream_responses("404");
+        static metrics::Counter& too_many = upstream_responses("429");
+        static metrics::Counter& server_error = upstream_responses("500");
+        static metrics::Counter& bad_gateway = upstream_responses("502");
+        static metrics::Counter& unavailable = upstream_responses("503");
+        static metrics::Counter& gateway_timeout = upstream_responses("504");
+        switch (http_code) {
+            case 200: return ok;
+            case 400: return bad_request;
+            case 403: return forbidden;
+            case 404: return not_found;
+            case 429: return too_many;
+            case 500: return server_error;
+            case 502: return bad_gateway;
+            case 503: return unavailable;
+            case 504: return gateway_timeout;
+            default: return upstream_responses(std::to_string(http_code));
+        }
+    }
+
+    // Turn a finished transfer into a body or an error message, recording
+    // its duration and status on the way
+    std::optional<std::string> check_transfer(CURL* curl, CURLcode res, std::string& body, std::string& error) {
+        static metrics::Histogram& duration = metrics::registry().histogram(
+            "upstream_request_duration_seconds", "AlphaVantage HTTP request duration");
+        static metrics::Counter& transport_error = upstream_responses("error");
+
+        curl_off_t total_us = 0;
+        if (curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total_us) == CURLE_OK) {
+            duration.record(static_cast<uint64_t>(total_us) * 1000);
+        }
+
+        if (res != CURLE_OK) {
+            transport_error.inc();
+            error = std::string("CURL error: ") + curl_easy_strerror(res);
+            return std::nullopt;
+        }
+
+        long http_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+
+        upstream_status(http_code).inc();
+        if (http_code != 200) {
+            error = "HTTP error: " + std::to_string(http_code);
+            return std::nullopt;
+        }
+
+        return std::move(body);
+    }
+}
+
+Client::Client(const std::string& api_key, int max_in_flight, RateLimits limits, RetryPolicy retry)
+    : api_key_(api_key), max_in_flight_(std::max(1, max_in_flight)), retry_(retry) {
+    std::call_once(curl_init_flag, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+    share_ = std::make_unique<CurlShare>();
+    limiter_ = std::make_unique<RateLimiter>(limits);
 }
 
-Client::Client(const std::string& api_key) : api_key_(api_key) {}
+Client::~Client() = default;
 
 bool Client::is_configured() const {
     return !api_key_.empty();
 }
 
-const std::string& Client::last_error() const {
-    return last_error_;
+bool Client::is_rate_limited(const FetchResult& result) {
+    return result.error.rfind("Rate limit", 0) == 0 || result.error == "HTTP error: 429";
+}
+
+bool Client::is_quota_exhausted(const FetchResult& result) {
+    return result.error.rfind(kQuotaExhausted, 0) == 0;
+}
+
+std::chrono::milliseconds Client::retry_delay(int attempt) const {
+    thread_local std::mt19937 rng(std::random_device{}());
+    auto ceiling = retry_.base.count() << std::min(attempt, 20);
+    ceiling = std::min<long long>(ceiling, retry_.cap.count());
+    std::uniform_int_distribution<long long> jitter(0, std::max<long long>(0, ceiling));
+    return std::chrono::milliseconds(jitter(rng));
 }
 
-std::optional<std::string> Client::http_get(const std::string& url) {
-    CURL* curl = curl_easy_init();
+std::string Client::build_url(const std::string& symbol, const std::string& outputsize) const {
+    std::ostringstream url;
+    url << "https://www.alphavantage.co/query"
+        << "?function=TIME_SERIES_DAILY_ADJUSTED"
+        << "&symbol=" << symbol
+        << "&outputsize=" << outputsize
+        << "&apikey=" << api_key_;
+    return url.str();
+}
+
+std::optional<std::string> Client::http_get(const std::string& url, std::string& error) const {
+    EasyHandle curl(curl_easy_init());
     if (!curl) {
-        last_error_ = "Failed to initialize CURL";
+        error = "Failed to initialize CURL";
         return std::nullopt;
     }
 
     std::string response_body;
+    configure_easy(curl.get(), share_->handle, url, &response_body);
 
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_body);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    CURLcode res = curl_easy_perform(curl.get());
+    return check_transfer(curl.get(), res, response_body, error);
+}
 
-    CURLcode res = curl_easy_perform(curl);
+bool Client::parse_daily_columns(std::string_view json_str, quant::BarSeries& out, std::string& error) {
+    static metrics::Histogram& parse_time = metrics::registry().timer(
+        "upstream_parse_duration_seconds", "Time to parse a daily series response into columns");
+    metrics::ScopedTimer timer(parse_time);
 
-    if (res != CURLE_OK) {
-        last_error_ = std::string("CURL error: ") + curl_easy_strerror(res);
-        curl_easy_cleanup(curl);
-        return std::nullopt;
-    }
+    out = quant::BarSeries();
+    out.reserve(json_str.size() / kBytesPerBar + 1);
 
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-    curl_easy_cleanup(curl);
+    DailySeriesParser parser(json_str, out);
+    bool parsed = parser.parse();
 
-    if (http_code != 200) {
-        last_error_ = "HTTP error: " + std::to_string(http_code);
-        return std::nullopt;
+    // API errors take precedence over whatever else the body contained
+    if (!parser.api_error.empty()) {
+        error = parser.api_error;
+    } else if (!parser.note.empty()) {
+        error = "Rate limit: " + parser.note;
+    } else if (!parser.information.empty() && !parser.has_series) {
+        // The daily quota notice will not clear for hours, so it is not
+        // worth a retry the way the per-minute one is
+        bool limited = parser.information.find("rate limit") != std::string::npos;
+        bool daily = limited && parser.information.find("per day") != std::string::npos;
+        error = daily ? std::string(kQuotaExhausted) + ": " + parser.information
+              : limited ? "Rate limit: " + parser.information : parser.information;
+    } else if (!parsed) {
+        error = parser.error;
+    } else if (!parser.has_series) {
+        error = "No time series data in response";
+    } else {
+        order_oldest_first(out);
+        return true;
     }
+    out = quant::BarSeries();
+    return false;
+}
 
-    return response_body;
+FetchResult Client::parse_daily_response(const std::string& json_str) {
+    FetchResult result;
+    if (!parse_daily_columns(json_str, result.bars, result.error)) {
+        result.bars = quant::BarSeries();
+    }
+    return result;
 }
 
-std::vector<PriceBar> Client::parse_daily_response(const std::string& json_str) {
-    std::vector<PriceBar> bars;
+FetchResult Client::fetch_daily_adjusted(const std::string& symbol, const std::string& outputsize,
+                                         Priority priority) const {
+    if (!is_configured()) {
+        return FetchResult::failure("API key not configured");
+    }
 
-    try {
-        auto json = nlohmann::json::parse(json_str);
+    const std::string url = build_url(symbol, outputsize);
+    for (int attempt = 0;; ++attempt) {
+        if (!limiter_->acquire(priority)) {
+            return FetchResult::failure(kQuotaExhausted);
+        }
 
-        // Check for API errors
-        if (json.contains("Error Message")) {
-            last_error_ = json["Error Message"].get<std::string>();
-            return bars;
+        std::string error;
+        auto response = http_get(url, error);
+        FetchResult result = response ? parse_daily_response(*response) : FetchResult::failure(std::move(error));
+        if (is_quota_exhausted(result)) limiter_->on_quota_exhausted();
+        if (!is_rate_limited(result) || attempt + 1 >= retry_.max_attempts) {
+            return result;
         }
+        limiter_->on_rate_limited();
+        std::this_thread::sleep_for(retry_delay(attempt));
+    }
+}
 
-        if (json.contains("Note")) {
-            last_error_ = "Rate limit: " + json["Note"].get<std::string>();
-            return bars;
+void Client::fetch_many(const std::vector<std::string>& symbols, const std::string& outputsize,
+                        const BatchCallback& on_done, Priority priority) const {
+    if (!is_configured()) {
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            on_done(i, FetchResult::failure("API key not configured"));
         }
+        return;
+    }
 
-        if (!json.contains("Time Series (Daily)")) {
-            last_error_ = "No time series data in response";
-            return bars;
+    MultiHandle multi(curl_multi_init());
+    if (!multi) {
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            on_done(i, FetchResult::failure("Failed to initialize CURL multi handle"));
         }
+        return;
+    }
+    curl_multi_setopt(multi.get(), CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(max_in_flight_));
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Transfer {
+        size_t index;
+        std::string url;
+        std::string body;
+        int attempts = 0;
+        EasyHandle easy;    // set while in flight
+    };
+    // Declared after `multi`, so in-flight handles are released first
+    std::vector<Transfer> transfers(symbols.size());
 
-        auto& time_series = json["Time Series (Daily)"];
+    // Symbols waiting for a token, in order, and rate-limited ones waiting out a backoff
+    std::deque<size_t> ready;
+    std::vector<std::pair<Clock::time_point, size_t>> backing_off;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        transfers[i].index = i;
+        transfers[i].url = build_url(symbols[i], outputsize);
+        ready.push_back(i);
+    }
 
-        for (auto& [date, data] : time_series.items()) {
-            PriceBar bar;
-            bar.date = date;
-            bar.open = std::stod(data["1. open"].get<std::string>());
-            bar.high = std::stod(data["2. high"].get<std::string>());
-            bar.low = std::stod(data["3. low"].get<std::string>());
-            bar.close = std::stod(data["4. close"].get<std::string>());
+    int in_flight = 0;
+    Clock::time_point next_wake = Clock::now();
 
-            if (data.contains("5. adjusted close")) {
-                bar.adj_close = std::stod(data["5. adjusted close"].get<std::string>());
+    auto start_transfers = [&]() {
+        auto now = Clock::now();
+        for (auto it = backing_off.begin(); it != backing_off.end();) {
+            if (it->first <= now) {
+                ready.push_back(it->second);
+                it = backing_off.erase(it);
             } else {
-                bar.adj_close = bar.close;
+                ++it;
             }
+        }
 
-            if (data.contains("6. volume")) {
-                bar.volume = std::stol(data["6. volume"].get<std::string>());
-            } else if (data.contains("5. volume")) {
-                bar.volume = std::stol(data["5. volume"].get<std::string>());
-            } else {
-                bar.volume = 0;
+        while (in_flight < max_in_flight_ && !ready.empty()) {
+            auto wait = limiter_->try_acquire(priority);
+            if (!wait) {
+                // Daily quota spent: nothing left here can succeed today
+                for (size_t index : ready) on_done(index, FetchResult::failure(kQuotaExhausted));
+                for (const auto& entry : backing_off) on_done(entry.second, FetchResult::failure(kQuotaExhausted));
+                ready.clear();
+                backing_off.clear();
+                break;
+            }
+            if (*wait != Clock::duration::zero()) {
+                next_wake = now + *wait;
+                break;
             }
 
-            bars.push_back(bar);
+            Transfer& t = transfers[ready.front()];
+            ready.pop_front();
+            t.body.clear();
+            ++t.attempts;
+
+            t.easy.reset(curl_easy_init());
+            if (!t.easy) {
+                on_done(t.index, FetchResult::failure("Failed to initialize CURL"));
+                continue;
+            }
+            configure_easy(t.easy.get(), share_->handle, t.url, &t.body);
+            curl_easy_setopt(t.easy.get(), CURLOPT_PRIVATE, &t);
+            curl_multi_add_handle(multi.get(), t.easy.get());
+            ++in_flight;
         }
 
-        // Sort by date ascending (oldest first)
-        std::sort(bars.begin(), bars.end(),
-            [](const PriceBar& a, const PriceBar& b) {
-                return a.date < b.date;
-            });
+        for (const auto& entry : backing_off) next_wake = std::min(next_wake, entry.first);
+    };
 
-    } catch (const std::exception& e) {
-        last_error_ = std::string("JSON parse error: ") + e.what();
-        return {};
-    }
+    start_transfers();
 
-    return bars;
-}
+    while (in_flight > 0 || !ready.empty() || !backing_off.empty()) {
+        int running = 0;
+        curl_multi_perform(multi.get(), &running);
 
-std::vector<PriceBar> Client::fetch_daily_adjusted(const std::string& symbol) {
-    if (!is_configured()) {
-        last_error_ = "API key not configured";
-        return {};
-    }
+        int queued = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi.get(), &queued)) {
+            if (msg->msg != CURLMSG_DONE) continue;
 
-    std::ostringstream url;
-    url << "https://www.alphavantage.co/query"
-        << "?function=TIME_SERIES_DAILY_ADJUSTED"
-        << "&symbol=" << symbol
-        << "&outputsize=compact"
-        << "&apikey=" << api_key_;
+            CURL* curl = msg->easy_handle;
+            Transfer* t = nullptr;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, &t);
 
-    auto response = http_get(url.str());
-    if (!response) {
-        return {};
-    }
+            std::string error;
+            auto body = check_transfer(curl, msg->data.result, t->body, error);
+            curl_multi_remove_handle(multi.get(), curl);
+            t->easy.reset();
+            --in_flight;
+
+            FetchResult result = body ? parse_daily_response(*body) : FetchResult::failure(std::move(error));
+            // The rest of the batch then fails fast on the exhausted limiter
+            if (is_quota_exhausted(result)) limiter_->on_quota_exhausted();
+            if (is_rate_limited(result) && t->attempts < retry_.max_attempts) {
+                limiter_->on_rate_limited();
+                backing_off.emplace_back(Clock::now() + retry_delay(t->attempts - 1), t->index);
+                continue;
+            }
+            on_done(t->index, std::move(result));
+        }
 
-    return parse_daily_response(*response);
+        next_wake = Clock::now() + std::chrono::seconds(1);
+        start_transfers();
+
+        if (in_flight > 0 || !ready.empty() || !backing_off.empty()) {
+            auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(next_wake - Clock::now());
+            int timeout_ms = static_cast<int>(std::clamp<long long>(timeout.count(), 1, 1000));
+            curl_multi_poll(multi.get(), nullptr, 0, timeout_ms, nullptr);
+        }
+    }
 }
 
 } // namespace alphavantage
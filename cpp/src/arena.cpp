@@ -0,0 +1,77 @@
+#include "arena.h"
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+namespace quant {
+
+namespace {
+    std::atomic<uint64_t> g_scopes{0};
+    std::atomic<uint64_t> g_heap_blocks{0};
+    std::atomic<uint64_t> g_heap_bytes{0};
+}
+
+Arena::Arena(size_t block_size) : block_size_(std::max<size_t>(block_size, 256)) {}
+
+Arena::~Arena() {
+    for (const auto& block : blocks_) ::operator delete(block.data);
+}
+
+void Arena::rewind(const Mark& mark) {
+    current_ = mark.block;
+    offset_ = mark.offset;
+    base_ = 0;
+    for (size_t i = 0; i < current_ && i < blocks_.size(); ++i) base_ += blocks_[i].size;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+    for (;;) {
+        // Bump within the current block, else move on to the next kept one
+        while (current_ < blocks_.size()) {
+            const Block& block = blocks_[current_];
+            auto address = reinterpret_cast<uintptr_t>(block.data);
+            size_t start = ((address + offset_ + alignment - 1) & ~(uintptr_t(alignment) - 1)) - address;
+            if (start + bytes <= block.size) {
+                offset_ = start + bytes;
+                ++stats_.allocations;
+                stats_.high_water = std::max(stats_.high_water, base_ + offset_);
+                return block.data + start;
+            }
+            base_ += block.size;
+            ++current_;
+            offset_ = 0;
+        }
+
+        // Out of blocks: each new one doubles the last, so a growing
+        // request settles after a few heap calls
+        size_t size = blocks_.empty() ? block_size_ : blocks_.back().size * 2;
+        size = std::max(size, bytes + alignment);
+        blocks_.push_back(Block{static_cast<std::byte*>(::operator new(size)), size});
+        ++stats_.heap_blocks;
+        stats_.capacity += size;
+        g_heap_blocks.fetch_add(1, std::memory_order_relaxed);
+        g_heap_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+Arena& thread_arena() {
+    thread_local Arena arena;
+    return arena;
+}
+
+ArenaTotals arena_totals() {
+    ArenaTotals totals;
+    totals.scopes = g_scopes.load(std::memory_order_relaxed);
+    totals.heap_blocks = g_heap_blocks.load(std::memory_order_relaxed);
+    totals.heap_bytes = g_heap_bytes.load(std::memory_order_relaxed);
+    return totals;
+}
+
+ArenaScope::ArenaScope() : arena_(thread_arena()), mark_(arena_.mark()) {}
+
+ArenaScope::~ArenaScope() {
+    arena_.rewind(mark_);
+    g_scopes.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace quant
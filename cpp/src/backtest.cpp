@@ -0,0 +1,212 @@
+#include "backtest.h"
+#include <algorithm>
+#include <numeric>
+#include "parallel.h"
+#include "ranking.h"
+#include "rolling.h"
+#include "signals.h"
+
+namespace backtest {
+
+namespace {
+    // Bars before the first signal: a full monthly-return window, which also
+    // covers the MA20 warm-up
+    constexpr size_t kWarmup = 30;
+
+    struct Observation {
+        int32_t date;
+        float prob_up;
+        float forward_return;
+    };
+
+    // Per-date results, merged into fold and overall metrics
+    struct DateStats {
+        size_t observations = 0;
+        size_t calls = 0;
+        size_t hits = 0;
+        bool scored = false;            // cross-section large enough for IC / deciles
+        double ic = 0.0;
+        std::array<double, 10> deciles{};
+    };
+
+    std::vector<Observation> replay(const quant::BarView& s, int horizon) {
+        std::vector<Observation> out;
+        const size_t n = s.size();
+        if (n < kWarmup + static_cast<size_t>(horizon)) return out;
+        out.reserve(n - kWarmup - horizon + 1);
+
+        quant::Span<const double> labels = s.adj_close.empty() ? s.close : s.adj_close;
+        quant::RollingSMA ma5(5);
+        quant::RollingSMA ma20(20);
+        for (size_t t = 0; t + horizon < n; ++t) {
+            double price = s.close[t];
+            ma5.push(price);
+            ma20.push(price);
+            if (t + 1 < kWarmup) continue;
+
+            double month_ago = s.close[t + 1 - kWarmup];
+            double monthly_return = (price - month_ago) / month_ago * 100.0;
+            auto trend = signals::SignalService::determine_trend(price, ma5.value(), ma20.value(), monthly_return);
+            double prob_up = signals::SignalService::calculate_prob_up(trend, monthly_return);
+
+            double forward = labels[t + horizon] / labels[t] - 1.0;
+            if (!std::isfinite(forward)) continue;
+            out.push_back({s.date[t], static_cast<float>(prob_up), static_cast<float>(forward)});
+        }
+        return out;
+    }
+
+    void rank(const float* values, size_t n, std::vector<uint64_t>& sorted, std::vector<double>& ranks) {
+        sorted.resize(n);
+        ranks.resize(n);
+        quant::rank(values, n, sorted.data(), ranks.data());
+    }
+
+    double pearson(const std::vector<double>& x, const std::vector<double>& y) {
+        size_t n = x.size();
+        double mx = std::accumulate(x.begin(), x.end(), 0.0) / n;
+        double my = std::accumulate(y.begin(), y.end(), 0.0) / n;
+        double sxy = 0, sxx = 0, syy = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sxy += (x[i] - mx) * (y[i] - my);
+            sxx += (x[i] - mx) * (x[i] - mx);
+            syy += (y[i] - my) * (y[i] - my);
+        }
+        return sxx > 0 && syy > 0 ? sxy / std::sqrt(sxx * syy) : 0.0;
+    }
+
+    DateStats score_date(const Observation* obs, size_t n, size_t min_cross_section) {
+        DateStats stats;
+        stats.observations = n;
+        for (size_t i = 0; i < n; ++i) {
+            if (obs[i].prob_up == 0.5f) continue;
+            ++stats.calls;
+            if ((obs[i].prob_up > 0.5f) == (obs[i].forward_return > 0.0f)) ++stats.hits;
+        }
+        if (n < std::max<size_t>(min_cross_section, 10)) return stats;
+
+        thread_local std::vector<float> prob, forward;
+        thread_local std::vector<double> prob_rank, forward_rank;
+        thread_local std::vector<uint64_t> order;
+        prob.resize(n);
+        forward.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            prob[i] = obs[i].prob_up;
+            forward[i] = obs[i].forward_return;
+        }
+        rank(forward.data(), n, order, forward_rank);
+        rank(prob.data(), n, order, prob_rank);     // leaves `order` sorted by prob_up
+        stats.ic = pearson(prob_rank, forward_rank);
+
+        for (size_t d = 0; d < 10; ++d) {
+            size_t begin = d * n / 10, end = (d + 1) * n / 10;
+            double sum = 0;
+            for (size_t i = begin; i < end; ++i) sum += forward[static_cast<uint32_t>(order[i])];
+            stats.deciles[d] = sum / (end - begin);
+        }
+        stats.scored = true;
+        return stats;
+    }
+
+    Metrics aggregate(const std::vector<int32_t>& dates, const std::vector<DateStats>& stats,
+                      size_t begin, size_t end) {
+        Metrics m;
+        if (begin == end) return m;
+        m.first_date = dates[begin];
+        m.last_date = dates[end - 1];
+
+        size_t calls = 0, hits = 0;
+        double ic_sum = 0, ic_sq = 0;
+        std::array<double, 10> decile_sum{};
+        for (size_t i = begin; i < end; ++i) {
+            const auto& s = stats[i];
+            m.observations += s.observations;
+            calls += s.calls;
+            hits += s.hits;
+            if (!s.scored) continue;
+            ++m.dates;
+            ic_sum += s.ic;
+            ic_sq += s.ic * s.ic;
+            for (size_t d = 0; d < 10; ++d) decile_sum[d] += s.deciles[d];
+        }
+
+        if (calls > 0) m.hit_rate = static_cast<double>(hits) / calls;
+        if (m.dates > 0) {
+            m.mean_ic = ic_sum / m.dates;
+            if (m.dates > 1) {
+                double var = (ic_sq - ic_sum * ic_sum / m.dates) / (m.dates - 1);
+                if (var > 0) m.ic_ir = m.mean_ic / std::sqrt(var);
+            }
+            for (size_t d = 0; d < 10; ++d) m.decile_returns[d] = decile_sum[d] / m.dates;
+            m.decile_spread = m.decile_returns[9] - m.decile_returns[0];
+        } else {
+            m.decile_returns.fill(NAN);
+        }
+        return m;
+    }
+}
+
+Report run(const std::vector<quant::BarView>& universe, const Config& config) {
+    Report report;
+    const int horizon = std::max(1, config.horizon);
+
+    // Replay symbols independently; each only ever reads its own past
+    std::vector<std::vector<Observation>> per_symbol(universe.size());
+    quant::parallel_for(universe.size(), config.threads, [&](size_t i) {
+        per_symbol[i] = replay(universe[i], horizon);
+    });
+
+    // Bucket observations by date with a counting sort over the date range
+    int32_t lo = INT32_MAX, hi = INT32_MIN;
+    size_t total = 0;
+    for (const auto& obs : per_symbol) {
+        for (const auto& o : obs) {
+            lo = std::min(lo, o.date);
+            hi = std::max(hi, o.date);
+        }
+        total += obs.size();
+    }
+    if (total == 0) {
+        report.overall.decile_returns.fill(NAN);
+        return report;
+    }
+
+    std::vector<size_t> offsets(static_cast<size_t>(hi - lo) + 2, 0);
+    for (const auto& obs : per_symbol) {
+        for (const auto& o : obs) ++offsets[static_cast<size_t>(o.date - lo) + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<Observation> by_date(total);
+    {
+        std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (auto& obs : per_symbol) {
+            for (const auto& o : obs) by_date[cursor[static_cast<size_t>(o.date - lo)]++] = o;
+            std::vector<Observation>().swap(obs);
+        }
+    }
+
+    std::vector<int32_t> dates;
+    std::vector<size_t> starts;
+    for (size_t d = 0; d + 1 < offsets.size(); ++d) {
+        if (offsets[d + 1] > offsets[d]) {
+            dates.push_back(lo + static_cast<int32_t>(d));
+            starts.push_back(offsets[d]);
+        }
+    }
+    starts.push_back(total);
+
+    std::vector<DateStats> stats(dates.size());
+    quant::parallel_for(dates.size(), config.threads, [&](size_t i) {
+        stats[i] = score_date(by_date.data() + starts[i], starts[i + 1] - starts[i], config.min_cross_section);
+    }, 8);
+
+    // Contiguous, equally sized date ranges in time order
+    size_t folds = std::min(static_cast<size_t>(std::max(1, config.folds)), dates.size());
+    for (size_t f = 0; f < folds; ++f) {
+        report.folds.push_back(aggregate(dates, stats, f * dates.size() / folds, (f + 1) * dates.size() / folds));
+    }
+    report.overall = aggregate(dates, stats, 0, dates.size());
+    return report;
+}
+
+} // namespace backtest
@@ -0,0 +1,335 @@
+#include "bar_cache.h"
+#include <algorithm>
+#include "arena.h"
+
+namespace alphavantage {
+
+namespace {
+    double seconds_between(std::chrono::steady_clock::time_point from,
+                           std::chrono::steady_clock::time_point to) {
+        return std::chrono::duration<double>(to - from).count();
+    }
+}
+
+BarCache::BarCache(const Client& client, std::chrono::seconds ttl)
+    : BarCache([&client](const std::string& symbol, const std::string& outputsize) {
+          return client.fetch_daily_adjusted(symbol, outputsize);
+      }, ttl,
+      [&client](const std::vector<std::string>& symbols, const std::string& outputsize,
+                const Client::BatchCallback& on_done, Priority priority) {
+          client.fetch_many(symbols, outputsize, on_done, priority);
+      }) {}
+
+BarCache::BarCache(FetchFn fetch, std::chrono::seconds ttl, BatchFetchFn batch_fetch)
+    : fetch_(std::move(fetch)), batch_fetch_(std::move(batch_fetch)), ttl_(ttl) {}
+
+bool BarCache::is_not_cached(const std::string& error) {
+    return error.rfind(kNotCached, 0) == 0;
+}
+
+void BarCache::set_local_fetch(FetchFn local_fetch) {
+    local_fetch_ = std::move(local_fetch);
+}
+
+void BarCache::make_key(const std::string& symbol, const std::string& outputsize, std::string& key) {
+    key.assign(symbol).append(1, '\n').append(outputsize);
+}
+
+BarCache::Result BarCache::publish(const std::string& key, const std::string& symbol,
+                                   const std::string& outputsize, FetchResult fetched) {
+    if (fetched.bars.empty() && fetched.ok()) {
+        fetched.error = "No data returned";
+    }
+
+    Result result;
+    result.error = std::move(fetched.error);
+    result.bars = std::make_shared<const quant::BarSeries>(std::move(fetched.bars));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = clock::now();
+    if (result.error.empty()) {
+        purge_expired_locked(now);
+        entries_[key] = Entry{symbol, outputsize, result.bars, now};
+    }
+    in_flight_.erase(key);
+
+    return result;
+}
+
+BarCache::Result BarCache::get(const std::string& symbol, const std::string& outputsize) {
+    std::string key;
+    make_key(symbol, outputsize, key);
+
+    std::promise<Result> promise;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto now = clock::now();
+
+        auto it = entries_.find(key);
+        if (it != entries_.end() && now - it->second.fetched_at < ttl_) {
+            ++hits_;
+            return Result{it->second.bars, "", true};
+        }
+
+        // Someone else is already fetching this key: wait for their result
+        auto flight = in_flight_.find(key);
+        if (flight != in_flight_.end()) {
+            ++coalesced_;
+            auto future = flight->second;
+            lock.unlock();
+            return future.get();
+        }
+
+        ++misses_;
+        in_flight_.emplace(key, promise.get_future().share());
+    }
+
+    FetchResult fetched;
+    try {
+        fetched = fetch_(symbol, outputsize);
+    } catch (const std::exception& e) {
+        fetched = FetchResult::failure(e.what());
+    } catch (...) {
+        // Waiters on this key must still get a result
+        fetched = FetchResult::failure("Fetch failed");
+    }
+
+    auto result = publish(key, symbol, outputsize, std::move(fetched));
+    promise.set_value(result);
+
+    return result;
+}
+
+void BarCache::get_many(const std::vector<std::string>& symbols, const std::string& outputsize,
+                        const ReadyFn& on_ready, Priority priority) {
+    struct Miss {
+        size_t index;
+        std::string key;
+        std::promise<Result> promise;
+        bool done = false;
+    };
+
+    // Bookkeeping lives in the thread's arena; sized up front so nothing
+    // grows while on_ready (which may open its own scope) runs
+    quant::ArenaScope scope;
+    std::pmr::vector<std::pair<size_t, Result>> hits(scope.resource());
+    std::pmr::vector<std::pair<size_t, std::shared_future<Result>>> waits(scope.resource());
+    std::pmr::vector<Miss> misses(scope.resource());
+    hits.reserve(symbols.size());
+    waits.reserve(symbols.size());
+    misses.reserve(symbols.size());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = clock::now();
+
+        // One key buffer reused for every lookup
+        std::string key;
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            make_key(symbols[i], outputsize, key);
+
+            auto it = entries_.find(key);
+            if (it != entries_.end() && now - it->second.fetched_at < ttl_) {
+                ++hits_;
+                hits.emplace_back(i, Result{it->second.bars, "", true});
+                continue;
+            }
+
+            auto flight = in_flight_.find(key);
+            if (flight != in_flight_.end()) {
+                ++coalesced_;
+                waits.emplace_back(i, flight->second);
+                continue;
+            }
+
+            ++misses_;
+            misses.push_back(Miss{i, key, {}, false});
+            in_flight_.emplace(misses.back().key, misses.back().promise.get_future().share());
+        }
+    }
+
+    auto complete = [&](Miss& miss, FetchResult fetched) {
+        auto result = publish(miss.key, symbols[miss.index], outputsize, std::move(fetched));
+        miss.promise.set_value(result);
+        miss.done = true;
+        on_ready(miss.index, result);
+    };
+
+    try {
+        for (const auto& [index, result] : hits) {
+            on_ready(index, result);
+        }
+
+        if (batch_fetch_ && !misses.empty()) {
+            std::vector<std::string> to_fetch;
+            to_fetch.reserve(misses.size());
+            for (const auto& miss : misses) {
+                to_fetch.push_back(symbols[miss.index]);
+            }
+            batch_fetch_(to_fetch, outputsize,
+                [&](size_t index, FetchResult fetched) {
+                    complete(misses[index], std::move(fetched));
+                }, priority);
+        } else {
+            for (auto& miss : misses) {
+                complete(miss, fetch_(symbols[miss.index], outputsize));
+            }
+        }
+
+        for (auto& miss : misses) {
+            if (!miss.done) {
+                complete(miss, FetchResult::failure("Fetch did not complete"));
+            }
+        }
+    } catch (...) {
+        // Never leave other callers waiting on a key we claimed
+        for (auto& miss : misses) {
+            if (!miss.done) {
+                miss.promise.set_value(publish(miss.key, symbols[miss.index], outputsize,
+                                               FetchResult::failure("Fetch aborted")));
+            }
+        }
+        throw;
+    }
+
+    for (auto& [index, future] : waits) {
+        on_ready(index, future.get());
+    }
+}
+
+void BarCache::get_local(const std::vector<std::string>& symbols, const std::string& outputsize,
+                         const ReadyFn& on_ready) {
+    quant::ArenaScope scope;
+    std::pmr::vector<std::pair<size_t, Result>> hits(scope.resource());
+    std::pmr::vector<size_t> misses(scope.resource());
+    hits.reserve(symbols.size());
+    misses.reserve(symbols.size());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = clock::now();
+        std::string key;
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            make_key(symbols[i], outputsize, key);
+            auto it = entries_.find(key);
+            if (it != entries_.end() && now - it->second.fetched_at < ttl_) {
+                ++hits_;
+                hits.emplace_back(i, Result{it->second.bars, "", true});
+            } else {
+                ++misses_;
+                misses.push_back(i);
+            }
+        }
+    }
+
+    for (const auto& [index, result] : hits) {
+        on_ready(index, result);
+    }
+
+    std::string key;
+    for (size_t index : misses) {
+        FetchResult fetched = FetchResult::failure(kNotCached);
+        if (local_fetch_) {
+            try {
+                fetched = local_fetch_(symbols[index], outputsize);
+            } catch (const std::exception& e) {
+                fetched = FetchResult::failure(e.what());
+            } catch (...) {
+                fetched = FetchResult::failure("Fetch failed");
+            }
+            if (fetched.bars.empty() && fetched.ok()) fetched.error = "No data returned";
+            if (!fetched.ok()) fetched.error = std::string(kNotCached) + ": " + fetched.error;
+        }
+
+        Result result;
+        result.error = std::move(fetched.error);
+        result.bars = std::make_shared<const quant::BarSeries>(std::move(fetched.bars));
+        if (result.error.empty()) {
+            // Cached like a fetch, unless an upstream fetch of the key is
+            // under way and will publish its own result
+            make_key(symbols[index], outputsize, key);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!in_flight_.count(key)) {
+                auto now = clock::now();
+                purge_expired_locked(now);
+                entries_[key] = Entry{symbols[index], outputsize, result.bars, now};
+            }
+        }
+        on_ready(index, result);
+    }
+}
+
+bool BarCache::fresh(const std::string& symbol, const std::string& outputsize) const {
+    std::string key;
+    make_key(symbol, outputsize, key);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    return it != entries_.end() && clock::now() - it->second.fetched_at < ttl_;
+}
+
+void BarCache::invalidate(const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.symbol == symbol) {
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void BarCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+void BarCache::purge_expired_locked(clock::time_point now) {
+    // A full scan per insert made a cold batch O(N * entries) under the
+    // lock; expired entries are never served, so sweeping once a TTL is enough
+    if (now - last_purge_ < ttl_) return;
+    last_purge_ = now;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (now - it->second.fetched_at >= ttl_) {
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+CacheStats BarCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = clock::now();
+
+    CacheStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.coalesced = coalesced_;
+    // Expired entries linger until the next sweep; they are not served
+    for (const auto& [key, entry] : entries_) {
+        if (now - entry.fetched_at >= ttl_) continue;
+        ++stats.entries;
+        stats.oldest_age_seconds = std::max(stats.oldest_age_seconds, seconds_between(entry.fetched_at, now));
+    }
+    return stats;
+}
+
+std::vector<CacheEntryInfo> BarCache::entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = clock::now();
+
+    std::vector<CacheEntryInfo> result;
+    result.reserve(entries_.size());
+    for (const auto& [key, entry] : entries_) {
+        if (now - entry.fetched_at >= ttl_) continue;
+        result.push_back({entry.symbol, entry.outputsize, entry.bars->size(),
+                          seconds_between(entry.fetched_at, now)});
+    }
+    std::sort(result.begin(), result.end(),
+        [](const CacheEntryInfo& a, const CacheEntryInfo& b) {
+            return a.symbol < b.symbol || (a.symbol == b.symbol && a.outputsize < b.outputsize);
+        });
+    return result;
+}
+
+} // namespace alphavantage
@@ -0,0 +1,209 @@
+#include "../include/bar_store.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace quant {
+
+namespace {
+    constexpr char kMagic[8] = {'Q', 'B', 'A', 'R', 'S', 0, 0, 0};
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t symbol_count;
+        uint64_t index_offset;
+        uint64_t names_offset;
+        uint64_t file_size;
+    };
+    static_assert(sizeof(Header) == 40, "unexpected header padding");
+
+    size_t align8(size_t n) {
+        return (n + 7) & ~size_t(7);
+    }
+
+    // Bytes per row across all columns; block_size(rows) <= rows * kRowBytes + 7
+    constexpr uint64_t kRowBytes = sizeof(int32_t) + 5 * sizeof(double) + sizeof(int64_t);
+
+    // Bytes used by one symbol's column block
+    uint64_t block_size(uint64_t rows) {
+        return align8(rows * sizeof(int32_t)) + rows * (5 * sizeof(double) + sizeof(int64_t));
+    }
+
+    class Writer {
+    public:
+        explicit Writer(std::ofstream& out) : out_(out) {}
+
+        template <class T>
+        void write(const T* data, size_t n) {
+            out_.write(reinterpret_cast<const char*>(data), n * sizeof(T));
+            pos_ += n * sizeof(T);
+        }
+
+        void pad() {
+            static const char zeros[8] = {};
+            write(zeros, align8(pos_) - pos_);
+        }
+
+        size_t pos() const { return pos_; }
+
+    private:
+        std::ofstream& out_;
+        size_t pos_ = 0;
+    };
+}
+
+bool BarStore::write(const std::string& path, const std::map<std::string, BarSeries>& symbols,
+                     std::string& error) {
+    const std::string tmp_path = path + ".tmp";
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "Cannot create " + tmp_path;
+        return false;
+    }
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.symbol_count = static_cast<uint32_t>(symbols.size());
+
+    Writer w(out);
+    w.write(&header, 1);
+    w.pad();
+
+    // std::map iterates in sorted order, which is the order readers binary-search
+    std::vector<IndexEntry> index;
+    index.reserve(symbols.size());
+    uint64_t name_offset = 0;
+    for (const auto& [symbol, cols] : symbols) {
+        size_t rows = cols.size();
+        index.push_back({static_cast<uint32_t>(name_offset), static_cast<uint32_t>(symbol.size()), rows, w.pos()});
+        name_offset += symbol.size();
+
+        w.write(cols.date.data(), rows);
+        w.pad();
+        w.write(cols.open.data(), rows);
+        w.write(cols.high.data(), rows);
+        w.write(cols.low.data(), rows);
+        w.write(cols.close.data(), rows);
+        w.write(cols.adj_close.data(), rows);
+        w.write(cols.volume.data(), rows);
+    }
+
+    header.names_offset = w.pos();
+    for (const auto& [symbol, cols] : symbols) {
+        w.write(symbol.data(), symbol.size());
+    }
+    w.pad();
+
+    header.index_offset = w.pos();
+    w.write(index.data(), index.size());
+    header.file_size = w.pos();
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        error = "Failed writing " + tmp_path;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        error = "Cannot rename " + tmp_path + " to " + path;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool BarStore::is_bar_store(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(kMagic)] = {};
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool BarStore::open(const std::string& path, std::string& error) {
+    index_ = nullptr;
+    names_ = nullptr;
+    count_ = 0;
+
+    if (!file_.open(path, error)) {
+        return false;
+    }
+
+    auto fail = [&](const std::string& why) {
+        error = path + ": " + why;
+        file_.close();
+        return false;
+    };
+
+    if (file_.size() < sizeof(Header)) return fail("too small to be a bar store");
+
+    Header header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) return fail("not a bar store");
+    if (header.version != kVersion) return fail("unsupported bar store version " + std::to_string(header.version));
+    if (header.file_size != file_.size()) return fail("truncated bar store");
+
+    // Offsets and counts come from the file, so every bound is checked
+    // without sums or products that could wrap
+    const uint64_t size = file_.size();
+    uint64_t index_bytes = uint64_t(header.symbol_count) * sizeof(IndexEntry);
+    if (header.index_offset % 8 != 0 || header.index_offset > size || index_bytes > size - header.index_offset ||
+        header.names_offset > header.index_offset) {
+        return fail("corrupt index");
+    }
+
+    index_ = reinterpret_cast<const IndexEntry*>(file_.data() + header.index_offset);
+    names_ = file_.data() + header.names_offset;
+    count_ = header.symbol_count;
+
+    // Validate every entry once so lookups never read outside the mapping
+    for (size_t i = 0; i < count_; ++i) {
+        const IndexEntry& e = index_[i];
+        const uint64_t names_bytes = header.index_offset - header.names_offset;
+        if (e.name_offset > names_bytes || e.name_length > names_bytes - e.name_offset ||
+            e.data_offset % 8 != 0 || e.data_offset > header.names_offset || e.rows > size / kRowBytes ||
+            block_size(e.rows) > header.names_offset - e.data_offset) {
+            count_ = 0;
+            return fail("corrupt entry " + std::to_string(i));
+        }
+    }
+
+    return true;
+}
+
+std::string_view BarStore::name_of(const IndexEntry& entry) const {
+    return std::string_view(names_ + entry.name_offset, entry.name_length);
+}
+
+BarView BarStore::at(size_t i) const {
+    const IndexEntry& e = index_[i];
+    const char* base = file_.data() + e.data_offset;
+    size_t rows = e.rows;
+
+    const int32_t* date = reinterpret_cast<const int32_t*>(base);
+    const double* open = reinterpret_cast<const double*>(base + align8(rows * sizeof(int32_t)));
+    const double* high = open + rows;
+    const double* low = high + rows;
+    const double* close = low + rows;
+    const double* adj_close = close + rows;
+    const int64_t* volume = reinterpret_cast<const int64_t*>(adj_close + rows);
+    return BarView{name_of(e), {date, rows}, {open, rows}, {high, rows}, {low, rows},
+                   {close, rows}, {adj_close, rows}, {volume, rows}};
+}
+
+std::optional<BarView> BarStore::find(std::string_view symbol) const {
+    const IndexEntry* end = index_ + count_;
+    const IndexEntry* it = std::lower_bound(index_, end, symbol,
+        [this](const IndexEntry& e, std::string_view s) { return name_of(e) < s; });
+    if (it == end || name_of(*it) != symbol) {
+        return std::nullopt;
+    }
+    return at(static_cast<size_t>(it - index_));
+}
+
+} // namespace quant
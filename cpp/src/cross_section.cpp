@@ -0,0 +1,101 @@
+#include "cross_section.h"
+#include <cmath>
+#include <memory_resource>
+#include "arena.h"
+#include "ranking.h"
+#include "simd.h"
+
+namespace signals {
+
+namespace {
+    struct Moments {
+        double mean = 0.0;
+        double std = 0.0;
+    };
+
+    Moments moments(const double* values, size_t n) {
+        Moments m;
+        if (n == 0) return m;
+        m.mean = quant::simd::sum(values, n) / n;
+        m.std = std::sqrt(quant::simd::sum_sq_dev(values, n, m.mean) / n);
+        return m;
+    }
+
+    // Percentiles and z-scores of one packed column, scattered back to the
+    // input rows listed in `rows`
+    void score_column(const double* values, const uint32_t* rows, size_t m, const Moments& moments,
+                      float* keys, uint64_t* sorted, double* ranks,
+                      std::pmr::vector<double>& percentile, std::pmr::vector<double>& zscore) {
+        for (size_t i = 0; i < m; ++i) keys[i] = static_cast<float>(values[i]);
+        quant::rank(keys, m, sorted, ranks);
+        double scale = m > 1 ? 100.0 / (m - 1) : 0.0;
+        double inv_std = moments.std > 0.0 ? 1.0 / moments.std : 0.0;
+        for (size_t i = 0; i < m; ++i) {
+            percentile[rows[i]] = m > 1 ? ranks[i] * scale : 50.0;
+            zscore[rows[i]] = (values[i] - moments.mean) * inv_std;
+        }
+    }
+
+    // Fills `out`, which must already hold n rows of NaN / 0; the caller
+    // allocates it before the scratch scope opens
+    void compute(const double* monthly_return, const double* volatility, const uint8_t* valid, size_t n,
+                 CrossSection& out) {
+        quant::ArenaScope scope;
+        std::pmr::vector<double> returns(n, scope.resource()), vols(n, scope.resource());
+        std::pmr::vector<uint32_t> rows(n, scope.resource());
+
+        size_t m = 0;
+        for (size_t i = 0; i < n; ++i) {
+            returns[m] = monthly_return[i];
+            vols[m] = volatility[i];
+            rows[m] = static_cast<uint32_t>(i);
+            m += valid[i] && std::isfinite(monthly_return[i]) && std::isfinite(volatility[i]);
+        }
+        out.scored = m;
+        if (m == 0) return;
+
+        Moments ret = moments(returns.data(), m);
+        Moments vol = moments(vols.data(), m);
+        out.return_mean = ret.mean;
+        out.return_std = ret.std;
+        out.volatility_mean = vol.mean;
+        out.volatility_std = vol.std;
+
+        std::pmr::vector<float> keys(m, scope.resource());
+        std::pmr::vector<uint64_t> sorted(m, scope.resource());
+        std::pmr::vector<double> ranks(m, scope.resource());
+        score_column(vols.data(), rows.data(), m, vol, keys.data(), sorted.data(), ranks.data(),
+                     out.volatility_percentile, out.volatility_zscore);
+        score_column(returns.data(), rows.data(), m, ret, keys.data(), sorted.data(), ranks.data(),
+                     out.return_percentile, out.return_zscore);
+
+        // Deciles bucket by average rank, as the backtest does by sorted position
+        for (size_t i = 0; i < m; ++i) {
+            out.return_decile[rows[i]] = static_cast<uint8_t>(1 + static_cast<size_t>(ranks[i] * 10 / m));
+        }
+    }
+
+    CrossSection allocate(size_t n, std::pmr::memory_resource* resource) {
+        CrossSection out(resource);
+        out.return_percentile.assign(n, NAN);
+        out.return_zscore.assign(n, NAN);
+        out.volatility_percentile.assign(n, NAN);
+        out.volatility_zscore.assign(n, NAN);
+        out.return_decile.assign(n, 0);
+        return out;
+    }
+}
+
+CrossSection cross_section(const double* monthly_return, const double* volatility, const uint8_t* valid,
+                           size_t n, std::pmr::memory_resource* resource) {
+    CrossSection out = allocate(n, resource);
+    compute(monthly_return, volatility, valid, n, out);
+    return out;
+}
+
+CrossSection cross_section(const SignalColumns& columns, std::pmr::memory_resource* resource) {
+    return cross_section(columns.monthly_return.data(), columns.volatility.data(), columns.valid.data(),
+                         columns.valid.size(), resource);
+}
+
+} // namespace signals
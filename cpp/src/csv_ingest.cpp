@@ -0,0 +1,209 @@
+#include "../include/csv_ingest.h"
+#include "../include/dates.h"
+#include "../include/mapped_file.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace quant {
+
+namespace {
+    // Below this size a single thread is faster than spawning workers
+    constexpr size_t kMinBytesPerThread = 1 << 20;
+
+    constexpr int kFieldCount = 8;
+
+    struct Chunk {
+        const char* begin;
+        const char* end;
+    };
+
+    std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+        return s;
+    }
+
+    bool parse_double(std::string_view s, double& out) {
+        s = trim(s);
+        if (!s.empty() && s.front() == '+') s.remove_prefix(1);
+        if (s.empty()) return false;
+        auto res = std::from_chars(s.data(), s.data() + s.size(), out);
+        return res.ec == std::errc();
+    }
+
+    int64_t parse_volume(std::string_view s) {
+        s = trim(s);
+        int64_t v = 0;
+        auto res = std::from_chars(s.data(), s.data() + s.size(), v);
+        if (res.ec == std::errc() && res.ptr == s.data() + s.size()) return v;
+        double d = 0.0;
+        return parse_double(s, d) && std::isfinite(d) ? static_cast<int64_t>(d) : 0;
+    }
+
+    // Calls fn(line) for every non-empty line in [begin, end), without the newline
+    template <class F>
+    void for_each_line(const char* begin, const char* end, F&& fn) {
+        const char* p = begin;
+        while (p < end) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            const char* line_end = nl ? nl : end;
+            std::string_view line(p, line_end - p);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (!line.empty()) fn(line);
+            p = nl ? nl + 1 : end;
+        }
+    }
+
+    // First comma-separated field, i.e. the symbol
+    std::string_view symbol_of(std::string_view line) {
+        size_t comma = line.find(',');
+        return comma == std::string_view::npos ? line : line.substr(0, comma);
+    }
+
+    std::vector<Chunk> split_lines(const char* begin, const char* end, unsigned parts) {
+        std::vector<Chunk> chunks;
+        size_t total = end - begin;
+        const char* start = begin;
+        for (unsigned i = 1; i <= parts && start < end; ++i) {
+            const char* stop = i == parts ? end : begin + total * i / parts;
+            if (stop < start) stop = start;
+            // extend to the end of the current line
+            while (stop < end && stop[-1] != '\n') ++stop;
+            chunks.push_back({start, stop});
+            start = stop;
+        }
+        return chunks;
+    }
+
+    struct Cursor {
+        BarSeries* columns;
+        size_t pos;
+    };
+
+    struct Invalid {
+        BarSeries* columns;
+        size_t pos;
+    };
+}
+
+PriceTable parse_price_csv(std::string_view text, unsigned threads) {
+    PriceTable table;
+
+    // skip header
+    size_t header_end = text.find('\n');
+    if (header_end == std::string_view::npos) return table;
+    const char* begin = text.data() + header_end + 1;
+    const char* end = text.data() + text.size();
+
+    threads = resolve_threads(threads);
+    size_t max_useful = std::max<size_t>(1, (end - begin) / kMinBytesPerThread);
+    unsigned parts = static_cast<unsigned>(std::min<size_t>(threads, max_useful));
+    auto chunks = split_lines(begin, end, parts);
+    if (chunks.empty()) return table;
+
+    // Pass 1: rows per symbol per chunk
+    std::vector<std::unordered_map<std::string_view, size_t>> counts(chunks.size());
+    parallel_for(chunks.size(), static_cast<unsigned>(chunks.size()), [&](size_t c) {
+        for_each_line(chunks[c].begin, chunks[c].end, [&](std::string_view line) {
+            ++counts[c][symbol_of(line)];
+        });
+    });
+
+    // Assign each chunk a contiguous slice of every symbol's columns, in file order
+    std::vector<std::unordered_map<std::string_view, Cursor>> cursors(chunks.size());
+    std::unordered_map<std::string_view, std::pair<BarSeries*, size_t>> totals;
+    for (size_t c = 0; c < chunks.size(); ++c) {
+        for (const auto& [symbol, count] : counts[c]) {
+            auto& total = totals[symbol];
+            if (!total.first) total.first = &table.symbols[std::string(symbol)];
+            cursors[c].emplace(symbol, Cursor{total.first, total.second});
+            total.second += count;
+        }
+        counts[c] = {};
+    }
+    for (auto& [symbol, total] : totals) {
+        total.first->resize(total.second);
+    }
+
+    // Pass 2: parse every row straight into its final slot
+    std::vector<std::vector<Invalid>> invalid(chunks.size());
+    parallel_for(chunks.size(), static_cast<unsigned>(chunks.size()), [&](size_t c) {
+        auto& chunk_cursors = cursors[c];
+        for_each_line(chunks[c].begin, chunks[c].end, [&](std::string_view line) {
+            std::string_view fields[kFieldCount];
+            int n = 0;
+            size_t start = 0;
+            while (n < kFieldCount) {
+                size_t comma = line.find(',', start);
+                fields[n++] = line.substr(start, comma == std::string_view::npos ? std::string_view::npos : comma - start);
+                if (comma == std::string_view::npos) break;
+                start = comma + 1;
+            }
+
+            Cursor& cursor = chunk_cursors.find(fields[0])->second;
+            BarSeries& cols = *cursor.columns;
+            size_t pos = cursor.pos++;
+
+            double close = NAN;
+            if (n < 6 || !parse_double(fields[5], close)) {
+                invalid[c].push_back({cursor.columns, pos});
+                return;
+            }
+
+            double value = NAN;
+            cols.date[pos] = n > 1 ? parse_date(trim(fields[1])) : kInvalidDate;
+            cols.open[pos] = n > 2 && parse_double(fields[2], value) ? value : NAN;
+            cols.high[pos] = n > 3 && parse_double(fields[3], value) ? value : NAN;
+            cols.low[pos] = n > 4 && parse_double(fields[4], value) ? value : NAN;
+            cols.close[pos] = close;
+            cols.adj_close[pos] = n > 6 && parse_double(fields[6], value) ? value : close;
+            cols.volume[pos] = n > 7 ? parse_volume(fields[7]) : 0;
+        });
+    });
+
+    // Drop rows whose close failed to parse, keeping the rest in order
+    std::unordered_map<BarSeries*, std::vector<size_t>> holes;
+    for (auto& chunk_invalid : invalid) {
+        for (const auto& bad : chunk_invalid) holes[bad.columns].push_back(bad.pos);
+        table.skipped += chunk_invalid.size();
+    }
+    for (auto& [cols, positions] : holes) {
+        std::sort(positions.begin(), positions.end());
+        size_t out = positions.front();
+        size_t next_hole = 0;
+        for (size_t i = positions.front(); i < cols->size(); ++i) {
+            if (next_hole < positions.size() && positions[next_hole] == i) { ++next_hole; continue; }
+            cols->move_row(i, out++);
+        }
+        cols->resize(out);
+    }
+    for (auto it = table.symbols.begin(); it != table.symbols.end();) {
+        if (it->second.empty()) {
+            it = table.symbols.erase(it);
+        } else {
+            table.rows += it->second.size();
+            ++it;
+        }
+    }
+
+    return table;
+}
+
+PriceTable load_price_csv(const std::string& path, unsigned threads) {
+    MappedFile file;
+    std::string error;
+    if (!file.open(path, error)) {
+        PriceTable table;
+        table.error = error;
+        return table;
+    }
+    file.advise_sequential();
+    return parse_price_csv(file.view(), threads);
+}
+
+} // namespace quant
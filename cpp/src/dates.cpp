@@ -0,0 +1,42 @@
+#include "../include/dates.h"
+#include <cstdio>
+
+namespace quant {
+
+int32_t parse_date(std::string_view text) {
+    if (text.size() != 10 || text[4] != '-' || text[7] != '-') return kInvalidDate;
+    int fields[3] = {0, 0, 0};
+    const int starts[3] = {0, 5, 8};
+    const int lengths[3] = {4, 2, 2};
+    for (int f = 0; f < 3; ++f) {
+        for (int i = 0; i < lengths[f]; ++i) {
+            char c = text[starts[f] + i];
+            if (c < '0' || c > '9') return kInvalidDate;
+            fields[f] = fields[f] * 10 + (c - '0');
+        }
+    }
+    if (fields[1] < 1 || fields[1] > 12 || fields[2] < 1 || fields[2] > days_in_month(fields[0], fields[1])) {
+        return kInvalidDate;
+    }
+    return days_from_civil(fields[0], fields[1], fields[2]);
+}
+
+std::string format_date(int32_t days) {
+    if (days == kInvalidDate) return "";
+    // civil_from_days (inverse of days_from_civil)
+    int64_t z = static_cast<int64_t>(days) + 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    const int64_t y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%04lld-%02u-%02u", static_cast<long long>(y), m, d);
+    return buf;
+}
+
+} // namespace quant
@@ -0,0 +1,152 @@
+#include "http_cache.h"
+#include <charconv>
+#include <cstdio>
+#include <zlib.h>
+
+namespace http {
+
+namespace {
+    std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+        return s;
+    }
+
+    std::string_view strip_weak(std::string_view tag) {
+        tag = trim(tag);
+        if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+        return tag;
+    }
+
+    bool iequals(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            char x = a[i] >= 'A' && a[i] <= 'Z' ? a[i] - 'A' + 'a' : a[i];
+            char y = b[i] >= 'A' && b[i] <= 'Z' ? b[i] - 'A' + 'a' : b[i];
+            if (x != y) return false;
+        }
+        return true;
+    }
+
+    // Calls fn(item) for each comma-separated item, trimmed
+    template <class F>
+    void for_each_item(std::string_view list, F&& fn) {
+        while (!list.empty()) {
+            size_t comma = list.find(',');
+            fn(trim(list.substr(0, comma)));
+            if (comma == std::string_view::npos) break;
+            list.remove_prefix(comma + 1);
+        }
+    }
+}
+
+CachedBody CachedBody::make(std::string body, bool precompress) {
+    CachedBody cached;
+    cached.etag = content_etag(body);
+    if (precompress) {
+        cached.gzip = compress(body, Encoding::Gzip);
+        cached.deflate = compress(body, Encoding::Deflate);
+    }
+    cached.identity = std::move(body);
+    return cached;
+}
+
+CachedBody CachedBody::make_for(std::string body, Encoding encoding) {
+    CachedBody cached = make(std::move(body), false);
+    if (encoding == Encoding::Gzip) cached.gzip = compress(cached.identity, Encoding::Gzip);
+    if (encoding == Encoding::Deflate) cached.deflate = compress(cached.identity, Encoding::Deflate);
+    return cached;
+}
+
+Encoding CachedBody::available(Encoding encoding) const {
+    if (encoding == Encoding::Gzip && !gzip.empty()) return Encoding::Gzip;
+    if (encoding == Encoding::Deflate && !deflate.empty()) return Encoding::Deflate;
+    return Encoding::Identity;
+}
+
+const std::string& CachedBody::encoded(Encoding encoding) const {
+    switch (available(encoding)) {
+        case Encoding::Gzip: return gzip;
+        case Encoding::Deflate: return deflate;
+        default: return identity;
+    }
+}
+
+std::string CachedBody::etag_for(Encoding encoding) const {
+    encoding = available(encoding);
+    if (encoding == Encoding::Identity || etag.size() < 2) return etag;
+    return etag.substr(0, etag.size() - 1) + "-" + encoding_name(encoding) + "\"";
+}
+
+std::string content_etag(std::string_view body) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : body) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "\"%016llx\"", static_cast<unsigned long long>(hash));
+    return buf;
+}
+
+bool etag_matches(std::string_view if_none_match, std::string_view etag) {
+    bool matched = false;
+    for_each_item(if_none_match, [&](std::string_view tag) {
+        matched = matched || tag == "*" || strip_weak(tag) == strip_weak(etag);
+    });
+    return matched;
+}
+
+Encoding negotiate_encoding(std::string_view accept_encoding) {
+    // q-values for gzip, deflate and "*"; negative = not listed
+    double gzip_q = -1, deflate_q = -1, any_q = -1;
+    for_each_item(accept_encoding, [&](std::string_view item) {
+        std::string_view name = trim(item.substr(0, item.find(';')));
+        double q = 1.0;
+        size_t q_pos = item.find("q=");
+        if (q_pos != std::string_view::npos) {
+            std::string_view value = trim(item.substr(q_pos + 2));
+            std::from_chars(value.data(), value.data() + value.size(), q);
+        }
+        if (iequals(name, "gzip") || iequals(name, "x-gzip")) gzip_q = q;
+        else if (iequals(name, "deflate")) deflate_q = q;
+        else if (name == "*") any_q = q;
+    });
+    if (gzip_q < 0) gzip_q = any_q;
+    if (deflate_q < 0) deflate_q = any_q;
+    if (gzip_q > 0 && gzip_q >= deflate_q) return Encoding::Gzip;
+    if (deflate_q > 0) return Encoding::Deflate;
+    return Encoding::Identity;
+}
+
+const char* encoding_name(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::Gzip: return "gzip";
+        case Encoding::Deflate: return "deflate";
+        default: return "";
+    }
+}
+
+std::string compress(std::string_view data, Encoding encoding) {
+    if (encoding == Encoding::Identity) return std::string(data);
+
+    z_stream stream{};
+    // windowBits 15 + 16 selects the gzip wrapper; plain 15 is zlib (HTTP "deflate")
+    int window_bits = encoding == Encoding::Gzip ? 15 + 16 : 15;
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return "";
+    }
+
+    std::string out(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    int rc = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return rc == Z_STREAM_END ? out : std::string();
+}
+
+} // namespace http
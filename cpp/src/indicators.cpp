@@ -1,4 +1,5 @@
 #include "../include/indicators.h"
+#include "../include/simd.h"
 #include <cmath>
 #include <numeric>
 #include <optional>
@@ -6,14 +7,12 @@
 
 namespace quant {
 
-double sma(const std::vector<double>& data, int period) {
+double sma(Span<const double> data, int period) {
     if ((int)data.size() < period || period <= 0) return NAN;
-    double sum = 0.0;
-    for (int i = data.size() - period; i < (int)data.size(); ++i) sum += data[i];
-    return sum / period;
+    return simd::sum(data.data() + data.size() - period, period) / period;
 }
 
-double ema(const std::vector<double>& data, int period) {
+double ema(Span<const double> data, int period) {
     if ((int)data.size() < period || period <= 0) return NAN;
     double k = 2.0 / (period + 1.0);
     // initialize with sma of first period
@@ -26,42 +25,33 @@ double ema(const std::vector<double>& data, int period) {
     return ema_val;
 }
 
-double realized_vol(const std::vector<double>& returns) {
+double realized_vol(Span<const double> returns) {
     if (returns.empty()) return NAN;
-    double mean = 0.0;
-    for (double r : returns) mean += r;
-    mean /= returns.size();
-    double sumsq = 0.0;
-    for (double r : returns) sumsq += (r - mean) * (r - mean);
+    double mean = simd::sum(returns.data(), returns.size()) / returns.size();
+    double sumsq = simd::sum_sq_dev(returns.data(), returns.size(), mean);
     double variance = sumsq / (returns.size() - 1 > 0 ? returns.size() - 1 : 1);
     return std::sqrt(variance);
 }
 
-std::optional<double> slope_logprice(const std::vector<double>& prices) {
+std::optional<double> slope_logprice(Span<const double> prices) {
     int n = prices.size();
     if (n < 2) return std::nullopt;
-    std::vector<double> x(n), y(n);
-    for (int i = 0; i < n; ++i) {
-        x[i] = i;
-        y[i] = std::log(prices[i]);
-    }
-    double x_mean = 0.0;
-    for (double xi : x) x_mean += xi;
-    x_mean /= n;
+    // x = 0..n-1, so its mean is known; log prices are computed once
+    double x_mean = (n - 1) / 2.0;
     double y_mean = 0.0;
-    for (double yi : y) y_mean += yi;
+    for (int i = 0; i < n; ++i) y_mean += std::log(prices[i]);
     y_mean /= n;
     double num = 0.0, den = 0.0;
     for (int i = 0; i < n; ++i) {
-        num += (x[i] - x_mean) * (y[i] - y_mean);
-        den += (x[i] - x_mean) * (x[i] - x_mean);
+        num += (i - x_mean) * (std::log(prices[i]) - y_mean);
+        den += (i - x_mean) * (i - x_mean);
     }
     if (den == 0.0) return std::nullopt;
     return num / den;
 }
 
-double atr(const std::vector<double>& high, const std::vector<double>& low, const std::vector<double>& close, int period) {
-    int n = close.size();
+double atr(Span<const double> high, Span<const double> low, Span<const double> close, int period) {
+    int n = std::min({high.size(), low.size(), close.size()});
     if (n < period + 1) return NAN;
     std::vector<double> trs;
     trs.reserve(n-1);
@@ -74,14 +64,12 @@ double atr(const std::vector<double>& high, const std::vector<double>& low, cons
     }
     // simple moving average of TRs over last 'period' days
     if ((int)trs.size() < period) return NAN;
-    double sum = 0.0;
-    for (int i = trs.size() - period; i < (int)trs.size(); ++i) sum += trs[i];
-    return sum / period;
+    return simd::sum(trs.data() + trs.size() - period, period) / period;
 }
 
-double rsi(const std::vector<double>& closes, int period) {
+double rsi(Span<const double> closes, int period) {
     int n = closes.size();
-    if (n <= period) return NAN;
+    if (period <= 0 || n <= period) return NAN;
     double gain = 0.0, loss = 0.0;
     for (int i = 1; i <= period; ++i) {
         double diff = closes[i] - closes[i-1];
@@ -94,7 +82,31 @@ double rsi(const std::vector<double>& closes, int period) {
     return 100.0 - (100.0 / (1.0 + rs));
 }
 
-double max_drawdown(const std::vector<double>& prices) {
+double rsi_wilder(Span<const double> closes, int period) {
+    int n = closes.size();
+    if (period <= 0 || n <= period) return NAN;
+    // seed with the simple average of the first 'period' changes
+    double gain = 0.0, loss = 0.0;
+    for (int i = 1; i <= period; ++i) {
+        double diff = closes[i] - closes[i-1];
+        if (diff > 0) gain += diff; else loss += -diff;
+    }
+    gain /= period;
+    loss /= period;
+    // Wilder smoothing over the rest of the series
+    for (int i = period + 1; i < n; ++i) {
+        double diff = closes[i] - closes[i-1];
+        double g = diff > 0 ? diff : 0.0;
+        double l = diff > 0 ? 0.0 : -diff;
+        gain = (gain * (period - 1) + g) / period;
+        loss = (loss * (period - 1) + l) / period;
+    }
+    if (loss == 0) return 100.0;
+    double rs = gain / loss;
+    return 100.0 - (100.0 / (1.0 + rs));
+}
+
+double max_drawdown(Span<const double> prices) {
     if (prices.empty()) return 0.0;
     double peak = prices[0];
     double maxdd = 0.0;
@@ -106,4 +118,123 @@ double max_drawdown(const std::vector<double>& prices) {
     return maxdd;
 }
 
+namespace {
+    inline double true_range(const double* high, const double* low, const double* close, size_t i) {
+        double prev_close = close[i-1];
+        return std::max({high[i] - low[i], std::abs(high[i] - prev_close), std::abs(low[i] - prev_close)});
+    }
+
+    void fill_nan(double* out, size_t from, size_t to) {
+        for (size_t i = from; i < to; ++i) out[i] = NAN;
+    }
+}
+
+void sma_series(const double* data, size_t n, int period, double* out) {
+    size_t p = period > 0 ? period : 0;
+    if (p == 0 || n < p) { fill_nan(out, 0, n); return; }
+    fill_nan(out, 0, p - 1);
+    // sliding window sum, re-summed exactly once per window to bound drift
+    double window = simd::sum(data, p);
+    out[p-1] = window / period;
+    size_t since_resum = 0;
+    for (size_t i = p; i < n; ++i) {
+        if (++since_resum == p) {
+            window = simd::sum(data + i + 1 - p, p);
+            since_resum = 0;
+        } else {
+            window += data[i] - data[i-p];
+        }
+        out[i] = window / period;
+    }
+}
+
+void ema_series(const double* data, size_t n, int period, double* out) {
+    size_t p = period > 0 ? period : 0;
+    if (p == 0 || n < p) { fill_nan(out, 0, n); return; }
+    fill_nan(out, 0, p - 1);
+    double k = 2.0 / (period + 1.0);
+    double ema_val = 0.0;
+    for (size_t i = 0; i < p; ++i) ema_val += data[i];
+    ema_val /= period;
+    out[p-1] = ema_val;
+    for (size_t i = p; i < n; ++i) {
+        ema_val = data[i] * k + ema_val * (1.0 - k);
+        out[i] = ema_val;
+    }
+}
+
+void rsi_series(const double* closes, size_t n, int period, double* out) {
+    size_t p = period > 0 ? period : 0;
+    if (p == 0 || n <= p) { fill_nan(out, 0, n); return; }
+    fill_nan(out, 0, p);
+    auto rsi_of = [](double gain, double loss) {
+        if (loss == 0) return 100.0;
+        return 100.0 - (100.0 / (1.0 + gain / loss));
+    };
+    double gain = 0.0, loss = 0.0;
+    for (size_t i = 1; i <= p; ++i) {
+        double diff = closes[i] - closes[i-1];
+        if (diff > 0) gain += diff; else loss += -diff;
+    }
+    gain /= period;
+    loss /= period;
+    out[p] = rsi_of(gain, loss);
+    for (size_t i = p + 1; i < n; ++i) {
+        double diff = closes[i] - closes[i-1];
+        double g = diff > 0 ? diff : 0.0;
+        double l = diff > 0 ? 0.0 : -diff;
+        gain = (gain * (period - 1) + g) / period;
+        loss = (loss * (period - 1) + l) / period;
+        out[i] = rsi_of(gain, loss);
+    }
+}
+
+void atr_series(const double* high, const double* low, const double* close, size_t n, int period, double* out) {
+    size_t p = period > 0 ? period : 0;
+    if (p == 0 || n < p + 1) { fill_nan(out, 0, n); return; }
+    fill_nan(out, 0, p);
+    auto window_sum = [&](size_t last) {
+        double sum = 0.0;
+        for (size_t j = last + 1 - p; j <= last; ++j) sum += true_range(high, low, close, j);
+        return sum;
+    };
+    double window = window_sum(p);
+    out[p] = window / period;
+    size_t since_resum = 0;
+    for (size_t i = p + 1; i < n; ++i) {
+        if (++since_resum == p) {
+            window = window_sum(i);
+            since_resum = 0;
+        } else {
+            window += true_range(high, low, close, i) - true_range(high, low, close, i - p);
+        }
+        out[i] = window / period;
+    }
+}
+
+std::vector<double> sma_series(const std::vector<double>& data, int period) {
+    std::vector<double> out(data.size());
+    sma_series(data.data(), data.size(), period, out.data());
+    return out;
+}
+
+std::vector<double> ema_series(const std::vector<double>& data, int period) {
+    std::vector<double> out(data.size());
+    ema_series(data.data(), data.size(), period, out.data());
+    return out;
+}
+
+std::vector<double> rsi_series(const std::vector<double>& closes, int period) {
+    std::vector<double> out(closes.size());
+    rsi_series(closes.data(), closes.size(), period, out.data());
+    return out;
+}
+
+std::vector<double> atr_series(const std::vector<double>& high, const std::vector<double>& low, const std::vector<double>& close, int period) {
+    size_t n = std::min({high.size(), low.size(), close.size()});
+    std::vector<double> out(n);
+    atr_series(high.data(), low.data(), close.data(), n, period, out.data());
+    return out;
+}
+
 } // namespace quant
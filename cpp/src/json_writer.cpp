@@ -0,0 +1,155 @@
+#include "json_writer.h"
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+// append_number relies on nlohmann::detail::to_chars, which is not public
+// API; re-check the output against dump() before moving off the pinned
+// version (see CMakeLists.txt)
+static_assert(NLOHMANN_JSON_VERSION_MAJOR == 3 && NLOHMANN_JSON_VERSION_MINOR == 11,
+              "JsonWriter is verified against nlohmann/json 3.11 only");
+
+namespace http {
+
+namespace {
+    // Length of the UTF-8 sequence starting at s[i], or 0 if it is invalid
+    // (overlong forms, surrogates and code points past U+10FFFF included)
+    size_t utf8_length(std::string_view s, size_t i) {
+        auto byte = [&s](size_t j) { return static_cast<unsigned char>(s[j]); };
+        auto continuation = [&](size_t j, unsigned char lo = 0x80, unsigned char hi = 0xBF) {
+            return j < s.size() && byte(j) >= lo && byte(j) <= hi;
+        };
+        unsigned char lead = byte(i);
+        if (lead >= 0xC2 && lead <= 0xDF) return continuation(i + 1) ? 2 : 0;
+        if (lead >= 0xE0 && lead <= 0xEF) {
+            unsigned char lo = lead == 0xE0 ? 0xA0 : 0x80, hi = lead == 0xED ? 0x9F : 0xBF;
+            return continuation(i + 1, lo, hi) && continuation(i + 2) ? 3 : 0;
+        }
+        if (lead >= 0xF0 && lead <= 0xF4) {
+            unsigned char lo = lead == 0xF0 ? 0x90 : 0x80, hi = lead == 0xF4 ? 0x8F : 0xBF;
+            return continuation(i + 1, lo, hi) && continuation(i + 2) && continuation(i + 3) ? 4 : 0;
+        }
+        return 0;
+    }
+}
+
+void JsonWriter::append_number(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    // dump()'s own Grisu2 formatter: its digits are not always the
+    // shortest, so a different shortest-digit algorithm would drift
+    char buf[64];
+    char* end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, end - buf);
+}
+
+void JsonWriter::append_string(std::string& out, std::string_view value) {
+    out += '"';
+    size_t run = 0;     // start of the pending run of bytes copied verbatim
+    auto flush = [&](size_t end) { out.append(value.data() + run, end - run); };
+    for (size_t i = 0; i < value.size();) {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\' && c < 0x80) {
+            ++i;
+            continue;
+        }
+        if (c >= 0x80) {
+            size_t len = utf8_length(value, i);
+            if (len > 0) {
+                i += len;
+                continue;
+            }
+        }
+        flush(i);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    static const char hex[] = "0123456789abcdef";
+                    char escape[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                    out.append(escape, sizeof(escape));
+                } else {
+                    out += "\xEF\xBF\xBD";      // invalid UTF-8 byte
+                }
+        }
+        run = ++i;
+    }
+    flush(value.size());
+    out += '"';
+}
+
+void JsonWriter::separate() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    uint64_t bit = uint64_t(1) << depth_;
+    if (has_items_ & bit) out_ += ',';
+    has_items_ |= bit;
+}
+
+void JsonWriter::open(char bracket) {
+    // has_items_ holds one bit per depth
+    if (depth_ >= kMaxDepth) throw std::length_error("JSON nested deeper than " + std::to_string(kMaxDepth) + " levels");
+    separate();
+    out_ += bracket;
+    ++depth_;
+    has_items_ &= ~(uint64_t(1) << depth_);
+}
+
+void JsonWriter::close(char bracket) {
+    --depth_;
+    out_ += bracket;
+}
+
+void JsonWriter::key(std::string_view name) {
+    separate();
+    append_string(out_, name);
+    out_ += ':';
+    after_key_ = true;
+}
+
+void JsonWriter::string(std::string_view value) {
+    separate();
+    append_string(out_, value);
+}
+
+void JsonWriter::number(double value) {
+    separate();
+    append_number(out_, value);
+}
+
+void JsonWriter::integer(int64_t value) {
+    separate();
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    out_.append(buf, result.ptr - buf);
+}
+
+void JsonWriter::uinteger(uint64_t value) {
+    separate();
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    out_.append(buf, result.ptr - buf);
+}
+
+void JsonWriter::boolean(bool value) {
+    separate();
+    out_ += value ? "true" : "false";
+}
+
+void JsonWriter::null() {
+    separate();
+    out_ += "null";
+}
+
+} // namespace http
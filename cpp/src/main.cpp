@@ -1,64 +1,103 @@
 #include <iostream>
-#include <fstream>
 #include <sstream>
 #include <string>
 #include <vector>
-#include <map>
-#include "../include/indicators.h"
+#include "../include/fused.h"
+#include "../include/csv_ingest.h"
+#include "../include/bar_store.h"
+#include "../include/parallel.h"
 
-// Simple CSV reader for price data (expects header with symbol,date,open,high,low,close,adj_close,volume)
-struct Row { std::string symbol; std::string date; double close; double volume; };
+// Indicators in the feature CSV, evaluated in one pass per symbol
+using FeatureKernel = quant::fused::Kernel<quant::fused::Sma<50>, quant::fused::Sma<200>, quant::fused::Ema<20>,
+                                           quant::fused::Slope<20>, quant::fused::Vol<20>>;
+
+// Feature row for one symbol, or an empty string if history is too short
+static std::string feature_row(const std::string& sym, quant::Span<const double> prices) {
+    if (prices.size() < 60) return ""; // need minimum history
+    FeatureKernel k(prices);
+    double ma50 = k.get<quant::fused::Sma<50>>();
+    double ma200 = k.get<quant::fused::Sma<200>>();
+    double ema20 = k.get<quant::fused::Ema<20>>();
+    double slope20 = k.get<quant::fused::Slope<20>>();
+    double rv20 = k.get<quant::fused::Vol<20>>();
+    std::ostringstream out;
+    out << sym << "," << "TODAY" << "," << prices.back() << ","
+        << ma50 << "," << ma200 << "," << ema20 << "," << slope20 << "," << rv20 << "\n";
+    return out.str();
+}
 
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cerr << "Usage: quant_core <prices.csv>\n";
+    const char* usage = "Usage: quant_core [--threads N] [--write-store out.qbars] <prices.csv|prices.qbars>\n";
+    unsigned threads = 0;   // 0 = all cores
+    std::string path;
+    std::string store_out;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            try { threads = static_cast<unsigned>(std::stoul(argv[++i])); }
+            catch (...) { std::cerr << usage; return 1; }
+        } else if (arg == "--write-store" && i + 1 < argc) {
+            store_out = argv[++i];
+        } else if (path.empty()) {
+            path = arg;
+        } else {
+            std::cerr << usage;
+            return 1;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << usage;
         return 1;
     }
-    std::string path = argv[1];
-    std::ifstream in(path);
-    if (!in) { std::cerr << "Cannot open " << path << "\n"; return 2; }
-    std::string line;
-    // read header
-    std::getline(in, line);
-    std::map<std::string, std::vector<double>> close_map;
-    while (std::getline(in, line)) {
-        std::stringstream ss(line);
-        std::string symbol, date, open, high, low, close, adj, vol;
-        std::getline(ss, symbol, ',');
-        std::getline(ss, date, ',');
-        std::getline(ss, open, ',');
-        std::getline(ss, high, ',');
-        std::getline(ss, low, ',');
-        std::getline(ss, close, ',');
-        std::getline(ss, adj, ',');
-        std::getline(ss, vol, ',');
-        try {
-            double c = std::stod(close);
-            close_map[symbol].push_back(c);
-        } catch(...) { continue; }
+
+    // Either a binary bar store (mapped, no parsing) or a CSV with header
+    // symbol,date,open,high,low,close,adj_close,volume
+    quant::BarStore store;
+    quant::PriceTable table;
+    bool from_store = quant::BarStore::is_bar_store(path);
+    if (from_store) {
+        std::string error;
+        if (!store.open(path, error)) { std::cerr << error << "\n"; return 2; }
+    } else {
+        table = quant::load_price_csv(path, threads);
+        if (!table.ok()) { std::cerr << table.error << "\n"; return 2; }
     }
 
-    // print CSV header for features
-    std::cout << "symbol,as_of,close,ma50,ma200,ema20,slope20,rv20\n";
-    for (auto &kv : close_map) {
-        const std::string &sym = kv.first;
-        const std::vector<double> &prices = kv.second;
-        int n = prices.size();
-        if (n < 60) continue; // need minimum history
-        double ma50 = quant::sma(prices, 50);
-        double ma200 = quant::sma(prices, 200);
-        double ema20 = quant::ema(prices, 20);
-        std::vector<double> returns20;
-        for (int i = n-20; i < n; ++i) {
-            if (i==0) continue;
-            returns20.push_back((prices[i] - prices[i-1]) / prices[i-1]);
+    if (!store_out.empty()) {
+        if (from_store) { std::cerr << "--write-store expects a CSV input\n"; return 1; }
+        std::string error;
+        if (!quant::BarStore::write(store_out, table.symbols, error)) { std::cerr << error << "\n"; return 2; }
+    }
+
+    std::vector<std::string> symbols;
+    std::vector<quant::Span<const double>> closes;
+    if (from_store) {
+        symbols.reserve(store.size());
+        closes.reserve(store.size());
+        for (size_t i = 0; i < store.size(); ++i) {
+            auto view = store.at(i);
+            symbols.emplace_back(view.symbol);
+            closes.push_back(view.close);
+        }
+    } else {
+        symbols.reserve(table.symbols.size());
+        closes.reserve(table.symbols.size());
+        for (auto &kv : table.symbols) {
+            symbols.push_back(kv.first);
+            closes.push_back(kv.second.close);
         }
-        double rv20 = quant::realized_vol(returns20);
-        auto slope20opt = quant::slope_logprice(std::vector<double>(prices.end()-20, prices.end()));
-        double slope20 = slope20opt ? *slope20opt : 0.0;
-        std::cout << sym << "," << "TODAY" << "," << prices.back() << ","
-                  << ma50 << "," << ma200 << "," << ema20 << "," << slope20 << "," << rv20 << "\n";
     }
 
+    // Rows are computed in parallel but written in sorted symbol order, so
+    // the output is byte-identical for any thread count
+    std::vector<std::string> rows(symbols.size());
+    quant::parallel_for(symbols.size(), threads, [&](size_t i) {
+        rows[i] = feature_row(symbols[i], closes[i]);
+    }, 16);
+
+    // print CSV header for features
+    std::cout << "symbol,as_of,close,ma50,ma200,ema20,slope20,rv20\n";
+    for (const auto& row : rows) std::cout << row;
+
     return 0;
 }
@@ -0,0 +1,251 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace metrics {
+
+namespace detail {
+    std::atomic<size_t> next_shard{0};
+
+    double calibrate_ns_per_tick() {
+#if defined(__x86_64__) || defined(__i386__)
+        // Spin ~5ms; the rate error is well below histogram resolution
+        using clock = std::chrono::steady_clock;
+        auto start = clock::now();
+        uint64_t start_ticks = ticks();
+        clock::time_point now;
+        do {
+            now = clock::now();
+        } while (now - start < std::chrono::milliseconds(5));
+        uint64_t elapsed_ticks = ticks() - start_ticks;
+        double elapsed_ns = std::chrono::duration<double, std::nano>(now - start).count();
+        return elapsed_ticks > 0 ? elapsed_ns / elapsed_ticks : 1.0;
+#else
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::duration(1)).count();
+#endif
+    }
+}
+
+namespace {
+    // Exported histogram bounds in nanoseconds: the bucket edge nearest each
+    // step of a 1-2.5-5 ladder from 1us to 10s, so exported counts are exact
+    std::vector<double> export_bounds(double ns_per_unit) {
+        std::vector<uint64_t> targets;
+        for (uint64_t decade = 1000; decade < 10'000'000'000ULL; decade *= 10) {
+            targets.push_back(decade);
+            targets.push_back(decade * 5 / 2);
+            targets.push_back(decade * 5);
+        }
+        targets.push_back(10'000'000'000ULL);
+
+        std::vector<double> out;
+        for (uint64_t target : targets) {
+            double units = target / ns_per_unit;
+            size_t b = Histogram::bucket_index(static_cast<uint64_t>(units));
+            uint64_t lower = Histogram::bucket_lower(b), upper = Histogram::bucket_upper(b);
+            out.push_back((units - lower < upper - units ? lower : upper) * ns_per_unit);
+        }
+        return out;
+    }
+
+    std::string format_number(double value) {
+        if (std::isnan(value)) return "NaN";
+        if (std::isinf(value)) return value > 0 ? "+Inf" : "-Inf";
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.15g", value);
+        return buf;
+    }
+
+    std::string render_labels(const Labels& labels) {
+        std::string out;
+        for (const auto& [key, value] : labels) {
+            if (!out.empty()) out += ',';
+            out += key;
+            out += "=\"";
+            for (char c : value) {
+                if (c == '\\' || c == '"') {
+                    out += '\\';
+                    out += c;
+                } else if (c == '\n') {
+                    out += "\\n";
+                } else {
+                    out += c;
+                }
+            }
+            out += '"';
+        }
+        return out;
+    }
+
+    // name{labels} or name{labels,extra}
+    void append_series(std::string& out, const std::string& name, const std::string& labels,
+                       const std::string& extra, const std::string& value) {
+        out += name;
+        if (!labels.empty() || !extra.empty()) {
+            out += '{';
+            out += labels;
+            if (!labels.empty() && !extra.empty()) out += ',';
+            out += extra;
+            out += '}';
+        }
+        out += ' ';
+        out += value;
+        out += '\n';
+    }
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) total += shard.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+uint64_t Histogram::bucket_lower(size_t index) {
+    if (index < 16) return index;
+    size_t exponent = 4 + (index - 16) / kSubBuckets;
+    uint64_t sub = (index - 16) % kSubBuckets;
+    return (kSubBuckets + sub) << (exponent - 3);
+}
+
+uint64_t Histogram::bucket_upper(size_t index) {
+    if (index < 16) return index + 1;
+    size_t exponent = 4 + (index - 16) / kSubBuckets;
+    uint64_t sub = (index - 16) % kSubBuckets;
+    return (kSubBuckets + sub + 1) << (exponent - 3);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snap;
+    snap.ns_per_unit = ns_per_unit();
+    uint64_t sum = 0;
+    for (const auto& shard : shards_) {
+        sum += shard.sum.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < kBuckets; ++i) {
+            snap.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+    for (uint64_t n : snap.buckets) snap.count += n;
+    snap.sum = unit_ == Unit::Ticks ? static_cast<uint64_t>(sum * snap.ns_per_unit) : sum;
+    return snap;
+}
+
+uint64_t Histogram::Snapshot::count_below(double nanos) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBuckets && bucket_upper(i) * ns_per_unit <= nanos; ++i) total += buckets[i];
+    return total;
+}
+
+double Histogram::Snapshot::quantile(double q) const {
+    if (count == 0) return NAN;
+    double rank = std::max(1.0, std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += buckets[i];
+        if (static_cast<double>(seen) >= rank) {
+            double mid = i < 16 ? static_cast<double>(i) : (bucket_lower(i) + bucket_upper(i) - 1) / 2.0;
+            return mid * ns_per_unit;
+        }
+    }
+    return bucket_lower(kBuckets - 1) * ns_per_unit;
+}
+
+Registry::Series& Registry::series_locked(const std::string& name, const std::string& help, Type type,
+                                          const Labels& labels) {
+    Family* family = nullptr;
+    for (auto& f : families_) {
+        if (f->name == name) family = f.get();
+    }
+    if (!family) {
+        families_.push_back(std::make_unique<Family>(Family{name, help, type, {}}));
+        family = families_.back().get();
+    } else if (family->type != type) {
+        throw std::logic_error("metric " + name + " registered with two types");
+    }
+
+    std::string rendered = render_labels(labels);
+    for (auto& series : family->series) {
+        if (series->labels == rendered) return *series;
+    }
+    family->series.push_back(std::make_unique<Series>());
+    family->series.back()->labels = std::move(rendered);
+    return *family->series.back();
+}
+
+Counter& Registry::counter(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& series = series_locked(name, help, Type::Counter, labels);
+    if (!series.counter) series.counter = std::make_unique<Counter>();
+    return *series.counter;
+}
+
+Histogram& Registry::histogram(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return histogram_locked(name, help, labels, Histogram::Unit::Nanoseconds);
+}
+
+Histogram& Registry::timer(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return histogram_locked(name, help, labels, Histogram::Unit::Ticks);
+}
+
+Histogram& Registry::histogram_locked(const std::string& name, const std::string& help, const Labels& labels,
+                                      Histogram::Unit unit) {
+    Series& series = series_locked(name, help, Type::Histogram, labels);
+    if (!series.histogram) {
+        series.histogram = std::make_unique<Histogram>(unit);
+    } else if (series.histogram->unit() != unit) {
+        throw std::logic_error("histogram " + name + " registered with two units");
+    }
+    return *series.histogram;
+}
+
+void Registry::counter_fn(const std::string& name, const std::string& help, const Labels& labels,
+                          std::function<double()> sample) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    series_locked(name, help, Type::Counter, labels).sample = std::move(sample);
+}
+
+void Registry::gauge_fn(const std::string& name, const std::string& help, const Labels& labels,
+                        std::function<double()> sample) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    series_locked(name, help, Type::Gauge, labels).sample = std::move(sample);
+}
+
+std::string Registry::expose() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string out;
+    for (const auto& family : families_) {
+        const char* type = family->type == Type::Counter ? "counter"
+                         : family->type == Type::Gauge ? "gauge" : "histogram";
+        out += "# HELP " + family->name + ' ' + family->help + '\n';
+        out += "# TYPE " + family->name + ' ' + type + '\n';
+
+        for (const auto& series : family->series) {
+            if (series->sample) {
+                append_series(out, family->name, series->labels, "", format_number(series->sample()));
+            } else if (series->counter) {
+                append_series(out, family->name, series->labels, "", std::to_string(series->counter->value()));
+            } else if (series->histogram) {
+                auto snap = series->histogram->snapshot();
+                const std::string bucket = family->name + "_bucket";
+                for (double bound : export_bounds(snap.ns_per_unit)) {
+                    append_series(out, bucket, series->labels, "le=\"" + format_number(bound / 1e9) + '"',
+                                  std::to_string(snap.count_below(bound)));
+                }
+                append_series(out, bucket, series->labels, "le=\"+Inf\"", std::to_string(snap.count));
+                append_series(out, family->name + "_sum", series->labels, "", format_number(snap.sum / 1e9));
+                append_series(out, family->name + "_count", series->labels, "", std::to_string(snap.count));
+            }
+        }
+    }
+    return out;
+}
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+} // namespace metrics
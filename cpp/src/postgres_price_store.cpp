@@ -0,0 +1,207 @@
+#include "price_store.h"
+
+#ifdef QUANT_HAVE_POSTGRES
+
+#include <libpq-fe.h>
+#include <cstdio>
+#include <cstdlib>
+#include "dates.h"
+
+namespace store {
+
+namespace {
+    const char* kSchema =
+        "CREATE TABLE IF NOT EXISTS prices ("
+        "  symbol TEXT NOT NULL,"
+        "  date DATE NOT NULL,"
+        "  open DOUBLE PRECISION, high DOUBLE PRECISION, low DOUBLE PRECISION,"
+        "  close DOUBLE PRECISION, adj_close DOUBLE PRECISION,"
+        "  volume BIGINT,"
+        "  PRIMARY KEY (symbol, date)"
+        ")";
+
+    // Each upsert COPYs into a per-transaction staging table, then merges it
+    // in one statement; far fewer round trips than row-at-a-time inserts
+    const char* kStage =
+        "CREATE TEMP TABLE IF NOT EXISTS prices_stage (LIKE prices INCLUDING DEFAULTS) ON COMMIT DELETE ROWS";
+    const char* kMerge =
+        "INSERT INTO prices (symbol, date, open, high, low, close, adj_close, volume) "
+        "SELECT DISTINCT ON (symbol, date) symbol, date, open, high, low, close, adj_close, volume "
+        "FROM prices_stage ORDER BY symbol, date "
+        "ON CONFLICT (symbol, date) DO UPDATE SET open = EXCLUDED.open, high = EXCLUDED.high,"
+        " low = EXCLUDED.low, close = EXCLUDED.close, adj_close = EXCLUDED.adj_close,"
+        " volume = EXCLUDED.volume";
+
+    struct ResultGuard {
+        PGresult* res;
+        ~ResultGuard() { PQclear(res); }
+    };
+
+    // COPY text format: backslash, tab and newline must be escaped
+    void append_field(std::string& row, const std::string& value) {
+        for (char c : value) {
+            if (c == '\\') row += "\\\\";
+            else if (c == '\t') row += "\\t";
+            else if (c == '\n') row += "\\n";
+            else row += c;
+        }
+    }
+
+    void append_number(std::string& row, double value) {
+        char buf[32];
+        int n = std::snprintf(buf, sizeof(buf), "%.17g", value);
+        row.append(buf, static_cast<size_t>(n));
+    }
+
+    class PostgresPriceStore : public PriceStore {
+    public:
+        explicit PostgresPriceStore(PGconn* conn) : conn_(conn) {}
+        ~PostgresPriceStore() override { PQfinish(conn_); }
+
+        bool init(std::string& error) {
+            if (!exec(kSchema, error)) return false;
+            ResultGuard res{PQexec(conn_, "SELECT symbol, max(date)::text FROM prices GROUP BY symbol")};
+            if (PQresultStatus(res.res) != PGRES_TUPLES_OK) return fail(error);
+            for (int i = 0; i < PQntuples(res.res); ++i) {
+                note_last_date(PQgetvalue(res.res, i, 0), quant::parse_date(PQgetvalue(res.res, i, 1)));
+            }
+            return true;
+        }
+
+        bool upsert(const std::string& symbol, const quant::BarSeries& bars, std::string& error) override {
+            if (bars.empty()) return true;
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!connected(error)) return false;
+            if (!exec("BEGIN", error)) return false;
+            if (!exec(kStage, error)) return rollback(error);
+
+            {
+                ResultGuard res{PQexec(conn_, "COPY prices_stage (symbol, date, open, high, low, close, adj_close, volume) FROM STDIN")};
+                if (PQresultStatus(res.res) != PGRES_COPY_IN) return rollback(error);
+            }
+
+            std::string escaped_symbol;
+            append_field(escaped_symbol, symbol);
+            std::string chunk;
+            chunk.reserve(64 * 1024);
+            for (size_t i = 0; i < bars.size(); ++i) {
+                chunk += escaped_symbol;
+                chunk += '\t';
+                chunk += quant::format_date(bars.date[i]);
+                for (double v : {bars.open[i], bars.high[i], bars.low[i], bars.close[i], bars.adj_close[i]}) {
+                    chunk += '\t';
+                    append_number(chunk, v);
+                }
+                chunk += '\t';
+                chunk += std::to_string(bars.volume[i]);
+                chunk += '\n';
+                if (chunk.size() >= 60 * 1024) {
+                    if (PQputCopyData(conn_, chunk.data(), static_cast<int>(chunk.size())) != 1) return rollback(error);
+                    chunk.clear();
+                }
+            }
+            if (!chunk.empty() && PQputCopyData(conn_, chunk.data(), static_cast<int>(chunk.size())) != 1) {
+                return rollback(error);
+            }
+            if (PQputCopyEnd(conn_, nullptr) != 1) return rollback(error);
+            {
+                ResultGuard res{PQgetResult(conn_)};
+                if (PQresultStatus(res.res) != PGRES_COMMAND_OK) return rollback(error);
+            }
+            while (PGresult* extra = PQgetResult(conn_)) PQclear(extra);
+
+            if (!exec(kMerge, error) || !exec("COMMIT", error)) return rollback(error);
+            note_stored(symbol, bars);
+            return true;
+        }
+
+        bool load(const std::string& symbol, size_t limit, quant::BarSeries& out, std::string& error) override {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!connected(error)) return false;
+
+            // LIMIT NULL is LIMIT ALL
+            std::string limit_text = std::to_string(limit);
+            const char* params[2] = {symbol.c_str(), limit ? limit_text.c_str() : nullptr};
+            ResultGuard res{PQexecParams(conn_,
+                "SELECT date::text, open, high, low, close, adj_close, volume FROM ("
+                "  SELECT * FROM prices WHERE symbol = $1 ORDER BY date DESC LIMIT $2::bigint"
+                ") recent ORDER BY date",
+                2, nullptr, params, nullptr, nullptr, 0)};
+            if (PQresultStatus(res.res) != PGRES_TUPLES_OK) return fail(error);
+
+            int rows = PQntuples(res.res);
+            out = quant::BarSeries();
+            out.reserve(static_cast<size_t>(rows));
+            auto number = [&](int row, int col) { return std::strtod(PQgetvalue(res.res, row, col), nullptr); };
+            for (int i = 0; i < rows; ++i) {
+                out.push_back(quant::parse_date(PQgetvalue(res.res, i, 0)), number(i, 1), number(i, 2),
+                              number(i, 3), number(i, 4), number(i, 5),
+                              std::strtoll(PQgetvalue(res.res, i, 6), nullptr, 10));
+            }
+            return true;
+        }
+
+        const char* backend() const override { return "postgres"; }
+
+    private:
+        PGconn* conn_;
+        std::mutex mutex_;
+
+        bool fail(std::string& error) {
+            error = std::string("Postgres: ") + PQerrorMessage(conn_);
+            while (!error.empty() && error.back() == '\n') error.pop_back();
+            return false;
+        }
+
+        bool rollback(std::string& error) {
+            fail(error);
+            if (PQtransactionStatus(conn_) == PQTRANS_ACTIVE) {
+                // Abandon a half-finished COPY before rolling back
+                PQputCopyEnd(conn_, "aborted");
+                while (PGresult* res = PQgetResult(conn_)) PQclear(res);
+            }
+            PQclear(PQexec(conn_, "ROLLBACK"));
+            return false;
+        }
+
+        bool exec(const char* sql, std::string& error) {
+            ResultGuard res{PQexec(conn_, sql)};
+            return PQresultStatus(res.res) == PGRES_COMMAND_OK || fail(error);
+        }
+
+        // Reconnect after the server dropped us (restart, idle timeout)
+        bool connected(std::string& error) {
+            if (PQstatus(conn_) == CONNECTION_OK) return true;
+            PQreset(conn_);
+            return PQstatus(conn_) == CONNECTION_OK || fail(error);
+        }
+    };
+}
+
+std::unique_ptr<PriceStore> open_postgres_store(const std::string& conninfo, std::string& error) {
+    PGconn* conn = PQconnectdb(conninfo.c_str());
+    if (PQstatus(conn) != CONNECTION_OK) {
+        error = std::string("Postgres: ") + PQerrorMessage(conn);
+        while (!error.empty() && error.back() == '\n') error.pop_back();
+        PQfinish(conn);
+        return nullptr;
+    }
+    auto store = std::make_unique<PostgresPriceStore>(conn);
+    if (!store->init(error)) return nullptr;
+    return store;
+}
+
+} // namespace store
+
+#else
+
+namespace store {
+
+std::unique_ptr<PriceStore> open_postgres_store(const std::string&, std::string& error) {
+    error = "Postgres support not built (libpq not found at configure time)";
+    return nullptr;
+}
+
+} // namespace store
+
+#endif
@@ -0,0 +1,41 @@
+#include "price_store.h"
+#include <algorithm>
+#include "dates.h"
+
+namespace store {
+
+int32_t PriceStore::last_date(const std::string& symbol) const {
+    std::lock_guard<std::mutex> lock(last_dates_mutex_);
+    auto it = last_dates_.find(symbol);
+    return it == last_dates_.end() ? quant::kInvalidDate : it->second;
+}
+
+size_t PriceStore::symbol_count() const {
+    std::lock_guard<std::mutex> lock(last_dates_mutex_);
+    return last_dates_.size();
+}
+
+void PriceStore::note_stored(const std::string& symbol, const quant::BarSeries& bars) {
+    if (!bars.date.empty()) note_last_date(symbol, *std::max_element(bars.date.begin(), bars.date.end()));
+}
+
+void PriceStore::note_last_date(const std::string& symbol, int32_t date) {
+    if (date == quant::kInvalidDate) return;
+    std::lock_guard<std::mutex> lock(last_dates_mutex_);
+    auto it = last_dates_.emplace(symbol, date).first;
+    it->second = std::max(it->second, date);
+}
+
+std::unique_ptr<PriceStore> open_price_store(const std::string& url, std::string& error) {
+    if (url.rfind("sqlite:", 0) == 0) {
+        return open_sqlite_store(url.substr(7), error);
+    }
+    if (url.rfind("postgresql://", 0) == 0 || url.rfind("postgres://", 0) == 0 ||
+        url.find("host=") != std::string::npos || url.find("dbname=") != std::string::npos) {
+        return open_postgres_store(url, error);
+    }
+    error = "Unsupported price store URL (expected postgresql://... or sqlite:path)";
+    return nullptr;
+}
+
+} // namespace store
@@ -0,0 +1,182 @@
+#include "price_sync.h"
+#include <algorithm>
+#include <ctime>
+#include "dates.h"
+
+namespace store {
+
+namespace {
+    // Calendar days a compact response (100 trading days) safely covers
+    constexpr int32_t kCompactCoverageDays = 140;
+    constexpr size_t kCompactBars = 100;
+
+    int32_t today() {
+        return static_cast<int32_t>(std::time(nullptr) / 86400);
+    }
+}
+
+PriceSync::PriceSync(PriceStore& store, const alphavantage::Client& client, std::chrono::seconds max_age)
+    : PriceSync(store, [&client](const std::string& symbol, const std::string& outputsize) {
+          return client.fetch_daily_adjusted(symbol, outputsize);
+      }, max_age,
+      [&client](const std::vector<std::string>& symbols, const std::string& outputsize,
+                const alphavantage::Client::BatchCallback& on_done, alphavantage::Priority priority) {
+          client.fetch_many(symbols, outputsize, on_done, priority);
+      }) {}
+
+PriceSync::PriceSync(PriceStore& store, alphavantage::BarCache::FetchFn fetch, std::chrono::seconds max_age,
+                     alphavantage::BarCache::BatchFetchFn batch_fetch)
+    : store_(store), fetch_(std::move(fetch)), batch_fetch_(std::move(batch_fetch)), max_age_(max_age) {}
+
+std::string PriceSync::upstream_outputsize(int32_t last_date, int32_t today) {
+    if (last_date == quant::kInvalidDate || today - last_date > kCompactCoverageDays) return "full";
+    return "compact";
+}
+
+bool PriceSync::recent(const std::string& symbol, std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = synced_.find(symbol);
+    if (it == synced_.end()) return false;
+    auto age = clock::now() - it->second.at;
+    if (it->second.error.empty()) return age < max_age_;
+    if (age >= std::min<clock::duration>(max_age_, kFailureRetry)) return false;
+    error = it->second.error;
+    return true;
+}
+
+void PriceSync::sync(const std::vector<std::string>& symbols, size_t* written, alphavantage::Priority priority,
+                     const SyncedFn& on_synced) {
+    // Claim each symbol; one another caller is already syncing is waited on
+    // instead, so the background refresh and an ingest never both go upstream
+    std::vector<size_t> claimed, joined;
+    std::vector<std::promise<std::string>> claims;     // parallel to claimed
+    std::vector<std::shared_future<std::string>> joined_results;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            auto it = syncing_.find(symbols[i]);
+            if (it != syncing_.end()) {
+                joined.push_back(i);
+                joined_results.push_back(it->second);
+                continue;
+            }
+            claims.emplace_back();
+            syncing_.emplace(symbols[i], claims.back().get_future().share());
+            claimed.push_back(i);
+        }
+    }
+
+    std::vector<bool> finished(claimed.size(), false);
+    auto finish = [&](size_t c, const std::string& error) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            synced_[symbols[claimed[c]]] = SyncState{clock::now(), error};
+            syncing_.erase(symbols[claimed[c]]);
+        }
+        finished[c] = true;
+        claims[c].set_value(error);
+    };
+
+    try {
+        // One upstream batch per outputsize
+        const int32_t now_day = today();
+        std::unordered_map<std::string, std::vector<size_t>> groups;
+        for (size_t c = 0; c < claimed.size(); ++c) {
+            groups[upstream_outputsize(store_.last_date(symbols[claimed[c]]), now_day)].push_back(c);
+        }
+
+        for (const auto& [outputsize, group] : groups) {
+            std::vector<std::string> batch;
+            batch.reserve(group.size());
+            for (size_t c : group) batch.push_back(symbols[claimed[c]]);
+
+            auto on_done = [&](size_t j, alphavantage::FetchResult result) {
+                size_t c = group[j];
+                const std::string& symbol = symbols[claimed[c]];
+                std::string error = std::move(result.error);
+                // Upsert everything returned, not just new dates: adjusted closes
+                // are revised after splits and dividends
+                if (error.empty() && store_.upsert(symbol, result.bars, error) && written) {
+                    *written += result.bars.size();
+                }
+                finish(c, error);
+                on_synced(claimed[c], error);
+            };
+
+            if (batch_fetch_) {
+                batch_fetch_(batch, outputsize, on_done, priority);
+            } else {
+                for (size_t j = 0; j < batch.size(); ++j) on_done(j, fetch_(batch[j], outputsize));
+            }
+        }
+    } catch (...) {
+        // Callers waiting on our claims must not wait forever
+        for (size_t c = 0; c < claimed.size(); ++c) {
+            if (!finished[c]) finish(c, "Sync failed");
+        }
+        throw;
+    }
+
+    for (size_t k = 0; k < joined.size(); ++k) on_synced(joined[k], joined_results[k].get());
+}
+
+alphavantage::FetchResult PriceSync::load(const std::string& symbol, const std::string& outputsize,
+                                          const std::string& sync_error) {
+    alphavantage::FetchResult result;
+    std::string error;
+    if (!store_.load(symbol, outputsize == "compact" ? kCompactBars : 0, result.bars, error)) {
+        return alphavantage::FetchResult::failure(error);
+    }
+    // A failed top-up still serves stored history; only an empty store fails
+    if (result.bars.empty()) {
+        return alphavantage::FetchResult::failure(sync_error.empty() ? "No stored data for " + symbol : sync_error);
+    }
+    return result;
+}
+
+alphavantage::FetchResult PriceSync::fetch(const std::string& symbol, const std::string& outputsize) {
+    std::string sync_error;
+    if (!recent(symbol, sync_error)) {
+        sync({symbol}, nullptr, alphavantage::Priority::Interactive,
+             [&sync_error](size_t, const std::string& error) { sync_error = error; });
+    }
+    return load(symbol, outputsize, sync_error);
+}
+
+alphavantage::FetchResult PriceSync::stored(const std::string& symbol, const std::string& outputsize) {
+    return load(symbol, outputsize, "");
+}
+
+void PriceSync::fetch_many(const std::vector<std::string>& symbols, const std::string& outputsize,
+                           const alphavantage::Client::BatchCallback& on_done, alphavantage::Priority priority) {
+    std::vector<std::string> stale;
+    std::vector<size_t> stale_index;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        std::string error;
+        if (recent(symbols[i], error)) {
+            on_done(i, load(symbols[i], outputsize, error));
+        } else {
+            stale.push_back(symbols[i]);
+            stale_index.push_back(i);
+        }
+    }
+    if (stale.empty()) return;
+
+    sync(stale, nullptr, priority, [&](size_t j, const std::string& error) {
+        on_done(stale_index[j], load(stale[j], outputsize, error));
+    });
+}
+
+IngestReport PriceSync::ingest(const std::vector<std::string>& symbols) {
+    IngestReport report;
+    report.symbols = symbols.size();
+    std::vector<std::string> errors(symbols.size());
+    sync(symbols, &report.records_written, alphavantage::Priority::Bulk,
+         [&errors](size_t i, const std::string& error) { errors[i] = error; });
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        if (!errors[i].empty()) report.failed.push_back(symbols[i] + ": " + errors[i]);
+    }
+    return report;
+}
+
+} // namespace store
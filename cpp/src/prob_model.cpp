@@ -0,0 +1,457 @@
+#include "prob_model.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <nlohmann/json.hpp>
+#include "fused.h"
+#include "indicators.h"
+#include "parallel.h"
+#include "rolling.h"
+
+namespace model {
+
+const std::array<const char*, kFeatureCount> kFeatureNames = {
+    "ma50_gap", "ema20_gap", "ma5_ma20_gap", "slope20", "rv20", "return20",
+};
+
+namespace {
+    // Intercept plus one coefficient per feature
+    constexpr size_t kParams = kFeatureCount + 1;
+    constexpr size_t kChunkRows = 1 << 16;
+
+    double sigmoid(double z) {
+        return 1.0 / (1.0 + std::exp(-z));
+    }
+
+    // log(1 + exp(z)) without overflow
+    double softplus(double z) {
+        return std::max(z, 0.0) + std::log1p(std::exp(-std::abs(z)));
+    }
+
+    // Gradient and Hessian of the log-likelihood over one chunk of rows
+    struct Partial {
+        std::array<double, kParams> gradient{};
+        std::array<double, kParams * kParams> hessian{};
+        double log_likelihood = 0.0;
+    };
+
+    Partial accumulate(const FeatureMatrix& z, const std::vector<double>& y,
+                       const std::array<double, kParams>& beta, size_t begin, size_t end) {
+        Partial part;
+        size_t n = end - begin;
+        thread_local std::vector<double> eta, weight, residual;
+        eta.assign(n, beta[0]);
+        weight.resize(n);
+        residual.resize(n);
+
+        for (size_t j = 0; j < kFeatureCount; ++j) {
+            const double* col = z.column(j) + begin;
+            double b = beta[j + 1];
+            for (size_t i = 0; i < n; ++i) eta[i] += b * col[i];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            double p = sigmoid(eta[i]);
+            weight[i] = p * (1.0 - p);
+            residual[i] = y[begin + i] - p;
+            part.log_likelihood += y[begin + i] * eta[i] - softplus(eta[i]);
+        }
+
+        auto dot = [n](const double* a, const double* b) {
+            double s = 0.0;
+            for (size_t i = 0; i < n; ++i) s += a[i] * b[i];
+            return s;
+        };
+        part.gradient[0] = std::accumulate(residual.begin(), residual.end(), 0.0);
+        part.hessian[0] = std::accumulate(weight.begin(), weight.end(), 0.0);
+        thread_local std::vector<double> weighted;
+        weighted.resize(n);
+        for (size_t j = 0; j < kFeatureCount; ++j) {
+            const double* cj = z.column(j) + begin;
+            part.gradient[j + 1] = dot(residual.data(), cj);
+            for (size_t i = 0; i < n; ++i) weighted[i] = weight[i] * cj[i];
+            part.hessian[j + 1] = std::accumulate(weighted.begin(), weighted.end(), 0.0);
+            for (size_t k = j; k < kFeatureCount; ++k) {
+                part.hessian[(j + 1) * kParams + k + 1] = dot(weighted.data(), z.column(k) + begin);
+            }
+        }
+        return part;
+    }
+
+    // One pass over all rows: chunks in parallel, reduced in chunk order
+    Partial accumulate_all(const FeatureMatrix& z, const std::vector<double>& y,
+                           const std::array<double, kParams>& beta, unsigned threads) {
+        size_t chunks = (z.rows + kChunkRows - 1) / kChunkRows;
+        std::vector<Partial> parts(chunks);
+        quant::parallel_for(chunks, threads, [&](size_t c) {
+            parts[c] = accumulate(z, y, beta, c * kChunkRows, std::min(z.rows, (c + 1) * kChunkRows));
+        });
+        Partial total;
+        for (const auto& part : parts) {
+            for (size_t i = 0; i < kParams; ++i) total.gradient[i] += part.gradient[i];
+            for (size_t i = 0; i < kParams * kParams; ++i) total.hessian[i] += part.hessian[i];
+            total.log_likelihood += part.log_likelihood;
+        }
+        // Only the upper triangle was accumulated
+        for (size_t r = 0; r < kParams; ++r) {
+            for (size_t c = 0; c < r; ++c) total.hessian[r * kParams + c] = total.hessian[c * kParams + r];
+        }
+        return total;
+    }
+
+    // Solve a * x = b for symmetric positive definite a (Cholesky)
+    bool solve_spd(std::array<double, kParams * kParams> a, std::array<double, kParams>& b) {
+        for (size_t j = 0; j < kParams; ++j) {
+            double d = a[j * kParams + j];
+            for (size_t k = 0; k < j; ++k) d -= a[j * kParams + k] * a[j * kParams + k];
+            if (!(d > 0.0)) return false;
+            a[j * kParams + j] = std::sqrt(d);
+            for (size_t i = j + 1; i < kParams; ++i) {
+                double s = a[i * kParams + j];
+                for (size_t k = 0; k < j; ++k) s -= a[i * kParams + k] * a[j * kParams + k];
+                a[i * kParams + j] = s / a[j * kParams + j];
+            }
+        }
+        for (size_t i = 0; i < kParams; ++i) {
+            double s = b[i];
+            for (size_t k = 0; k < i; ++k) s -= a[i * kParams + k] * b[k];
+            b[i] = s / a[i * kParams + i];
+        }
+        for (size_t i = kParams; i-- > 0;) {
+            double s = b[i];
+            for (size_t k = i + 1; k < kParams; ++k) s -= a[k * kParams + i] * b[k];
+            b[i] = s / a[i * kParams + i];
+        }
+        return true;
+    }
+
+    // Per-symbol rows before concatenation
+    struct Block {
+        std::array<std::vector<double>, kFeatureCount> columns;
+        std::vector<double> y;
+        std::vector<int32_t> date;
+    };
+
+    void append_rows(TrainingSet& out, const std::vector<const Block*>& blocks) {
+        size_t rows = 0;
+        for (const auto* b : blocks) rows += b->y.size();
+        out.x.resize(rows);
+        out.y.reserve(rows);
+        out.date.reserve(rows);
+        size_t offset = 0;
+        for (const auto* b : blocks) {
+            for (size_t j = 0; j < kFeatureCount; ++j) {
+                std::copy(b->columns[j].begin(), b->columns[j].end(), out.x.column(j) + offset);
+            }
+            out.y.insert(out.y.end(), b->y.begin(), b->y.end());
+            out.date.insert(out.date.end(), b->date.begin(), b->date.end());
+            offset += b->y.size();
+        }
+    }
+}
+
+void feature_series(quant::Span<const double> close, double* out, size_t stride) {
+    const size_t n = close.size();
+    double* ma50_gap = out + kMa50Gap * stride;
+    double* ema20_gap = out + kEma20Gap * stride;
+    double* ma5_ma20 = out + kMa5Ma20Gap * stride;
+    double* slope20 = out + kSlope20 * stride;
+    double* rv20 = out + kRv20 * stride;
+    double* return20 = out + kReturn20 * stride;
+
+    // Indicator columns first, then turned into gaps in place
+    quant::sma_series(close.data(), n, 50, ma50_gap);
+    quant::ema_series(close.data(), n, 20, ema20_gap);
+    quant::sma_series(close.data(), n, 20, ma5_ma20);
+    quant::sma_series(close.data(), n, 5, slope20);    // SMA5 scratch, overwritten below
+
+    quant::RollingVariance returns(20);
+    for (size_t t = 0; t < n; ++t) {
+        if (t > 0) returns.push((close[t] - close[t - 1]) / close[t - 1]);
+        if (t + 1 < kMinHistory) {
+            ma50_gap[t] = ema20_gap[t] = ma5_ma20[t] = slope20[t] = rv20[t] = return20[t] = NAN;
+            continue;
+        }
+        ma50_gap[t] = close[t] / ma50_gap[t] - 1.0;
+        ema20_gap[t] = close[t] / ema20_gap[t] - 1.0;
+        ma5_ma20[t] = slope20[t] / ma5_ma20[t] - 1.0;
+        rv20[t] = returns.stddev();
+        return20[t] = close[t] / close[t - 20] - 1.0;
+
+        // Least-squares slope of log price against x = 0..19, x centred at 9.5
+        double num = 0.0;
+        for (size_t k = 0; k < 20; ++k) num += (static_cast<double>(k) - 9.5) * std::log(close[t - 19 + k]);
+        slope20[t] = num / 665.0;   // sum of (k - 9.5)^2
+    }
+}
+
+bool latest_features(quant::Span<const double> close, FeatureMatrix& x, size_t row) {
+    const size_t n = close.size();
+    for (size_t j = 0; j < kFeatureCount; ++j) x.column(j)[row] = NAN;
+    if (n < kMinHistory) return false;
+
+    // Only the last bar is scored, so every feature comes from one fused
+    // pass instead of running the full series
+    using namespace quant::fused;
+    Kernel<Sma<50>, Ema<20>, Sma<5>, Sma<20>, Slope<20>, Vol<20>, Change<20>> k(close);
+    std::array<double, kFeatureCount> v;
+    const double last = close.back();
+    v[kMa50Gap] = last / k.get<Sma<50>>() - 1.0;
+    v[kEma20Gap] = last / k.get<Ema<20>>() - 1.0;
+    v[kMa5Ma20Gap] = k.get<Sma<5>>() / k.get<Sma<20>>() - 1.0;
+    v[kSlope20] = k.get<Slope<20>>();
+    v[kRv20] = k.get<Vol<20>>();
+    v[kReturn20] = k.get<Change<20>>();
+
+    bool finite = true;
+    for (size_t j = 0; j < kFeatureCount; ++j) {
+        x.column(j)[row] = v[j];
+        finite = finite && std::isfinite(v[j]);
+    }
+    return finite;
+}
+
+std::pair<TrainingSet, TrainingSet> TrainingSet::split(int32_t cutoff) const {
+    std::pair<TrainingSet, TrainingSet> parts;
+    size_t before = static_cast<size_t>(std::count_if(date.begin(), date.end(), [cutoff](int32_t d) { return d < cutoff; }));
+    parts.first.x.resize(before);
+    parts.second.x.resize(y.size() - before);
+    size_t a = 0, b = 0;
+    for (size_t i = 0; i < y.size(); ++i) {
+        TrainingSet& dst = date[i] < cutoff ? parts.first : parts.second;
+        size_t& row = date[i] < cutoff ? a : b;
+        for (size_t j = 0; j < kFeatureCount; ++j) dst.x.column(j)[row] = x.at(i, j);
+        dst.y.push_back(y[i]);
+        dst.date.push_back(date[i]);
+        ++row;
+    }
+    return parts;
+}
+
+TrainingSet build_training_set(const std::vector<quant::BarView>& universe, int horizon, unsigned threads) {
+    const size_t h = static_cast<size_t>(std::max(1, horizon));
+    std::vector<Block> blocks(universe.size());
+    quant::parallel_for(universe.size(), threads, [&](size_t s) {
+        const auto& series = universe[s];
+        const size_t n = series.size();
+        if (n < kMinHistory + h) return;
+        std::vector<double> features(n * kFeatureCount);
+        feature_series(series.close, features.data(), n);
+
+        quant::Span<const double> labels = series.adj_close.empty() ? series.close : series.adj_close;
+        Block& block = blocks[s];
+        for (size_t t = kMinHistory - 1; t + h < n; ++t) {
+            double forward = labels[t + h] / labels[t] - 1.0;
+            bool finite = std::isfinite(forward);
+            for (size_t j = 0; j < kFeatureCount && finite; ++j) finite = std::isfinite(features[j * n + t]);
+            if (!finite) continue;
+            for (size_t j = 0; j < kFeatureCount; ++j) block.columns[j].push_back(features[j * n + t]);
+            block.y.push_back(forward > 0.0 ? 1.0 : 0.0);
+            block.date.push_back(series.date[t]);
+        }
+    });
+
+    TrainingSet set;
+    std::vector<const Block*> order;
+    order.reserve(blocks.size());
+    for (const auto& b : blocks) order.push_back(&b);
+    append_rows(set, order);
+    return set;
+}
+
+double ProbModel::predict(const FeatureMatrix& x, size_t row) const {
+    double z = intercept;
+    for (size_t j = 0; j < kFeatureCount; ++j) z += weights[j] * x.at(row, j);
+    return sigmoid(z);
+}
+
+void ProbModel::predict(const FeatureMatrix& x, double* out) const {
+    std::fill(out, out + x.rows, intercept);
+    for (size_t j = 0; j < kFeatureCount; ++j) {
+        const double* col = x.column(j);
+        const double w = weights[j];
+        for (size_t i = 0; i < x.rows; ++i) out[i] += w * col[i];
+    }
+    for (size_t i = 0; i < x.rows; ++i) out[i] = sigmoid(out[i]);
+}
+
+void ProbModel::predict(const FeatureMatrix& x, std::vector<double>& out) const {
+    out.resize(x.rows);
+    predict(x, out.data());
+}
+
+std::string ProbModel::to_json() const {
+    nlohmann::json j;
+    j["version"] = version;
+    j["horizon"] = horizon;
+    j["features"] = std::vector<std::string>(kFeatureNames.begin(), kFeatureNames.end());
+    j["weights"] = std::vector<double>(weights.begin(), weights.end());
+    j["intercept"] = intercept;
+    j["trained_rows"] = trained_rows;
+    return j.dump(2);
+}
+
+bool ProbModel::from_json(std::string_view text, ProbModel& out, std::string& error) {
+    try {
+        auto j = nlohmann::json::parse(text);
+        auto features = j.at("features").get<std::vector<std::string>>();
+        if (!std::equal(features.begin(), features.end(), kFeatureNames.begin(), kFeatureNames.end())) {
+            error = "Model features do not match this build";
+            return false;
+        }
+        auto weights = j.at("weights").get<std::vector<double>>();
+        if (weights.size() != kFeatureCount) {
+            error = "Model has " + std::to_string(weights.size()) + " weights, expected " + std::to_string(kFeatureCount);
+            return false;
+        }
+        ProbModel m;
+        m.version = j.at("version").get<std::string>();
+        m.horizon = j.value("horizon", 20);
+        std::copy(weights.begin(), weights.end(), m.weights.begin());
+        m.intercept = j.at("intercept").get<double>();
+        m.trained_rows = j.value("trained_rows", size_t(0));
+        out = std::move(m);
+        return true;
+    } catch (const std::exception& e) {
+        error = std::string("Invalid model JSON: ") + e.what();
+        return false;
+    }
+}
+
+bool ProbModel::save(const std::string& path, std::string& error) const {
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        out << to_json() << "\n";
+        if (!out) {
+            error = "Failed writing " + tmp_path;
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        error = "Cannot rename " + tmp_path + " to " + path;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ProbModel::load(const std::string& path, ProbModel& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    std::ostringstream buf;
+    buf << in.rdbuf();
+    if (!from_json(buf.str(), out, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+TrainResult train(FeatureMatrix x, const std::vector<double>& y, const TrainOptions& options) {
+    TrainResult result;
+    const size_t n = x.rows;
+    if (n == 0 || y.size() != n) {
+        result.error = n == 0 ? "No training rows" : "Label count does not match feature rows";
+        return result;
+    }
+
+    // Standardize in place so the ridge penalty treats features alike
+    std::array<double, kFeatureCount> mean{}, scale{};
+    for (size_t j = 0; j < kFeatureCount; ++j) {
+        double* col = x.column(j);
+        mean[j] = std::accumulate(col, col + n, 0.0) / n;
+        double ss = 0.0;
+        for (size_t i = 0; i < n; ++i) ss += (col[i] - mean[j]) * (col[i] - mean[j]);
+        scale[j] = n > 1 && ss > 0.0 ? std::sqrt(ss / (n - 1)) : 1.0;
+        for (size_t i = 0; i < n; ++i) col[i] = (col[i] - mean[j]) / scale[j];
+    }
+
+    // Start from the base rate
+    std::array<double, kParams> beta{};
+    double positives = std::accumulate(y.begin(), y.end(), 0.0);
+    double base = std::clamp(positives / n, 1e-6, 1.0 - 1e-6);
+    beta[0] = std::log(base / (1.0 - base));
+
+    Partial pass;
+    for (result.iterations = 1; result.iterations <= options.max_iterations; ++result.iterations) {
+        pass = accumulate_all(x, y, beta, options.threads);
+
+        // Newton step on the mean penalized log-likelihood
+        std::array<double, kParams * kParams> hessian;
+        std::array<double, kParams> step;
+        for (size_t i = 0; i < kParams * kParams; ++i) hessian[i] = pass.hessian[i] / n;
+        for (size_t i = 0; i < kParams; ++i) step[i] = pass.gradient[i] / n;
+        for (size_t i = 1; i < kParams; ++i) {
+            hessian[i * kParams + i] += options.l2;
+            step[i] -= options.l2 * beta[i];
+        }
+        if (!solve_spd(hessian, step)) {
+            result.error = "Hessian is not positive definite (constant or collinear features?)";
+            return result;
+        }
+
+        double largest = 0.0;
+        for (size_t i = 0; i < kParams; ++i) {
+            beta[i] += step[i];
+            largest = std::max(largest, std::abs(step[i]));
+        }
+        if (largest < options.tolerance) {
+            result.converged = true;
+            break;
+        }
+    }
+    result.iterations = std::min(result.iterations, options.max_iterations);
+    result.log_loss = -accumulate_all(x, y, beta, options.threads).log_likelihood / n;
+
+    // Fold the standardization back in: w.z + b0 == w'.x + b0'
+    result.model.intercept = beta[0];
+    for (size_t j = 0; j < kFeatureCount; ++j) {
+        result.model.weights[j] = beta[j + 1] / scale[j];
+        result.model.intercept -= beta[j + 1] * mean[j] / scale[j];
+    }
+    result.model.trained_rows = n;
+    return result;
+}
+
+double auc(const std::vector<double>& scores, const std::vector<double>& labels) {
+    size_t n = std::min(scores.size(), labels.size());
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return scores[a] < scores[b]; });
+
+    double positive_rank_sum = 0.0, positives = 0.0;
+    for (size_t i = 0; i < n;) {
+        size_t j = i + 1;
+        while (j < n && scores[order[j]] == scores[order[i]]) ++j;
+        double mean_rank = (i + j + 1) / 2.0;     // 1-based
+        for (size_t k = i; k < j; ++k) {
+            if (labels[order[k]] > 0.5) {
+                positive_rank_sum += mean_rank;
+                positives += 1.0;
+            }
+        }
+        i = j;
+    }
+    double negatives = n - positives;
+    if (positives == 0.0 || negatives == 0.0) return NAN;
+    return (positive_rank_sum - positives * (positives + 1.0) / 2.0) / (positives * negatives);
+}
+
+double log_loss(const std::vector<double>& probs, const std::vector<double>& labels) {
+    size_t n = std::min(probs.size(), labels.size());
+    if (n == 0) return NAN;
+    double total = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double p = std::clamp(probs[i], 1e-15, 1.0 - 1e-15);
+        total -= labels[i] > 0.5 ? std::log(p) : std::log(1.0 - p);
+    }
+    return total / n;
+}
+
+} // namespace model
@@ -0,0 +1,64 @@
+#include "ranking.h"
+#include <algorithm>
+#include <array>
+#include <memory_resource>
+#include "arena.h"
+
+namespace quant {
+
+namespace {
+    // Below this a comparison sort beats clearing the radix histograms
+    constexpr size_t kRadixThreshold = 256;
+    constexpr int kRadixBits = 11;
+    constexpr size_t kRadixBuckets = size_t(1) << kRadixBits;
+
+    // LSD radix sort on the high 32 bits in three 11-bit passes. Stable, so
+    // equal keys stay in index order, exactly as std::sort leaves them.
+    void radix_sort_keys(uint64_t* data, size_t n) {
+        ArenaScope scope;
+        std::pmr::vector<uint64_t> buffer(n, scope.resource());
+        std::array<std::array<uint32_t, kRadixBuckets>, 3> counts{};
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t key = static_cast<uint32_t>(data[i] >> 32);
+            ++counts[0][key & (kRadixBuckets - 1)];
+            ++counts[1][key >> kRadixBits & (kRadixBuckets - 1)];
+            ++counts[2][key >> (2 * kRadixBits)];
+        }
+
+        uint64_t* from = data;
+        uint64_t* to = buffer.data();
+        for (int pass = 0; pass < 3; ++pass) {
+            uint32_t offset = 0;
+            for (auto& count : counts[pass]) {
+                uint32_t c = count;
+                count = offset;
+                offset += c;
+            }
+            const int shift = 32 + pass * kRadixBits;
+            for (size_t i = 0; i < n; ++i) {
+                to[counts[pass][from[i] >> shift & (kRadixBuckets - 1)]++] = from[i];
+            }
+            std::swap(from, to);
+        }
+        // Three passes end in the buffer
+        std::copy(from, from + n, data);
+    }
+}
+
+void rank(const float* values, size_t n, uint64_t* sorted, double* ranks) {
+    for (size_t i = 0; i < n; ++i) sorted[i] = uint64_t(order_key(values[i])) << 32 | i;
+    if (n < kRadixThreshold) {
+        std::sort(sorted, sorted + n);
+    } else {
+        radix_sort_keys(sorted, n);
+    }
+    for (size_t i = 0; i < n;) {
+        size_t j = i + 1;
+        while (j < n && (sorted[j] >> 32) == (sorted[i] >> 32)) ++j;
+        double mean_rank = (i + j - 1) / 2.0;
+        for (size_t k = i; k < j; ++k) ranks[static_cast<uint32_t>(sorted[k])] = mean_rank;
+        i = j;
+    }
+}
+
+} // namespace quant
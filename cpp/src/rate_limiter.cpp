@@ -0,0 +1,148 @@
+#include "rate_limiter.h"
+#include <algorithm>
+#include "metrics.h"
+
+namespace alphavantage {
+
+namespace {
+    constexpr auto kDay = std::chrono::hours(24);
+    // How often a bulk caller re-checks while interactive callers hold the line
+    constexpr auto kYieldInterval = std::chrono::milliseconds(10);
+    // Slack for an interactive try_acquire caller to come back for its token
+    constexpr auto kClaimGrace = std::chrono::milliseconds(250);
+
+    // wait: a caller blocked for a token; rejected: the server refused a
+    // request as rate limited; quota_exhausted: the daily quota turned a
+    // caller away. Looked up before taking mutex_, since /metrics may call
+    // used_today() while holding the registry lock.
+    struct LimiterMetrics {
+        metrics::Counter& waits = event("wait");
+        metrics::Counter& rejected = event("rejected");
+        metrics::Counter& exhausted = event("quota_exhausted");
+        metrics::Histogram& wait_time = metrics::registry().histogram(
+            "upstream_token_wait_seconds", "Time blocked waiting for an upstream request token");
+
+        static metrics::Counter& event(const char* name) {
+            return metrics::registry().counter("upstream_rate_limit_events_total",
+                "Upstream rate limiter events", {{"event", name}});
+        }
+    };
+
+    LimiterMetrics& limiter_metrics() {
+        static LimiterMetrics instance;
+        return instance;
+    }
+}
+
+RateLimiter::RateLimiter(RateLimits limits)
+    : limits_(limits),
+      tokens_(limits.per_minute),
+      last_refill_(Clock::now()),
+      day_start_(Clock::now()) {}
+
+void RateLimiter::refill_locked(Clock::time_point now) {
+    if (limits_.per_minute <= 0) return;
+    double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+    tokens_ = std::min<double>(limits_.per_minute, tokens_ + elapsed * limits_.per_minute / 60.0);
+    last_refill_ = now;
+}
+
+bool RateLimiter::day_exhausted_locked(Clock::time_point now) {
+    if (now < exhausted_until_) return true;
+    if (limits_.per_day <= 0) return false;
+    if (now - day_start_ >= kDay) {
+        day_start_ = now;
+        day_used_ = 0;
+    }
+    return day_used_ >= limits_.per_day;
+}
+
+RateLimiter::Clock::duration RateLimiter::wait_locked(Priority priority, Clock::time_point now) {
+    if (priority == Priority::Bulk) {
+        if (waiting_[static_cast<int>(Priority::Interactive)] > 0) return kYieldInterval;
+        if (now < interactive_claim_until_) {
+            return std::max<Clock::duration>(kYieldInterval, interactive_claim_until_ - now);
+        }
+    }
+    if (limits_.per_minute <= 0) return Clock::duration::zero();
+    refill_locked(now);
+    if (tokens_ >= 1.0) return Clock::duration::zero();
+    double seconds = (1.0 - tokens_) * 60.0 / limits_.per_minute;
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+bool RateLimiter::acquire(Priority priority) {
+    LimiterMetrics& stats = limiter_metrics();
+    std::unique_lock<std::mutex> lock(mutex_);
+    int& waiting = waiting_[static_cast<int>(priority)];
+    ++waiting;
+    const auto start = Clock::now();
+    bool waited = false;
+    for (;;) {
+        auto now = Clock::now();
+        if (day_exhausted_locked(now)) {
+            --waiting;
+            stats.exhausted.inc();
+            return false;
+        }
+        auto wait = wait_locked(priority, now);
+        if (wait == Clock::duration::zero()) break;
+        if (!waited) stats.waits.inc();
+        waited = true;
+        available_.wait_for(lock, wait);
+    }
+    if (waited) stats.wait_time.record(Clock::now() - start);
+    --waiting;
+    if (limits_.per_minute > 0) tokens_ -= 1.0;
+    ++day_used_;
+    available_.notify_all();
+    return true;
+}
+
+std::optional<RateLimiter::Clock::duration> RateLimiter::try_acquire(Priority priority) {
+    LimiterMetrics& stats = limiter_metrics();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = Clock::now();
+    if (day_exhausted_locked(now)) {
+        stats.exhausted.inc();
+        return std::nullopt;
+    }
+    auto wait = wait_locked(priority, now);
+    if (wait != Clock::duration::zero()) {
+        // Batches poll rather than block, so keep the token for this caller
+        if (priority == Priority::Interactive) {
+            interactive_claim_until_ = std::max(interactive_claim_until_, now + wait + kClaimGrace);
+        }
+        return wait;
+    }
+    if (limits_.per_minute > 0) tokens_ -= 1.0;
+    ++day_used_;
+    return Clock::duration::zero();
+}
+
+void RateLimiter::on_rate_limited() {
+    limiter_metrics().rejected.inc();
+    std::lock_guard<std::mutex> lock(mutex_);
+    refill_locked(Clock::now());
+    tokens_ = std::min(tokens_, 0.0);
+}
+
+void RateLimiter::on_quota_exhausted() {
+    limiter_metrics().rejected.inc();
+    auto since_midnight = std::chrono::system_clock::now().time_since_epoch() % kDay;
+    std::lock_guard<std::mutex> lock(mutex_);
+    exhausted_until_ = Clock::now() + (kDay - since_midnight);
+    available_.notify_all();
+}
+
+int RateLimiter::waiting(Priority priority) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waiting_[static_cast<int>(priority)];
+}
+
+int RateLimiter::used_today() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return day_used_;
+}
+
+} // namespace alphavantage
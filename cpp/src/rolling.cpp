@@ -0,0 +1,286 @@
+#include "../include/rolling.h"
+#include <cmath>
+#include <algorithm>
+
+namespace quant {
+
+// ---- RingWindow ----
+
+RingWindow::RingWindow(int capacity) : values_(capacity > 0 ? capacity : 0) {}
+
+void RingWindow::push(double x) {
+    if (values_.empty()) return;
+    if (count_ < values_.size()) {
+        values_[(head_ + count_) % values_.size()] = x;
+        ++count_;
+    } else {
+        values_[head_] = x;
+        head_ = (head_ + 1) % values_.size();
+    }
+}
+
+double RingWindow::oldest() const {
+    return count_ ? values_[head_] : NAN;
+}
+
+double RingWindow::sum() const {
+    double total = 0.0;
+    for (size_t i = 0; i < count_; ++i) total += values_[(head_ + i) % values_.size()];
+    return total;
+}
+
+double RingWindow::sum_sq_dev(double mean) const {
+    double total = 0.0;
+    for (size_t i = 0; i < count_; ++i) {
+        double d = values_[(head_ + i) % values_.size()] - mean;
+        total += d * d;
+    }
+    return total;
+}
+
+std::vector<double> RingWindow::values() const {
+    std::vector<double> out;
+    out.reserve(count_);
+    for (size_t i = 0; i < count_; ++i) out.push_back(values_[(head_ + i) % values_.size()]);
+    return out;
+}
+
+void RingWindow::assign(const std::vector<double>& values) {
+    head_ = 0;
+    count_ = 0;
+    size_t skip = values.size() > values_.size() ? values.size() - values_.size() : 0;
+    for (size_t i = skip; i < values.size(); ++i) push(values[i]);
+}
+
+// ---- RollingSMA ----
+
+RollingSMA::RollingSMA(int period) : period_(period), window_(period) {}
+
+void RollingSMA::push(double x) {
+    if (period_ <= 0) return;
+    if (window_.full()) {
+        sum_ -= window_.oldest();
+    }
+    window_.push(x);
+    sum_ += x;
+    // Re-sum once per full window so add/subtract rounding never accumulates
+    if (++since_resum_ >= static_cast<size_t>(period_)) {
+        sum_ = window_.sum();
+        since_resum_ = 0;
+    }
+}
+
+bool RollingSMA::ready() const {
+    return period_ > 0 && window_.full();
+}
+
+double RollingSMA::value() const {
+    if (!ready()) return NAN;
+    return sum_ / period_;
+}
+
+RollingSMA::State RollingSMA::snapshot() const {
+    return State{period_, window_.values()};
+}
+
+void RollingSMA::restore(const State& state) {
+    period_ = state.period;
+    window_ = RingWindow(state.period);
+    window_.assign(state.window);
+    sum_ = window_.sum();
+    since_resum_ = 0;
+}
+
+// ---- RollingEMA ----
+
+RollingEMA::RollingEMA(int period) : period_(period) {}
+
+void RollingEMA::push(double x) {
+    if (period_ <= 0) return;
+    if (count_ < period_) {
+        value_ += x;
+        if (++count_ == period_) value_ /= period_;
+        return;
+    }
+    double k = 2.0 / (period_ + 1.0);
+    value_ = x * k + value_ * (1.0 - k);
+    ++count_;
+}
+
+double RollingEMA::value() const {
+    return ready() ? value_ : NAN;
+}
+
+RollingEMA::State RollingEMA::snapshot() const {
+    return State{period_, count_, value_};
+}
+
+void RollingEMA::restore(const State& state) {
+    period_ = state.period;
+    count_ = state.count;
+    value_ = state.value;
+}
+
+// ---- RollingRSI ----
+
+RollingRSI::RollingRSI(int period) : period_(period) {}
+
+void RollingRSI::push(double close) {
+    if (period_ <= 0) return;
+    if (count_++ == 0) {
+        prev_close_ = close;
+        return;
+    }
+    double diff = close - prev_close_;
+    prev_close_ = close;
+    double gain = diff > 0 ? diff : 0.0;
+    double loss = diff > 0 ? 0.0 : -diff;
+
+    if (count_ <= period_ + 1) {
+        // Seed with a simple average of the first `period` changes
+        avg_gain_ += gain;
+        avg_loss_ += loss;
+        if (count_ == period_ + 1) {
+            avg_gain_ /= period_;
+            avg_loss_ /= period_;
+        }
+        return;
+    }
+    avg_gain_ = (avg_gain_ * (period_ - 1) + gain) / period_;
+    avg_loss_ = (avg_loss_ * (period_ - 1) + loss) / period_;
+}
+
+double RollingRSI::value() const {
+    if (!ready()) return NAN;
+    if (avg_loss_ == 0) return 100.0;
+    double rs = avg_gain_ / avg_loss_;
+    return 100.0 - (100.0 / (1.0 + rs));
+}
+
+RollingRSI::State RollingRSI::snapshot() const {
+    return State{period_, count_, prev_close_, avg_gain_, avg_loss_};
+}
+
+void RollingRSI::restore(const State& state) {
+    period_ = state.period;
+    count_ = state.count;
+    prev_close_ = state.prev_close;
+    avg_gain_ = state.avg_gain;
+    avg_loss_ = state.avg_loss;
+}
+
+// ---- RollingATR ----
+
+RollingATR::RollingATR(int period) : tr_(period) {}
+
+void RollingATR::push(double high, double low, double close) {
+    if (has_prev_) {
+        tr_.push(std::max({high - low, std::abs(high - prev_close_), std::abs(low - prev_close_)}));
+    }
+    has_prev_ = true;
+    prev_close_ = close;
+}
+
+RollingATR::State RollingATR::snapshot() const {
+    return State{has_prev_, prev_close_, tr_.snapshot()};
+}
+
+void RollingATR::restore(const State& state) {
+    has_prev_ = state.has_prev;
+    prev_close_ = state.prev_close;
+    tr_.restore(state.true_ranges);
+}
+
+// ---- RollingVariance ----
+
+RollingVariance::RollingVariance(int window) : window_(window > 0 ? window : 0), values_(window_) {}
+
+void RollingVariance::push(double x) {
+    if (window_ > 0 && values_.full()) {
+        // Remove the evicted value (reverse Welford step)
+        double old = values_.oldest();
+        if (count_ > 1) {
+            double delta = old - mean_;
+            mean_ -= delta / (count_ - 1);
+            m2_ -= delta * (old - mean_);
+        } else {
+            mean_ = 0.0;
+            m2_ = 0.0;
+        }
+        --count_;
+    }
+    if (window_ > 0) values_.push(x);
+
+    ++count_;
+    double delta = x - mean_;
+    mean_ += delta / count_;
+    m2_ += delta * (x - mean_);
+
+    // Windowed instances recompute exactly once per window to bound drift
+    if (window_ > 0 && ++since_recompute_ >= window_) {
+        recompute();
+    }
+}
+
+void RollingVariance::recompute() {
+    mean_ = values_.sum() / values_.size();
+    m2_ = values_.sum_sq_dev(mean_);
+    since_recompute_ = 0;
+}
+
+double RollingVariance::mean() const {
+    return count_ ? mean_ : NAN;
+}
+
+double RollingVariance::variance() const {
+    if (count_ == 0) return NAN;
+    if (count_ < 2) return 0.0;
+    return std::max(0.0, m2_) / (count_ - 1);
+}
+
+double RollingVariance::stddev() const {
+    return std::sqrt(variance());
+}
+
+RollingVariance::State RollingVariance::snapshot() const {
+    return State{window_, count_, mean_, m2_, window_ > 0 ? values_.values() : std::vector<double>{}};
+}
+
+void RollingVariance::restore(const State& state) {
+    window_ = state.window > 0 ? state.window : 0;
+    count_ = state.count;
+    mean_ = state.mean;
+    m2_ = state.m2;
+    values_ = RingWindow(window_);
+    values_.assign(state.values);
+    since_recompute_ = 0;
+}
+
+// ---- RollingMaxDrawdown ----
+
+void RollingMaxDrawdown::push(double price) {
+    if (!started_ || price > peak_) {
+        peak_ = price;
+        started_ = true;
+    }
+    double dd = (peak_ - price) / peak_;
+    if (dd > max_drawdown_) max_drawdown_ = dd;
+    last_ = price;
+}
+
+double RollingMaxDrawdown::current_drawdown() const {
+    return started_ ? (peak_ - last_) / peak_ : 0.0;
+}
+
+RollingMaxDrawdown::State RollingMaxDrawdown::snapshot() const {
+    return State{started_, peak_, max_drawdown_, last_};
+}
+
+void RollingMaxDrawdown::restore(const State& state) {
+    started_ = state.started;
+    peak_ = state.peak;
+    max_drawdown_ = state.max_drawdown;
+    last_ = state.last;
+}
+
+} // namespace quant
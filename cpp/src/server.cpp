@@ -1,21 +1,25 @@
 #include "crow.h"
 #include "alphavantage.h"
+#include "arena.h"
+#include "bar_cache.h"
+#include "bar_store.h"
+#include "dates.h"
 #include "signals.h"
+#include "signal_refresher.h"
+#include "signal_stream.h"
+#include "universe.h"
+#include "http_cache.h"
+#include "metrics.h"
+#include "price_sync.h"
 #include <nlohmann/json.hpp>
+#include <algorithm>
 #include <cstdlib>
 #include <chrono>
-#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <sstream>
 
-std::string get_current_date() {
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    std::tm tm = *std::localtime(&time);
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d");
-    return oss.str();
-}
-
 std::vector<std::string> split_symbols(const std::string& symbols_csv) {
     std::vector<std::string> result;
     std::istringstream iss(symbols_csv);
@@ -38,6 +42,82 @@ void add_cors_headers(crow::response& res) {
     res.add_header("Access-Control-Allow-Headers", "Content-Type");
 }
 
+// Serve a prepared JSON body: 304 when the client's ETag still matches,
+// otherwise the negotiated precompressed bytes. max_age tells pollers how
+// long the data stays current.
+crow::response cached_json_response(const crow::request& req, const http::CachedBody& body, long max_age) {
+    auto encoding = body.available(http::negotiate_encoding(req.get_header_value("Accept-Encoding")));
+    std::string etag = body.etag_for(encoding);
+
+    crow::response res;
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", "public, max-age=" + std::to_string(max_age));
+    res.set_header("Vary", "Accept-Encoding");
+    add_cors_headers(res);
+
+    if (http::etag_matches(req.get_header_value("If-None-Match"), etag)) {
+        res.code = 304;
+        return res;
+    }
+
+    res.code = 200;
+    res.body = body.encoded(encoding);
+    res.set_header("Content-Type", "application/json");
+    if (encoding != http::Encoding::Identity) {
+        res.set_header("Content-Encoding", http::encoding_name(encoding));
+    }
+    return res;
+}
+
+crow::response bad_request_response(const std::string& error) {
+    nlohmann::json response;
+    response["error"] = error;
+    crow::response res(400, response.dump());
+    res.set_header("Content-Type", "application/json");
+    add_cors_headers(res);
+    return res;
+}
+
+crow::response bad_date_response(const std::string& date) {
+    return bad_request_response("Invalid date '" + date + "', expected YYYY-MM-DD");
+}
+
+// As-of signals never fetch upstream; name the symbols without local history
+crow::response history_missing_response(const std::vector<std::string>& missing) {
+    nlohmann::json response;
+    response["error"] = "No stored or cached history for " + std::to_string(missing.size()) +
+                        " symbol(s); as-of signals are served from the price store only";
+    response["missing"] = missing;
+    crow::response res(503, response.dump());
+    res.set_header("Content-Type", "application/json");
+    add_cors_headers(res);
+    return res;
+}
+
+// Symbols whose as-of signal failed for lack of local history
+std::vector<std::string> missing_history(const std::vector<signals::Signal>& signals) {
+    std::vector<std::string> missing;
+    for (const auto& signal : signals) {
+        if (alphavantage::BarCache::is_not_cached(signal.error)) missing.push_back(signal.symbol);
+    }
+    return missing;
+}
+
+crow::response unknown_universe_response(const std::string& name) {
+    nlohmann::json response;
+    response["error"] = "Unknown universe '" + name + "'";
+    crow::response res(404, response.dump());
+    res.set_header("Content-Type", "application/json");
+    add_cors_headers(res);
+    return res;
+}
+
+// Handler latency, one histogram per route pattern
+metrics::Histogram& route_latency(const char* route) {
+    return metrics::registry().timer("http_request_duration_seconds",
+        "Request handling time by route", {{"route", route}});
+}
+
 int main() {
     // Get configuration from environment
     const char* api_key_env = std::getenv("ALPHAVANTAGE_API_KEY");
@@ -49,18 +129,185 @@ int main() {
     const char* port_env = std::getenv("PORT");
     int port = port_env ? std::stoi(port_env) : 8080;
 
+    const char* cache_ttl_env = std::getenv("BAR_CACHE_TTL_SECONDS");
+    int cache_ttl = cache_ttl_env ? std::stoi(cache_ttl_env) : 900;
+
+    const char* concurrency_env = std::getenv("FETCH_CONCURRENCY");
+    int fetch_concurrency = concurrency_env ? std::stoi(concurrency_env) : 8;
+
+    // Upstream quota; 5/min matches the AlphaVantage free tier, 0 = unlimited
+    const char* rpm_env = std::getenv("ALPHAVANTAGE_RPM");
+    const char* rpd_env = std::getenv("ALPHAVANTAGE_RPD");
+    alphavantage::RateLimits rate_limits;
+    rate_limits.per_minute = rpm_env ? std::stoi(rpm_env) : 5;
+    rate_limits.per_day = rpd_env ? std::stoi(rpd_env) : 0;
+
+    const char* refresh_env = std::getenv("SIGNAL_REFRESH_SECONDS");
+    int refresh_seconds = refresh_env ? std::stoi(refresh_env) : cache_ttl;
+
+    const char* stream_interval_env = std::getenv("SIGNAL_STREAM_INTERVAL_MS");
+    int stream_interval_ms = stream_interval_env ? std::stoi(stream_interval_env) : 250;
+    // Unacknowledged bytes a websocket client may hold before updates wait for its ack
+    const char* stream_queue_env = std::getenv("SIGNAL_STREAM_MAX_QUEUED_BYTES");
+    size_t stream_max_queued = stream_queue_env ? std::stoul(stream_queue_env) : size_t(1) << 20;
+
+    // Trained prob_up coefficients (train_model output); unset = trend lookup table
+    const char* model_path_env = std::getenv("PROB_MODEL_PATH");
+    std::string model_path = model_path_env ? model_path_env : "";
+
+    // Most symbols one POST /api/signals request may ask for, and how many
+    // of them not in a snapshot or the bar cache it may fetch upstream
+    const char* batch_max_env = std::getenv("SIGNALS_BATCH_MAX_SYMBOLS");
+    size_t batch_max_symbols = batch_max_env ? std::stoul(batch_max_env) : 100;
+    const char* batch_fetch_env = std::getenv("SIGNALS_BATCH_MAX_FETCHES");
+    size_t batch_max_fetches = batch_fetch_env ? std::stoul(batch_fetch_env) : 5;
+
+    // Directory of <NAME>.txt symbol lists selectable with ?universe=
+    const char* universe_dir_env = std::getenv("UNIVERSE_DIR");
+    std::string universe_dir = universe_dir_env ? universe_dir_env : "universes";
+
+    // postgresql://... or sqlite:path; unset = no persistence
+    const char* store_url_env = std::getenv("PRICE_STORE_URL");
+    std::string store_url = store_url_env ? store_url_env : "";
+
+    // quant_core --write-store output, memory-mapped at startup for as-of
+    // history; unset = price store only
+    const char* bar_store_env = std::getenv("BAR_STORE_PATH");
+    std::string bar_store_path = bar_store_env ? bar_store_env : "";
+
     // Initialize services
-    alphavantage::Client av_client(api_key);
-    signals::SignalService signal_service(av_client);
+    alphavantage::Client av_client(api_key, fetch_concurrency, rate_limits);
+
+    // With a price store, bars are served from local storage and each symbol
+    // is topped up from AlphaVantage at most once per cache TTL
+    std::unique_ptr<store::PriceStore> price_store;
+    std::unique_ptr<store::PriceSync> price_sync;
+    if (!store_url.empty()) {
+        std::string store_error;
+        price_store = store::open_price_store(store_url, store_error);
+        if (price_store) {
+            price_sync = std::make_unique<store::PriceSync>(*price_store, av_client, std::chrono::seconds(cache_ttl));
+        } else {
+            std::cerr << "WARNING: price store unavailable (" << store_error << "), fetching upstream only" << std::endl;
+        }
+    }
+    auto bar_cache_ptr = price_sync
+        ? std::make_unique<alphavantage::BarCache>(
+              [&price_sync](const std::string& symbol, const std::string& outputsize) {
+                  return price_sync->fetch(symbol, outputsize);
+              }, std::chrono::seconds(cache_ttl),
+              [&price_sync](const std::vector<std::string>& batch, const std::string& outputsize,
+                            const alphavantage::Client::BatchCallback& on_done, alphavantage::Priority priority) {
+                  price_sync->fetch_many(batch, outputsize, on_done, priority);
+              })
+        : std::make_unique<alphavantage::BarCache>(av_client, std::chrono::seconds(cache_ttl));
+    alphavantage::BarCache& bar_cache = *bar_cache_ptr;
+    // Opening the .qbars store is one mmap, whatever the history length
+    quant::BarStore bar_store;
+    if (!bar_store_path.empty()) {
+        std::string bar_store_error;
+        if (!bar_store.open(bar_store_path, bar_store_error)) {
+            std::cerr << "WARNING: bar store unavailable (" << bar_store_error << ")" << std::endl;
+        }
+    }
+    // As-of signals read stored history only, never the upstream queue: the
+    // price store first (it is topped up), then the .qbars snapshot
+    if (price_sync || bar_store.size() > 0) {
+        bar_cache.set_local_fetch([&price_sync, &bar_store](const std::string& symbol, const std::string& outputsize) {
+            auto result = price_sync ? price_sync->stored(symbol, outputsize)
+                                     : alphavantage::FetchResult::failure("No stored data for " + symbol);
+            if (result.ok()) return result;
+            if (auto bars = bar_store.find(symbol)) {
+                result = alphavantage::FetchResult{};
+                result.bars = (outputsize == "compact" ? bars->last(100) : *bars).to_series();
+            }
+            return result;
+        });
+    }
+    signals::SignalService signal_service(bar_cache);
+    if (!model_path.empty()) {
+        auto prob_model = std::make_shared<model::ProbModel>();
+        std::string model_error;
+        if (model::ProbModel::load(model_path, *prob_model, model_error)) {
+            signal_service.set_model(std::move(prob_model));
+        } else {
+            std::cerr << "WARNING: " << model_error << "; using the trend lookup table" << std::endl;
+        }
+    }
 
     auto symbols = split_symbols(symbols_csv);
 
+    // The configured symbols come first, as the universe the refresher serves
+    std::vector<signals::Universe> universes{{signals::kDefaultUniverse, symbols}};
+    std::string universe_error;
+    if (!signals::load_universes(universe_dir, universes, universe_error)) {
+        std::cerr << "WARNING: " << universe_error << std::endl;
+    }
+    const signals::Universe* default_universe = &universes.front();
+
+    // Signals for every universe are computed in the background, from one
+    // batch of fetches per round; /api/signals only serves published snapshots
+    signals::SignalRefresher refresher(signal_service, symbols, std::chrono::seconds(std::max(1, refresh_seconds)));
+    for (size_t i = 1; i < universes.size(); ++i) refresher.add_universe(universes[i]);
+
+    // Each published snapshot is diffed once and pushed to every websocket subscriber
+    signals::SignalStream signal_stream(std::chrono::milliseconds(std::max(0, stream_interval_ms)), stream_max_queued);
+    refresher.on_publish([&signal_stream](const signals::SignalRefresher::Snapshot& snapshot) {
+        signal_stream.publish(snapshot);
+    });
+
+    // Websocket clients by an id kept in the connection's userdata; the
+    // stream sends through the id, so a closed connection is never touched
+    struct StreamClient {
+        crow::websocket::connection* conn;
+        uint64_t subscription = 0;
+    };
+    std::mutex stream_clients_mutex;
+    std::unordered_map<uintptr_t, StreamClient> stream_clients;
+    uintptr_t next_stream_client = 1;
+
+    // State other components already track, sampled on each /metrics scrape
+    auto& registry = metrics::registry();
+    registry.counter_fn("bar_cache_lookups_total", "Bar cache lookups by result", {{"result", "hit"}},
+        [&bar_cache]() { return static_cast<double>(bar_cache.stats().hits); });
+    registry.counter_fn("bar_cache_lookups_total", "Bar cache lookups by result", {{"result", "miss"}},
+        [&bar_cache]() { return static_cast<double>(bar_cache.stats().misses); });
+    registry.counter_fn("bar_cache_lookups_total", "Bar cache lookups by result", {{"result", "coalesced"}},
+        [&bar_cache]() { return static_cast<double>(bar_cache.stats().coalesced); });
+    registry.gauge_fn("bar_cache_entries", "Cached (symbol, outputsize) entries", {},
+        [&bar_cache]() { return static_cast<double>(bar_cache.stats().entries); });
+    registry.gauge_fn("upstream_requests_used_today", "Upstream requests counted against the daily quota", {},
+        [&av_client]() { return static_cast<double>(av_client.rate_limiter().used_today()); });
+    registry.gauge_fn("signal_snapshot_age_seconds", "Age of the published signal snapshot", {},
+        [&refresher]() {
+            auto snapshot = refresher.current();
+            if (!snapshot) return static_cast<double>(NAN);
+            return std::chrono::duration<double>(std::chrono::system_clock::now() - snapshot->computed_at).count();
+        });
+    registry.gauge_fn("signal_refresh_duration_seconds", "Time taken by the last universe refresh", {},
+        [&refresher]() {
+            auto snapshot = refresher.current();
+            return snapshot ? std::chrono::duration<double>(snapshot->refresh_duration).count() : NAN;
+        });
+    registry.counter_fn("signal_memo_lookups_total", "As-of signal memo lookups by result", {{"result", "hit"}},
+        [&signal_service]() { return static_cast<double>(signal_service.memo_stats().hits); });
+    registry.counter_fn("signal_memo_lookups_total", "As-of signal memo lookups by result", {{"result", "miss"}},
+        [&signal_service]() { return static_cast<double>(signal_service.memo_stats().misses); });
+    registry.gauge_fn("signal_stream_subscribers", "Connected websocket subscribers", {},
+        [&signal_stream]() { return static_cast<double>(signal_stream.subscribers()); });
+    registry.counter_fn("arena_heap_blocks_total", "Blocks request arenas drew from the heap", {},
+        []() { return static_cast<double>(quant::arena_totals().heap_blocks); });
+    registry.counter_fn("arena_scopes_total", "Request arena scopes completed", {},
+        []() { return static_cast<double>(quant::arena_totals().scopes); });
+
     // Create Crow app
     crow::SimpleApp app;
 
     // Health check endpoint
     CROW_ROUTE(app, "/actuator/health")
     ([]() {
+        static metrics::Histogram& latency = route_latency("/actuator/health");
+        metrics::ScopedTimer timer(latency);
         nlohmann::json response;
         response["status"] = "UP";
         crow::response res(200, response.dump());
@@ -69,13 +316,93 @@ int main() {
         return res;
     });
 
+    // Prometheus scrape endpoint
+    CROW_ROUTE(app, "/metrics")
+    ([]() {
+        crow::response res(200, metrics::registry().expose());
+        res.set_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+        return res;
+    });
+
+    // Bar cache and signal snapshot statistics
+    CROW_ROUTE(app, "/actuator/caches")
+    ([&bar_cache, &refresher, &signal_service, &signal_stream, &av_client, &price_store]() {
+        static metrics::Histogram& latency = route_latency("/actuator/caches");
+        metrics::ScopedTimer timer(latency);
+        auto stats = bar_cache.stats();
+        nlohmann::json response;
+        response["ttl_seconds"] = bar_cache.ttl().count();
+        response["hits"] = stats.hits;
+        response["misses"] = stats.misses;
+        response["coalesced"] = stats.coalesced;
+        response["entries"] = stats.entries;
+        response["oldest_age_seconds"] = stats.oldest_age_seconds;
+
+        nlohmann::json entries = nlohmann::json::array();
+        for (const auto& entry : bar_cache.entries()) {
+            nlohmann::json e;
+            e["symbol"] = entry.symbol;
+            e["outputsize"] = entry.outputsize;
+            e["bars"] = entry.bars;
+            e["age_seconds"] = entry.age_seconds;
+            entries.push_back(e);
+        }
+        response["cached"] = entries;
+
+        nlohmann::json snapshot_info;
+        snapshot_info["refresh_seconds"] = refresher.interval().count();
+        if (auto snapshot = refresher.current()) {
+            auto age = std::chrono::system_clock::now() - snapshot->computed_at;
+            snapshot_info["version"] = snapshot->version;
+            snapshot_info["as_of"] = snapshot->as_of;
+            snapshot_info["age_seconds"] = std::chrono::duration<double>(age).count();
+            snapshot_info["refresh_ms"] = snapshot->refresh_duration.count();
+        }
+        response["signal_snapshot"] = snapshot_info;
+
+        auto memo = signal_service.memo_stats();
+        nlohmann::json memo_info;
+        memo_info["hits"] = memo.hits;
+        memo_info["misses"] = memo.misses;
+        memo_info["entries"] = memo.entries;
+        response["as_of_memo"] = memo_info;
+        response["stream_subscribers"] = signal_stream.subscribers();
+
+        nlohmann::json upstream;
+        upstream["requests_per_minute"] = av_client.rate_limiter().limits().per_minute;
+        upstream["requests_per_day"] = av_client.rate_limiter().limits().per_day;
+        upstream["used_today"] = av_client.rate_limiter().used_today();
+        response["upstream"] = upstream;
+
+        if (price_store) {
+            nlohmann::json stored;
+            stored["backend"] = price_store->backend();
+            stored["symbols"] = price_store->symbol_count();
+            response["price_store"] = stored;
+        }
+
+        // Request scratch arenas: heap_blocks stops growing once every
+        // worker thread has seen its largest request
+        auto arena = quant::arena_totals();
+        nlohmann::json arena_info;
+        arena_info["scopes"] = arena.scopes;
+        arena_info["heap_blocks"] = arena.heap_blocks;
+        arena_info["heap_bytes"] = arena.heap_bytes;
+        response["arena"] = arena_info;
+
+        crow::response res(200, response.dump());
+        res.set_header("Content-Type", "application/json");
+        add_cors_headers(res);
+        return res;
+    });
+
     // Get available universes
     CROW_ROUTE(app, "/api/universe")
-    ([]() {
+    ([&universes]() {
+        static metrics::Histogram& latency = route_latency("/api/universe");
+        metrics::ScopedTimer timer(latency);
         nlohmann::json response = nlohmann::json::array();
-        response.push_back("SP500");
-        response.push_back("NASDAQ100");
-        response.push_back("WATCHLIST");
+        for (const auto& universe : universes) response.push_back(universe.name);
 
         crow::response res(200, response.dump());
         res.set_header("Content-Type", "application/json");
@@ -83,57 +410,257 @@ int main() {
         return res;
     });
 
-    // Get signals
+    // Get signals; ?universe=NAME selects the symbols (default: STOCK_SYMBOLS),
+    // each served from its refreshed snapshot, and ?date=YYYY-MM-DD evaluates
+    // them as of that day's close
     CROW_ROUTE(app, "/api/signals")
-    ([&signal_service, &symbols](const crow::request& req) {
-        // Get optional date parameter
-        std::string as_of = get_current_date();
-        if (req.url_params.get("date")) {
-            as_of = req.url_params.get("date");
+    ([&refresher, &signal_service, &universes, default_universe](const crow::request& req) {
+        static metrics::Histogram& latency = route_latency("/api/signals");
+        metrics::ScopedTimer timer(latency);
+
+        const signals::Universe* universe = default_universe;
+        if (const char* name = req.url_params.get("universe")) {
+            universe = signals::find_universe(universes, name);
+            if (!universe) return unknown_universe_response(name);
         }
+        auto snapshot = universe == default_universe ? refresher.current() : refresher.current(universe->name);
 
-        // Compute signals for all configured symbols
-        auto computed_signals = signal_service.compute_signals(symbols);
+        const char* date = req.url_params.get("date");
+        if (date && (!snapshot || snapshot->as_of != date)) {
+            int32_t day = quant::parse_date(date);
+            if (day == quant::kInvalidDate) return bad_date_response(date);
+            signals::SignalColumns columns;
+            auto as_of_signals = signal_service.compute_signals(universe->symbols, day, &columns);
+            auto missing = missing_history(as_of_signals);
+            if (!missing.empty()) return history_missing_response(missing);
+            std::string json;
+            signals::SignalService::write_json(json, as_of_signals, columns, date);
+            // Built per request, so only the encoding this client takes is compressed
+            auto encoding = http::negotiate_encoding(req.get_header_value("Accept-Encoding"));
+            return cached_json_response(req, http::CachedBody::make_for(std::move(json), encoding),
+                                        refresher.seconds_until_refresh());
+        }
 
-        // Convert to JSON
-        auto response = signals::SignalService::to_json(computed_signals, as_of);
+        if (!snapshot) {
+            nlohmann::json response;
+            response["status"] = "warming_up";
+            crow::response res(503, response.dump());
+            res.set_header("Content-Type", "application/json");
+            res.set_header("Retry-After", "5");
+            add_cors_headers(res);
+            return res;
+        }
+        return cached_json_response(req, snapshot->body, refresher.seconds_until_refresh());
+    });
 
-        crow::response res(200, response.dump());
-        res.set_header("Content-Type", "application/json");
+    // Signals for an ad-hoc list, POSTed as {"symbols": [...], "date": "YYYY-MM-DD"}
+    // (date optional). Symbols are normalized and de-duplicated, resolved in
+    // one batch, and written as NDJSON, one signal per line in completion
+    // order. This is a bounded batch endpoint, not a stream: Crow 1.0 buffers
+    // res.write() until res.end(), so the client sees nothing until every
+    // line is written. The bounds keep that wait short: live signals come
+    // from the refreshed snapshots where possible, and of the rest at most
+    // batch_max_fetches uncached symbols are fetched upstream while the
+    // others are reported as errors. Clients that need signals as they land
+    // subscribe to /ws/signals.
+    CROW_ROUTE(app, "/api/signals").methods("POST"_method)
+    ([&signal_service, &refresher, batch_max_symbols, batch_max_fetches](const crow::request& req,
+                                                                         crow::response& res) {
+        static metrics::Histogram& latency = route_latency("POST /api/signals");
+        metrics::ScopedTimer timer(latency);
+        auto request = nlohmann::json::parse(req.body, nullptr, false);
+        if (request.is_discarded() || !request.is_object() || !request.contains("symbols") ||
+            !request["symbols"].is_array()) {
+            res = bad_request_response(R"(expected {"symbols": [...], "date": "YYYY-MM-DD"})");
+            return res.end();
+        }
+        std::vector<std::string> requested;
+        for (const auto& symbol : request["symbols"]) {
+            if (!symbol.is_string()) {
+                res = bad_request_response("symbols must be strings");
+                return res.end();
+            }
+            requested.push_back(symbol.get<std::string>());
+        }
+        std::vector<std::string> symbols;
+        std::string error;
+        if (!signals::normalize_symbols(requested, symbols, error)) {
+            res = bad_request_response(error);
+            return res.end();
+        }
+        if (symbols.size() > batch_max_symbols) {
+            res = bad_request_response("At most " + std::to_string(batch_max_symbols) + " symbols per request");
+            return res.end();
+        }
+
+        int32_t day = quant::kInvalidDate;
+        if (request.contains("date")) {
+            std::string date = request["date"].is_string() ? request["date"].get<std::string>() : request["date"].dump();
+            day = quant::parse_date(date);
+            if (day == quant::kInvalidDate) {
+                res = bad_date_response(date);
+                return res.end();
+            }
+        }
+
+        res.code = 200;
+        res.set_header("Content-Type", "application/x-ndjson");
         add_cors_headers(res);
-        return res;
+        std::string line;
+        auto write_line = [&res, &line](size_t, const signals::Signal& signal) {
+            line.clear();
+            signals::SignalService::write_signal_json(line, signal);
+            line += '\n';
+            res.write(line);
+        };
+        if (day != quant::kInvalidDate) {
+            signal_service.stream_signals(symbols, day, write_line);
+            return res.end();
+        }
+
+        auto snapshots = refresher.snapshots();
+        std::unordered_map<std::string_view, const signals::Signal*> refreshed;
+        for (const auto& snapshot : snapshots) {
+            for (const auto& signal : snapshot->signals) refreshed.emplace(signal.symbol, &signal);
+        }
+        std::vector<std::string> uncached;
+        for (auto& symbol : symbols) {
+            auto it = refreshed.find(symbol);
+            if (it != refreshed.end()) {
+                write_line(0, *it->second);
+            } else {
+                uncached.push_back(std::move(symbol));
+            }
+        }
+        signal_service.stream_signals(uncached, write_line, batch_max_fetches);
+        res.end();
     });
 
-    // Get signal for specific symbol
+    // Get signal for specific symbol; universe symbols come from the snapshot
+    // and ?date=YYYY-MM-DD evaluates it as of that day's close
     CROW_ROUTE(app, "/api/signals/<string>")
-    ([&signal_service](const std::string& symbol) {
-        auto signal = signal_service.compute_signal(symbol);
-        auto response = signals::SignalService::signal_to_json(signal);
+    ([&signal_service, &refresher](const crow::request& req, const std::string& symbol) {
+        static metrics::Histogram& latency = route_latency("/api/signals/<string>");
+        metrics::ScopedTimer timer(latency);
+        const char* date = req.url_params.get("date");
+        if (date) {
+            int32_t day = quant::parse_date(date);
+            if (day == quant::kInvalidDate) return bad_date_response(date);
+            auto as_of_signal = signal_service.compute_signal(symbol, day);
+            if (alphavantage::BarCache::is_not_cached(as_of_signal.error)) return history_missing_response({symbol});
+            std::string json;
+            signals::SignalService::write_signal_json(json, as_of_signal);
+            return cached_json_response(req, http::CachedBody::make(std::move(json), false),
+                                        refresher.seconds_until_refresh());
+        }
 
-        crow::response res(200, response.dump());
-        res.set_header("Content-Type", "application/json");
-        add_cors_headers(res);
-        return res;
+        auto snapshot = refresher.current();
+        const signals::Signal* cached = nullptr;
+        for (size_t i = 0; snapshot && !cached && i < snapshot->signals.size(); ++i) {
+            if (snapshot->signals[i].symbol == symbol) cached = &snapshot->signals[i];
+        }
+        std::string json;
+        signals::SignalService::write_signal_json(json, cached ? *cached : signal_service.compute_signal(symbol));
+
+        // Single-symbol bodies are small; hash them but skip compression
+        auto body = http::CachedBody::make(std::move(json), false);
+        return cached_json_response(req, body, cached ? refresher.seconds_until_refresh() : 0);
+    });
+
+    // Push changed signals as they are refreshed. Clients may send
+    // {"symbols": ["AAPL", ...]} to narrow the stream (empty = all).
+    CROW_WEBSOCKET_ROUTE(app, "/ws/signals")
+    .onopen([&signal_stream, &stream_clients, &stream_clients_mutex, &next_stream_client](crow::websocket::connection& conn) {
+        uintptr_t client;
+        {
+            std::lock_guard<std::mutex> lock(stream_clients_mutex);
+            client = next_stream_client++;
+            stream_clients[client] = StreamClient{&conn};
+        }
+        conn.userdata(reinterpret_cast<void*>(client));
+        uint64_t subscription = signal_stream.subscribe([&stream_clients, &stream_clients_mutex, client](const std::string& message) {
+            std::lock_guard<std::mutex> lock(stream_clients_mutex);
+            auto it = stream_clients.find(client);
+            if (it != stream_clients.end()) it->second.conn->send_text(message);
+        });
+        std::lock_guard<std::mutex> lock(stream_clients_mutex);
+        stream_clients[client].subscription = subscription;
+    })
+    .onclose([&signal_stream, &stream_clients, &stream_clients_mutex](crow::websocket::connection& conn, const std::string&) {
+        uint64_t subscription = 0;
+        {
+            std::lock_guard<std::mutex> lock(stream_clients_mutex);
+            auto it = stream_clients.find(reinterpret_cast<uintptr_t>(conn.userdata()));
+            if (it == stream_clients.end()) return;
+            subscription = it->second.subscription;
+            stream_clients.erase(it);
+        }
+        signal_stream.unsubscribe(subscription);
+    })
+    .onmessage([&signal_stream, &stream_clients, &stream_clients_mutex](crow::websocket::connection& conn,
+                                                                        const std::string& data, bool) {
+        // {"ack": V} after processing message V; {"symbols": [...]} narrows the stream
+        auto request = nlohmann::json::parse(data, nullptr, false);
+        bool is_ack = !request.is_discarded() && request.contains("ack") && request["ack"].is_number_unsigned();
+        bool is_filter = !request.is_discarded() && request.contains("symbols") && request["symbols"].is_array();
+        if (!is_ack && !is_filter) {
+            conn.send_text(R"({"type":"error","error":"expected {\"symbols\": [...]} or {\"ack\": version}"})");
+            return;
+        }
+        uint64_t subscription = 0;
+        {
+            std::lock_guard<std::mutex> lock(stream_clients_mutex);
+            auto it = stream_clients.find(reinterpret_cast<uintptr_t>(conn.userdata()));
+            if (it == stream_clients.end()) return;
+            subscription = it->second.subscription;
+        }
+        if (is_ack) {
+            signal_stream.ack(subscription, request["ack"].get<uint64_t>());
+            return;
+        }
+        std::vector<std::string> wanted;
+        for (const auto& symbol : request["symbols"]) {
+            if (symbol.is_string()) wanted.push_back(symbol.get<std::string>());
+        }
+        signal_stream.set_filter(subscription, wanted);
     });
 
     // Trigger manual data ingestion
     CROW_ROUTE(app, "/api/ingest").methods("POST"_method)
-    ([&av_client, &symbols]() {
+    ([&av_client, &symbols, &price_sync]() {
+        static metrics::Histogram& latency = route_latency("/api/ingest");
+        metrics::ScopedTimer timer(latency);
         nlohmann::json response;
         response["symbols_attempted"] = symbols.size();
 
-        int records_ingested = 0;
-        nlohmann::json failed = nlohmann::json::array();
+        size_t records_ingested = 0;
+        std::vector<std::string> failures;
 
-        for (const auto& symbol : symbols) {
-            auto bars = av_client.fetch_daily_adjusted(symbol);
-            if (bars.empty()) {
-                failed.push_back(symbol + ": " + av_client.last_error());
-            } else {
-                records_ingested += static_cast<int>(bars.size());
+        if (price_sync) {
+            // Full history for new symbols, compact top-ups for the rest
+            auto report = price_sync->ingest(symbols);
+            records_ingested = report.records_written;
+            failures = std::move(report.failed);
+            response["store"] = price_sync->store().backend();
+        } else {
+            std::vector<std::string> errors(symbols.size());
+            av_client.fetch_many(symbols, "compact",
+                [&](size_t index, alphavantage::FetchResult result) {
+                    if (!result.ok()) {
+                        errors[index] = result.error;
+                    } else {
+                        records_ingested += result.bars.size();
+                    }
+                });
+            for (size_t i = 0; i < symbols.size(); ++i) {
+                if (!errors[i].empty()) {
+                    failures.push_back(symbols[i] + ": " + errors[i]);
+                }
             }
         }
 
+        nlohmann::json failed = failures;
+
         response["records_ingested"] = records_ingested;
         response["failed_symbols"] = failed;
 
@@ -157,13 +684,34 @@ int main() {
     std::cout << "Port: " << port << std::endl;
     std::cout << "API Key configured: " << (api_key.empty() ? "NO" : "YES") << std::endl;
     std::cout << "Symbols: " << symbols_csv << std::endl;
+    std::cout << "Universes:";
+    for (const auto& universe : universes) std::cout << ' ' << universe.name << " (" << universe.symbols.size() << ")";
+    std::cout << std::endl;
+    std::cout << "Bar cache TTL: " << cache_ttl << "s" << std::endl;
+    std::cout << "Batch signal limit: " << batch_max_symbols << " symbols, "
+              << batch_max_fetches << " upstream fetches" << std::endl;
+    std::cout << "Fetch concurrency: " << av_client.max_in_flight() << std::endl;
+    std::cout << "Upstream quota: " << rate_limits.per_minute << "/min, "
+              << (rate_limits.per_day > 0 ? std::to_string(rate_limits.per_day) : std::string("unlimited")) << "/day" << std::endl;
+    std::cout << "Signal refresh: " << refresher.interval().count() << "s" << std::endl;
+    std::cout << "prob_up model: " << (signal_service.model() ? signal_service.model()->version : "trend lookup table") << std::endl;
+    std::cout << "Price store: " << (price_store ? price_store->backend() : "none") << std::endl;
+    std::cout << "Bar store: " << (bar_store.size() > 0 ? bar_store_path + " (" + std::to_string(bar_store.size()) + " symbols)"
+                                                          : std::string("none")) << std::endl;
+    std::cout << "Signal stream: /ws/signals (min interval " << stream_interval_ms << "ms, "
+              << stream_max_queued << " unacked bytes per client)" << std::endl;
+    std::cout << "Metrics: /metrics" << std::endl;
     std::cout << std::endl;
 
     if (api_key.empty()) {
         std::cerr << "WARNING: ALPHAVANTAGE_API_KEY not set. API calls will fail." << std::endl;
     }
 
+    signal_stream.start();
+    refresher.start();
     app.port(port).multithreaded().run();
+    refresher.stop();
+    signal_stream.stop();
 
     return 0;
 }
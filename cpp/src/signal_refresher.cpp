@@ -0,0 +1,177 @@
+#include "signal_refresher.h"
+#include "dates.h"
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <unordered_map>
+
+namespace signals {
+
+namespace {
+    constexpr int kMaxBackoffFactor = 8;
+
+    bool rate_limited(const Signal& signal) {
+        return signal.error.rfind("Rate limit", 0) == 0;
+    }
+}
+
+std::string SignalRefresher::today() {
+    return quant::format_date(static_cast<int32_t>(std::time(nullptr) / 86400));
+}
+
+SignalRefresher::SignalRefresher(SignalService& service, std::vector<std::string> symbols,
+                                 std::chrono::seconds interval)
+    : service_(service), symbols_(std::move(symbols)), interval_(interval) {}
+
+SignalRefresher::~SignalRefresher() {
+    stop();
+}
+
+void SignalRefresher::start() {
+    if (worker_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = false;
+    }
+    worker_ = std::thread([this] { run(); });
+}
+
+void SignalRefresher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+void SignalRefresher::refresh_now() {
+    refresh();
+}
+
+long SignalRefresher::seconds_until_refresh() const {
+    auto snapshot = current();
+    if (!snapshot) return 0;
+    auto due = snapshot->computed_at + interval_;
+    auto left = std::chrono::duration_cast<std::chrono::seconds>(due - std::chrono::system_clock::now());
+    return std::max<long>(0, left.count());
+}
+
+SignalRefresher::Snapshot SignalRefresher::current(std::string_view universe) const {
+    const Universe* found = find_universe(universes_, universe);
+    if (!found) return nullptr;
+    auto snapshots = std::atomic_load(&universe_snapshots_);
+    size_t index = static_cast<size_t>(found - universes_.data());
+    return snapshots && index < snapshots->size() ? (*snapshots)[index] : nullptr;
+}
+
+std::vector<SignalRefresher::Snapshot> SignalRefresher::snapshots() const {
+    std::vector<Snapshot> all;
+    if (auto snapshot = current()) all.push_back(std::move(snapshot));
+    if (auto universes = std::atomic_load(&universe_snapshots_)) {
+        for (const auto& snapshot : *universes) {
+            if (snapshot) all.push_back(snapshot);
+        }
+    }
+    return all;
+}
+
+bool SignalRefresher::refresh() {
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    auto started = Clock::now();
+    auto previous = current();
+    auto previous_universes = std::atomic_load(&universe_snapshots_);
+    const std::string as_of = today();
+
+    // The configured symbols come first, then the added universes' symbols
+    // not already listed, so every universe is computed from one batch
+    std::vector<std::string> symbols = symbols_;
+    std::unordered_map<std::string, size_t> row;
+    for (size_t i = 0; i < symbols.size(); ++i) row.emplace(symbols[i], i);
+    for (const auto& universe : universes_) {
+        for (const auto& symbol : universe.symbols) {
+            if (row.emplace(symbol, symbols.size()).second) symbols.push_back(symbol);
+        }
+    }
+    SignalColumns columns;
+    std::vector<Signal> signals = service_.compute_signals(symbols, &columns);
+    bool limited = std::any_of(signals.begin(), signals.end(), rate_limited);
+
+    // A symbol that failed this round keeps its last good signal, so one bad
+    // upstream response does not blank a row on the dashboard. Carried-over
+    // signals are marked stale with the date they were computed on.
+    std::unordered_map<std::string, std::pair<const Signal*, const std::string*>> last_good;
+    auto remember = [&last_good](const Snapshot& snapshot) {
+        if (!snapshot) return;
+        for (const auto& signal : snapshot->signals) {
+            if (signal.error.empty()) last_good.emplace(signal.symbol, std::make_pair(&signal, &snapshot->as_of));
+        }
+    };
+    remember(previous);
+    if (previous_universes) {
+        for (const auto& snapshot : *previous_universes) remember(snapshot);
+    }
+    for (size_t i = 0; i < signals.size(); ++i) {
+        if (signals[i].error.empty()) continue;
+        auto it = last_good.find(signals[i].symbol);
+        if (it == last_good.end()) continue;
+        signals[i] = *it->second.first;
+        if (signals[i].stale_as_of.empty()) signals[i].stale_as_of = *it->second.second;
+        columns.set(i, signals[i]);
+    }
+
+    auto make = [&](const std::vector<size_t>& rows, const Snapshot& before) {
+        auto snapshot = std::make_shared<SignalSnapshot>();
+        snapshot->version = before ? before->version + 1 : 1;
+        snapshot->as_of = as_of;
+        SignalColumns picked;
+        picked.resize(rows.size());
+        snapshot->signals.reserve(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            snapshot->signals.push_back(signals[rows[i]]);
+            picked.monthly_return[i] = columns.monthly_return[rows[i]];
+            picked.volatility[i] = columns.volatility[rows[i]];
+            picked.valid[i] = columns.valid[rows[i]];
+        }
+        std::string body;
+        SignalService::write_json(body, snapshot->signals, picked, snapshot->as_of);
+        snapshot->body = http::CachedBody::make(std::move(body));
+        snapshot->computed_at = std::chrono::system_clock::now();
+        snapshot->refresh_duration = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - started);
+        return Snapshot(std::move(snapshot));
+    };
+
+    std::vector<size_t> rows(symbols_.size());
+    for (size_t i = 0; i < rows.size(); ++i) rows[i] = i;
+    Snapshot published = make(rows, previous);
+
+    auto universe_snapshots = std::make_shared<std::vector<Snapshot>>();
+    for (size_t u = 0; u < universes_.size(); ++u) {
+        rows.clear();
+        for (const auto& symbol : universes_[u].symbols) rows.push_back(row.at(symbol));
+        Snapshot before = previous_universes && u < previous_universes->size() ? (*previous_universes)[u] : nullptr;
+        universe_snapshots->push_back(make(rows, before));
+    }
+
+    std::atomic_store(&universe_snapshots_, Snapshots(std::move(universe_snapshots)));
+    std::atomic_store(&snapshot_, published);
+    if (on_publish_) on_publish_(published);
+    return limited;
+}
+
+void SignalRefresher::run() {
+    int backoff = 1;
+    for (;;) {
+        try {
+            backoff = refresh() ? std::min(backoff * 2, kMaxBackoffFactor) : 1;
+        } catch (const std::exception& e) {
+            std::cerr << "Signal refresh failed: " << e.what() << std::endl;
+            backoff = std::min(backoff * 2, kMaxBackoffFactor);
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        if (wake_.wait_for(lock, interval_ * backoff, [this] { return stopping_; })) return;
+    }
+}
+
+} // namespace signals
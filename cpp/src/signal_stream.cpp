@@ -0,0 +1,210 @@
+#include "signal_stream.h"
+#include "json_writer.h"
+#include <algorithm>
+
+namespace signals {
+
+namespace {
+    constexpr std::chrono::milliseconds kMinPumpInterval{10};
+}
+
+SignalStream::SignalStream(std::chrono::milliseconds min_interval, size_t max_queued_bytes)
+    : min_interval_(min_interval), max_queued_bytes_(max_queued_bytes) {}
+
+SignalStream::~SignalStream() {
+    stop();
+}
+
+uint64_t SignalStream::subscribe(SendFn send) {
+    std::lock_guard<std::mutex> sending(send_mutex_);
+    std::vector<Outgoing> out;
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+        Subscriber& sub = subscribers_[id];
+        sub.send = std::move(send);
+        sub.sent_version = version_;
+        sub.last_send = Clock::now();
+        if (version_ > 0) queue_locked(sub, build_message_locked("snapshot", sub, 0), out);
+    }
+    deliver(out);
+    return id;
+}
+
+void SignalStream::unsubscribe(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscribers_.erase(id);
+}
+
+void SignalStream::set_filter(uint64_t id, const std::vector<std::string>& symbols) {
+    std::lock_guard<std::mutex> sending(send_mutex_);
+    std::vector<Outgoing> out;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = subscribers_.find(id);
+        if (it == subscribers_.end()) return;
+        Subscriber& sub = it->second;
+        sub.filter = std::unordered_set<std::string>(symbols.begin(), symbols.end());
+        sub.sent_version = version_;
+        sub.last_send = Clock::now();
+        if (version_ > 0) queue_locked(sub, build_message_locked("snapshot", sub, 0), out);
+    }
+    deliver(out);
+}
+
+void SignalStream::ack(uint64_t id, uint64_t version) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = subscribers_.find(id);
+    if (it == subscribers_.end()) return;
+    Subscriber& sub = it->second;
+    while (!sub.unacked.empty() && sub.unacked.front().first <= version) {
+        sub.queued_bytes -= sub.unacked.front().second;
+        sub.unacked.pop_front();
+    }
+}
+
+size_t SignalStream::queued_bytes(uint64_t id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = subscribers_.find(id);
+    return it == subscribers_.end() ? 0 : it->second.queued_bytes;
+}
+
+void SignalStream::publish(const SignalRefresher::Snapshot& snapshot) {
+    if (!snapshot) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Serialize each signal once, into one reused buffer, and keep only
+    // those that differ
+    std::vector<std::string> order;
+    std::vector<Fragment*> changed;
+    std::string json;
+    order.reserve(snapshot->signals.size());
+    for (const auto& signal : snapshot->signals) {
+        order.push_back(signal.symbol);
+        json.clear();
+        SignalService::write_signal_json(json, signal);
+        Fragment& fragment = fragments_[signal.symbol];
+        if (fragment.changed_in == 0 || fragment.json != json) {
+            fragment.json.assign(json);
+            changed.push_back(&fragment);
+        }
+    }
+    order_ = std::move(order);
+    as_of_ = snapshot->as_of;
+    if (changed.empty()) return;
+
+    ++version_;
+    for (Fragment* fragment : changed) fragment->changed_in = version_;
+
+    Subscriber everything;
+    last_diff_ = build_message_locked("diff", everything, version_ - 1);
+    pending_ = true;
+    wake_.notify_all();
+}
+
+void SignalStream::flush() {
+    std::lock_guard<std::mutex> sending(send_mutex_);
+    std::vector<Outgoing> out;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = Clock::now();
+        for (auto& [id, sub] : subscribers_) {
+            if (sub.sent_version >= version_ || now - sub.last_send < min_interval_) continue;
+            // Backlogged: hold everything until it acknowledges, then coalesce
+            if (sub.queued_bytes > max_queued_bytes_) continue;
+
+            if (sub.filter.empty() && sub.sent_version + 1 == version_) {
+                queue_locked(sub, last_diff_, out);
+            } else {
+                // Missed several versions or filtered: coalesce from the fragments
+                bool any = false;
+                for (const auto& symbol : order_) {
+                    const Fragment& fragment = fragments_[symbol];
+                    if (fragment.changed_in > sub.sent_version && (sub.filter.empty() || sub.filter.count(symbol))) {
+                        any = true;
+                        break;
+                    }
+                }
+                if (any) queue_locked(sub, build_message_locked("diff", sub, sub.sent_version), out);
+            }
+            sub.sent_version = version_;
+            sub.last_send = now;
+        }
+    }
+    deliver(out);
+}
+
+void SignalStream::start() {
+    if (pump_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+    }
+    pump_ = std::thread([this] { run(); });
+}
+
+void SignalStream::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (pump_.joinable()) pump_.join();
+}
+
+size_t SignalStream::subscribers() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscribers_.size();
+}
+
+uint64_t SignalStream::version() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return version_;
+}
+
+void SignalStream::queue_locked(Subscriber& sub, Message message, std::vector<Outgoing>& out) {
+    sub.unacked.emplace_back(version_, message->size());
+    sub.queued_bytes += message->size();
+    out.push_back(Outgoing{sub.send, std::move(message)});
+}
+
+void SignalStream::deliver(const std::vector<Outgoing>& out) {
+    for (const auto& outgoing : out) outgoing.send(*outgoing.message);
+}
+
+SignalStream::Message SignalStream::build_message_locked(const char* type, const Subscriber& sub,
+                                                         uint64_t since) const {
+    std::string message = "{\"type\":\"";
+    message += type;
+    message += "\",\"version\":" + std::to_string(version_);
+    message += ",\"as_of\":";
+    http::JsonWriter::append_string(message, as_of_);
+    message += ",\"signals\":[";
+    bool first = true;
+    for (const auto& symbol : order_) {
+        auto it = fragments_.find(symbol);
+        if (it == fragments_.end() || it->second.changed_in <= since) continue;
+        if (!sub.filter.empty() && !sub.filter.count(symbol)) continue;
+        if (!first) message += ',';
+        message += it->second.json;
+        first = false;
+    }
+    message += "]}";
+    return std::make_shared<const std::string>(std::move(message));
+}
+
+void SignalStream::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        // Wake on publish, or after min_interval to drain throttled clients
+        wake_.wait_for(lock, std::max(min_interval_, kMinPumpInterval), [this] { return stopping_ || pending_; });
+        if (stopping_) return;
+        pending_ = false;
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+} // namespace signals
@@ -1,5 +1,10 @@
 #include "signals.h"
-#include "indicators.h"
+#include "arena.h"
+#include "cross_section.h"
+#include "dates.h"
+#include "fused.h"
+#include "json_writer.h"
+#include "metrics.h"
 #include <cmath>
 #include <algorithm>
 #include <chrono>
@@ -8,20 +13,329 @@
 
 namespace signals {
 
-SignalService::SignalService(alphavantage::Client& client) : client_(client) {}
+namespace {
+    using SignalKernel = quant::fused::Kernel<quant::fused::Change<29, true>, quant::fused::Vol<0>,
+                                              quant::fused::Sma<5>, quant::fused::Sma<20, true>>;
 
-std::vector<Signal> SignalService::compute_signals(const std::vector<std::string>& symbols) {
-    std::vector<Signal> results;
-    results.reserve(symbols.size());
+    metrics::Histogram& indicator_time(const char* indicator) {
+        return metrics::registry().timer("indicator_duration_seconds",
+            "Per-symbol indicator compute time in the signal service (per-symbol kernels sampled)",
+            {{"indicator", indicator}});
+    }
+
+    // The per-symbol kernels take about as long as reading the clock twice,
+    // so only one call in kTimerSampleEvery per thread is timed
+    constexpr uint32_t kTimerSampleEvery = 16;
+    thread_local uint32_t kernel_calls = 0;
+    thread_local uint32_t features_calls = 0;
+
+    // Prices and ratios are reported to the cent
+    double round2(double x) {
+        return std::round(x * 100) / 100.0;
+    }
+
+    // Rows in the top and bottom return deciles, best and worst first
+    void decile_members(const CrossSection& cs, std::pmr::vector<size_t>& top, std::pmr::vector<size_t>& bottom) {
+        for (size_t i = 0; i < cs.return_decile.size(); ++i) {
+            if (cs.return_decile[i] == 10) top.push_back(i);
+            if (cs.return_decile[i] == 1) bottom.push_back(i);
+        }
+        // Ties break on row so both serializers agree on the order
+        auto higher = [&cs](size_t a, size_t b) {
+            double pa = cs.return_percentile[a], pb = cs.return_percentile[b];
+            return pa != pb ? pa > pb : a < b;
+        };
+        std::sort(top.begin(), top.end(), higher);
+        std::sort(bottom.rbegin(), bottom.rend(), higher);
+    }
 
-    for (const auto& symbol : symbols) {
-        results.push_back(compute_signal(symbol));
+    // Writes one signal with the keys in nlohmann's sorted order; `cs` adds
+    // its cross-sectional ranks from row `row`. Keep in step with
+    // signal_to_json and to_json, which define the document.
+    void write_signal(http::JsonWriter& writer, const Signal& signal, const CrossSection* cs, size_t row) {
+        const bool priced = signal.current_price > 0;
+        const bool stale = !signal.stale_as_of.empty();
+        writer.begin_object();
+        if (stale) {
+            writer.key("as_of");
+            writer.string(signal.stale_as_of);
+        }
+        if (cs && cs->return_decile[row] != 0) {
+            writer.key("cross_section");
+            writer.begin_object();
+            writer.key("return_decile");
+            writer.uinteger(cs->return_decile[row]);
+            writer.key("return_percentile");
+            writer.number(round2(cs->return_percentile[row]));
+            writer.key("return_zscore");
+            writer.number(round2(cs->return_zscore[row]));
+            writer.key("volatility_percentile");
+            writer.number(round2(cs->volatility_percentile[row]));
+            writer.key("volatility_zscore");
+            writer.number(round2(cs->volatility_zscore[row]));
+            writer.end_object();
+        }
+        if (priced) {
+            writer.key("current_price");
+            writer.number(round2(signal.current_price));
+            writer.key("data_points");
+            writer.integer(signal.data_points);
+        }
+        if (!signal.error.empty()) {
+            writer.key("error");
+            writer.string(signal.error);
+        }
+        if (priced) {
+            writer.key("ma20");
+            writer.number(round2(signal.ma20));
+            writer.key("ma5");
+            writer.number(round2(signal.ma5));
+            writer.key("monthly_return");
+            writer.number(round2(signal.monthly_return));
+        }
+        writer.key("prob_up");
+        writer.number(round2(signal.prob_up));
+        if (stale) {
+            writer.key("stale");
+            writer.boolean(true);
+        }
+        writer.key("symbol");
+        writer.string(signal.symbol);
+        writer.key("trend");
+        writer.string(signal.trend);
+        if (priced) {
+            writer.key("volatility");
+            writer.number(round2(signal.volatility));
+        }
+        writer.end_object();
     }
+}
 
+void SignalColumns::resize(size_t n) {
+    monthly_return.assign(n, NAN);
+    volatility.assign(n, NAN);
+    valid.assign(n, 0);
+}
+
+void SignalColumns::set(size_t row, const Signal& signal) {
+    monthly_return[row] = signal.monthly_return;
+    volatility[row] = signal.volatility;
+    valid[row] = signal.error.empty();
+}
+
+SignalColumns SignalColumns::of(const std::vector<Signal>& signals) {
+    SignalColumns columns;
+    columns.resize(signals.size());
+    for (size_t i = 0; i < signals.size(); ++i) columns.set(i, signals[i]);
+    return columns;
+}
+
+SignalService::SignalService(alphavantage::BarCache& cache) : cache_(cache) {}
+
+std::vector<Signal> SignalService::compute_signals(const std::vector<std::string>& symbols,
+                                                   alphavantage::Priority priority) {
+    return compute_signals(symbols, nullptr, priority);
+}
+
+std::vector<Signal> SignalService::compute_signals(const std::vector<std::string>& symbols, SignalColumns* columns,
+                                                   alphavantage::Priority priority) {
+    // Scratch for this call lives in the thread's arena; only the results
+    // vector comes from the heap
+    quant::ArenaScope scope;
+    std::vector<Signal> results(symbols.size());
+    model::FeatureMatrix features(scope.resource());
+    if (model_) features.resize(symbols.size());
+    if (columns) columns->resize(symbols.size());
+
+    cache_.get_many(symbols, "compact",
+        [&](size_t index, const alphavantage::BarCache::Result& cached) {
+            results[index] = signal_from_bars(symbols[index], cached.bars->view(), cached.error,
+                                              model_ ? &features : nullptr, index);
+            if (columns) columns->set(index, results[index]);
+        }, priority);
+
+    // prob_up is not ranked, so the columns stay valid after scoring
+    if (model_) apply_model(results, features);
     return results;
 }
 
 Signal SignalService::compute_signal(const std::string& symbol) {
+    // Fetch price data (served from the cache when fresh)
+    quant::ArenaScope scope;
+    std::vector<Signal> result(1);
+    model::FeatureMatrix features(scope.resource());
+    if (model_) features.resize(1);
+    auto cached = cache_.get(symbol);
+    result[0] = signal_from_bars(symbol, cached.bars->view(), cached.error, model_ ? &features : nullptr, 0);
+    if (model_) apply_model(result, features);
+    return result[0];
+}
+
+std::vector<Signal> SignalService::compute_signals(const std::vector<std::string>& symbols, int32_t as_of,
+                                                   SignalColumns* columns) {
+    quant::ArenaScope scope;
+    std::vector<Signal> results(symbols.size());
+    model::FeatureMatrix features(scope.resource());
+    if (model_) features.resize(symbols.size());
+    if (columns) columns->resize(symbols.size());
+    // History of each newly computed signal, memoized once it is scored
+    std::pmr::vector<alphavantage::BarCache::Bars> to_memo(symbols.size(), scope.resource());
+
+    cache_.get_local(symbols, "full",
+        [&](size_t index, const alphavantage::BarCache::Result& cached) {
+            if (!as_of_signal(symbols[index], as_of, cached, model_ ? &features : nullptr, index, results[index]) &&
+                cached.error.empty()) {
+                to_memo[index] = cached.bars;
+            }
+            if (columns) columns->set(index, results[index]);
+        });
+
+    // Memoized rows keep NaN features, so the batch leaves their scores alone
+    if (model_) apply_model(results, features);
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        if (to_memo[i]) memo_store(memo_key(symbols[i], as_of), to_memo[i], results[i]);
+    }
+    return results;
+}
+
+void SignalService::stream_signals(const std::vector<std::string>& symbols, const SignalFn& on_signal,
+                                   size_t max_fetches) {
+    quant::ArenaScope scope;
+    // Cached symbols plus the first max_fetches cold ones, by request index
+    std::pmr::vector<size_t> resolved(scope.resource());
+    std::vector<std::string> to_resolve;
+    resolved.reserve(symbols.size());
+    size_t fetches = 0;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        if (!cache_.fresh(symbols[i], "compact") && fetches++ >= max_fetches) continue;
+        resolved.push_back(i);
+    }
+    if (resolved.size() < symbols.size()) {
+        std::string error = std::string(kNotFetched) + ": at most " + std::to_string(max_fetches) +
+                            " uncached symbols per request";
+        for (size_t i = 0, r = 0; i < symbols.size(); ++i) {
+            if (r < resolved.size() && resolved[r] == i) { ++r; continue; }
+            on_signal(i, signal_from_bars(symbols[i], quant::BarView{}, error));
+        }
+        to_resolve.reserve(resolved.size());
+        for (size_t i : resolved) to_resolve.push_back(symbols[i]);
+    }
+    const auto& batch = resolved.size() < symbols.size() ? to_resolve : symbols;
+
+    model::FeatureMatrix features(scope.resource());
+    if (model_) features.resize(batch.size());
+
+    cache_.get_many(batch, "compact",
+        [&](size_t index, const alphavantage::BarCache::Result& cached) {
+            Signal signal = signal_from_bars(batch[index], cached.bars->view(), cached.error,
+                                             model_ ? &features : nullptr, index);
+            if (model_) apply_model(signal, features, index);
+            on_signal(resolved[index], signal);
+        }, alphavantage::Priority::Interactive);
+}
+
+void SignalService::stream_signals(const std::vector<std::string>& symbols, int32_t as_of, const SignalFn& on_signal) {
+    quant::ArenaScope scope;
+    model::FeatureMatrix features(scope.resource());
+    if (model_) features.resize(symbols.size());
+
+    cache_.get_local(symbols, "full",
+        [&](size_t index, const alphavantage::BarCache::Result& cached) {
+            Signal signal;
+            if (!as_of_signal(symbols[index], as_of, cached, model_ ? &features : nullptr, index, signal)) {
+                if (model_) apply_model(signal, features, index);
+                if (cached.error.empty()) memo_store(memo_key(symbols[index], as_of), cached.bars, signal);
+            }
+            on_signal(index, signal);
+        });
+}
+
+bool SignalService::as_of_signal(const std::string& symbol, int32_t as_of, const alphavantage::BarCache::Result& cached,
+                                 model::FeatureMatrix* features, size_t row, Signal& out) {
+    if (cached.error.empty() && memo_find(memo_key(symbol, as_of), cached.bars, out)) return true;
+    // Binary search for the day, then the same trailing window as the live signal
+    auto window = cached.bars->view().as_of(as_of).last(kSignalWindow);
+    std::string error = cached.error;
+    if (error.empty() && window.empty()) error = "No bars on or before " + quant::format_date(as_of);
+    out = signal_from_bars(symbol, window, error, features, row);
+    return false;
+}
+
+Signal SignalService::compute_signal(const std::string& symbol, int32_t as_of) {
+    return compute_signals(std::vector<std::string>{symbol}, as_of)[0];
+}
+
+void SignalService::set_model(std::shared_ptr<const model::ProbModel> model) {
+    model_ = std::move(model);
+    std::lock_guard<std::mutex> lock(memo_mutex_);
+    memo_order_.clear();
+    memo_.clear();
+}
+
+std::string SignalService::memo_key(const std::string& symbol, int32_t as_of) {
+    return symbol + '\n' + std::to_string(as_of);
+}
+
+bool SignalService::memo_find(const std::string& key, const alphavantage::BarCache::Bars& source, Signal& out) {
+    std::lock_guard<std::mutex> lock(memo_mutex_);
+    auto it = memo_.find(key);
+    if (it != memo_.end() && it->second->source.lock() != source) {
+        // History was refetched since; recompute against the new one
+        memo_order_.erase(it->second);
+        memo_.erase(it);
+        it = memo_.end();
+    }
+    if (it == memo_.end()) {
+        ++memo_misses_;
+        return false;
+    }
+    ++memo_hits_;
+    memo_order_.splice(memo_order_.begin(), memo_order_, it->second);
+    out = it->second->signal;
+    return true;
+}
+
+void SignalService::memo_store(const std::string& key, const alphavantage::BarCache::Bars& source,
+                               const Signal& signal) {
+    std::lock_guard<std::mutex> lock(memo_mutex_);
+    auto it = memo_.find(key);
+    if (it != memo_.end()) {
+        memo_order_.erase(it->second);
+        memo_.erase(it);
+    }
+    memo_order_.push_front(MemoEntry{key, source, signal});
+    memo_.emplace(key, memo_order_.begin());
+    if (memo_order_.size() > kMemoCapacity) {
+        memo_.erase(memo_order_.back().key);
+        memo_order_.pop_back();
+    }
+}
+
+MemoStats SignalService::memo_stats() const {
+    std::lock_guard<std::mutex> lock(memo_mutex_);
+    return MemoStats{memo_hits_, memo_misses_, memo_.size()};
+}
+
+void SignalService::apply_model(std::vector<Signal>& signals, const model::FeatureMatrix& features) const {
+    static metrics::Histogram& scoring_time = indicator_time("prob_model");
+    metrics::ScopedTimer timer(scoring_time);
+    quant::ArenaScope scope;
+    std::pmr::vector<double> probs(features.rows, scope.resource());
+    model_->predict(features, probs.data());
+    for (size_t i = 0; i < signals.size(); ++i) {
+        if (std::isfinite(probs[i])) signals[i].prob_up = probs[i];
+    }
+}
+
+// Untimed: a single row costs less than reading the clock, and the batch
+// overload's timing already covers the model
+void SignalService::apply_model(Signal& signal, const model::FeatureMatrix& features, size_t row) const {
+    double prob = model_->predict(features, row);
+    if (std::isfinite(prob)) signal.prob_up = prob;
+}
+
+Signal SignalService::signal_from_bars(const std::string& symbol, quant::BarView bars, const std::string& error,
+                                       model::FeatureMatrix* features, size_t row) {
     Signal signal;
     signal.symbol = symbol;
     signal.trend = "unknown";
@@ -33,11 +347,8 @@ Signal SignalService::compute_signal(const std::string& symbol) {
     signal.ma20 = 0;
     signal.data_points = 0;
 
-    // Fetch price data
-    auto bars = client_.fetch_daily_adjusted(symbol);
-
     if (bars.empty()) {
-        signal.error = client_.last_error();
+        signal.error = error;
         return signal;
     }
 
@@ -49,51 +360,34 @@ Signal SignalService::compute_signal(const std::string& symbol) {
         return signal;
     }
 
-    // Extract close prices (bars are sorted oldest to newest)
-    std::vector<double> closes;
-    closes.reserve(bars.size());
-    for (const auto& bar : bars) {
-        closes.push_back(bar.close);
-    }
-
-    // Current price is the last close
-    signal.current_price = closes.back();
-
-    // Calculate monthly return (last 20-30 trading days)
-    size_t month_days = std::min(static_cast<size_t>(30), closes.size());
-    double month_ago_price = closes[closes.size() - month_days];
-    signal.monthly_return = ((signal.current_price - month_ago_price) / month_ago_price) * 100.0;
-
-    // Calculate daily returns for volatility
-    std::vector<double> returns;
-    returns.reserve(closes.size() - 1);
-    for (size_t i = 1; i < closes.size(); ++i) {
-        returns.push_back((closes[i] - closes[i-1]) / closes[i-1]);
-    }
-
-    // Calculate annualized volatility
-    double vol = quant::realized_vol(returns);
-    signal.volatility = vol * std::sqrt(252.0) * 100.0;  // Annualized as percentage
-
-    // Calculate moving averages (on most recent data)
-    // We need to reverse for SMA calculation since quant::sma uses last N values
-    std::vector<double> closes_reversed(closes.rbegin(), closes.rend());
-
-    if (closes.size() >= 5) {
-        signal.ma5 = quant::sma(closes_reversed, 5);
-    }
-
-    if (closes.size() >= 20) {
-        signal.ma20 = quant::sma(closes_reversed, 20);
-    } else {
-        signal.ma20 = quant::sma(closes_reversed, static_cast<int>(closes.size()));
+    // Read the close column in place (bars are sorted oldest to newest)
+    quant::Span<const double> closes = bars.close;
+
+    // Monthly return over the last 30 closes (fewer on short histories),
+    // annualized volatility of every daily return and the two moving
+    // averages, all in one pass over the close column
+    static metrics::Histogram& kernel_time = indicator_time("signal_kernel");
+    static metrics::Histogram& features_time = indicator_time("model_features");
+    {
+        metrics::ScopedTimer timer(kernel_time, metrics::sample(kernel_calls, kTimerSampleEvery));
+        SignalKernel kernel(closes);
+        signal.current_price = closes.back();
+        signal.monthly_return = kernel.get<quant::fused::Change<29, true>>() * 100.0;
+        signal.volatility = kernel.get<quant::fused::Vol<0>>() * std::sqrt(252.0) * 100.0;  // Annualized as percentage
+        // Averages of the newest 5 and 20 closes, matching the backtest
+        signal.ma5 = kernel.get<quant::fused::Sma<5>>();
+        signal.ma20 = kernel.get<quant::fused::Sma<20, true>>();
     }
 
     // Determine trend
     signal.trend = determine_trend(signal.current_price, signal.ma5, signal.ma20, signal.monthly_return);
 
-    // Calculate probability
+    // Calculate probability (replaced by the model's score when one is set)
     signal.prob_up = calculate_prob_up(signal.trend, signal.monthly_return);
+    if (features) {
+        metrics::ScopedTimer timer(features_time, metrics::sample(features_calls, kTimerSampleEvery));
+        model::latest_features(closes, *features, row);
+    }
 
     return signal;
 }
@@ -151,6 +445,8 @@ double SignalService::calculate_prob_up(const std::string& trend, double monthly
     return std::max(0.05, std::min(0.95, base_prob));
 }
 
+// write_signal emits the same document by hand: a key added or changed here
+// must be mirrored there (the writer-vs-dump() test catches a mismatch)
 nlohmann::json SignalService::signal_to_json(const Signal& signal) {
     nlohmann::json j;
     j["symbol"] = signal.symbol;
@@ -170,21 +466,113 @@ nlohmann::json SignalService::signal_to_json(const Signal& signal) {
         j["error"] = signal.error;
     }
 
+    if (!signal.stale_as_of.empty()) {
+        j["stale"] = true;
+        j["as_of"] = signal.stale_as_of;
+    }
+
     return j;
 }
 
 nlohmann::json SignalService::to_json(const std::vector<Signal>& signals, const std::string& as_of) {
+    return to_json(signals, SignalColumns::of(signals), as_of);
+}
+
+nlohmann::json SignalService::to_json(const std::vector<Signal>& signals, const SignalColumns& columns,
+                                      const std::string& as_of) {
     nlohmann::json result;
     result["as_of"] = as_of;
     result["horizon"] = "30d";
 
+    // Ranks are relative to the signals in this response
+    quant::ArenaScope scope;
+    auto cs = cross_section(columns, scope.resource());
+
     nlohmann::json signal_array = nlohmann::json::array();
-    for (const auto& signal : signals) {
-        signal_array.push_back(signal_to_json(signal));
+    for (size_t i = 0; i < signals.size(); ++i) {
+        nlohmann::json j = signal_to_json(signals[i]);
+        if (cs.return_decile[i] != 0) {
+            nlohmann::json ranks;
+            ranks["return_percentile"] = round2(cs.return_percentile[i]);
+            ranks["return_zscore"] = round2(cs.return_zscore[i]);
+            ranks["volatility_percentile"] = round2(cs.volatility_percentile[i]);
+            ranks["volatility_zscore"] = round2(cs.volatility_zscore[i]);
+            ranks["return_decile"] = cs.return_decile[i];
+            j["cross_section"] = ranks;
+        }
+        signal_array.push_back(std::move(j));
     }
     result["signals"] = signal_array;
 
+    std::pmr::vector<size_t> top(scope.resource()), bottom(scope.resource());
+    decile_members(cs, top, bottom);
+    nlohmann::json summary;
+    summary["scored"] = cs.scored;
+    summary["return_mean"] = round2(cs.return_mean);
+    summary["return_std"] = round2(cs.return_std);
+    summary["volatility_mean"] = round2(cs.volatility_mean);
+    summary["volatility_std"] = round2(cs.volatility_std);
+    summary["top_decile"] = nlohmann::json::array();
+    summary["bottom_decile"] = nlohmann::json::array();
+    for (size_t i : top) summary["top_decile"].push_back(signals[i].symbol);
+    for (size_t i : bottom) summary["bottom_decile"].push_back(signals[i].symbol);
+    result["cross_section"] = summary;
+
     return result;
 }
 
+void SignalService::write_signal_json(std::string& out, const Signal& signal) {
+    http::JsonWriter writer(out);
+    write_signal(writer, signal, nullptr, 0);
+}
+
+void SignalService::write_json(std::string& out, const std::vector<Signal>& signals, const std::string& as_of) {
+    write_json(out, signals, SignalColumns::of(signals), as_of);
+}
+
+void SignalService::write_json(std::string& out, const std::vector<Signal>& signals, const SignalColumns& columns,
+                               const std::string& as_of) {
+    quant::ArenaScope scope;
+    auto cs = cross_section(columns, scope.resource());
+    std::pmr::vector<size_t> top(scope.resource()), bottom(scope.resource());
+    decile_members(cs, top, bottom);
+
+    // Keys in sorted order, as nlohmann's object map emits them
+    http::JsonWriter writer(out);
+    writer.begin_object();
+    writer.key("as_of");
+    writer.string(as_of);
+
+    writer.key("cross_section");
+    writer.begin_object();
+    writer.key("bottom_decile");
+    writer.begin_array();
+    for (size_t i : bottom) writer.string(signals[i].symbol);
+    writer.end_array();
+    writer.key("return_mean");
+    writer.number(round2(cs.return_mean));
+    writer.key("return_std");
+    writer.number(round2(cs.return_std));
+    writer.key("scored");
+    writer.uinteger(cs.scored);
+    writer.key("top_decile");
+    writer.begin_array();
+    for (size_t i : top) writer.string(signals[i].symbol);
+    writer.end_array();
+    writer.key("volatility_mean");
+    writer.number(round2(cs.volatility_mean));
+    writer.key("volatility_std");
+    writer.number(round2(cs.volatility_std));
+    writer.end_object();
+
+    writer.key("horizon");
+    writer.string("30d");
+
+    writer.key("signals");
+    writer.begin_array();
+    for (size_t i = 0; i < signals.size(); ++i) write_signal(writer, signals[i], &cs, i);
+    writer.end_array();
+    writer.end_object();
+}
+
 } // namespace signals
@@ -0,0 +1,123 @@
+#include "../include/simd.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define QUANT_HAVE_AVX2_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+namespace quant {
+namespace simd {
+
+namespace {
+
+// Four independent accumulators break the add dependency chain
+double sum_scalar(const double* data, size_t n) {
+    double a0 = 0.0, a1 = 0.0, a2 = 0.0, a3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a0 += data[i];
+        a1 += data[i + 1];
+        a2 += data[i + 2];
+        a3 += data[i + 3];
+    }
+    for (; i < n; ++i) a0 += data[i];
+    return (a0 + a1) + (a2 + a3);
+}
+
+double sum_sq_dev_scalar(const double* data, size_t n, double mean) {
+    double a0 = 0.0, a1 = 0.0, a2 = 0.0, a3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        double d0 = data[i] - mean, d1 = data[i + 1] - mean;
+        double d2 = data[i + 2] - mean, d3 = data[i + 3] - mean;
+        a0 += d0 * d0;
+        a1 += d1 * d1;
+        a2 += d2 * d2;
+        a3 += d3 * d3;
+    }
+    for (; i < n; ++i) {
+        double d = data[i] - mean;
+        a0 += d * d;
+    }
+    return (a0 + a1) + (a2 + a3);
+}
+
+#ifdef QUANT_HAVE_AVX2_DISPATCH
+
+__attribute__((target("avx2,fma")))
+double horizontal_sum(__m256d v) {
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    __m128d high64 = _mm_unpackhi_pd(lo, lo);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, high64));
+}
+
+__attribute__((target("avx2,fma")))
+double sum_avx2(const double* data, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(data + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(data + i + 4));
+    }
+    double total = horizontal_sum(_mm256_add_pd(acc0, acc1));
+    for (; i < n; ++i) total += data[i];
+    return total;
+}
+
+__attribute__((target("avx2,fma")))
+double sum_sq_dev_avx2(const double* data, size_t n, double mean) {
+    const __m256d m = _mm256_set1_pd(mean);
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(data + i), m);
+        __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(data + i + 4), m);
+        acc0 = _mm256_fmadd_pd(d0, d0, acc0);
+        acc1 = _mm256_fmadd_pd(d1, d1, acc1);
+    }
+    double total = horizontal_sum(_mm256_add_pd(acc0, acc1));
+    for (; i < n; ++i) {
+        double d = data[i] - mean;
+        total += d * d;
+    }
+    return total;
+}
+
+bool detect_avx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+#endif
+
+} // namespace
+
+bool avx2_enabled() {
+#ifdef QUANT_HAVE_AVX2_DISPATCH
+    static const bool enabled = detect_avx2();
+    return enabled;
+#else
+    return false;
+#endif
+}
+
+double sum(const double* data, size_t n) {
+#ifdef QUANT_HAVE_AVX2_DISPATCH
+    if (avx2_enabled()) return sum_avx2(data, n);
+#endif
+    return sum_scalar(data, n);
+}
+
+double sum_sq_dev(const double* data, size_t n, double mean) {
+#ifdef QUANT_HAVE_AVX2_DISPATCH
+    if (avx2_enabled()) return sum_sq_dev_avx2(data, n, mean);
+#endif
+    return sum_sq_dev_scalar(data, n, mean);
+}
+
+} // namespace simd
+} // namespace quant
@@ -0,0 +1,176 @@
+#include "price_store.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include "dates.h"
+
+namespace store {
+
+namespace {
+    // Rows per multi-row INSERT; 8 parameters each stays under SQLite's
+    // historical 999-variable limit
+    constexpr size_t kRowsPerStatement = 100;
+
+    const char* kSchema =
+        "CREATE TABLE IF NOT EXISTS prices ("
+        "  symbol TEXT NOT NULL,"
+        "  date TEXT NOT NULL,"
+        "  open REAL, high REAL, low REAL, close REAL, adj_close REAL,"
+        "  volume INTEGER,"
+        "  PRIMARY KEY (symbol, date)"
+        ") WITHOUT ROWID;";
+
+    std::string upsert_sql(size_t rows) {
+        std::string sql = "INSERT INTO prices (symbol, date, open, high, low, close, adj_close, volume) VALUES ";
+        for (size_t i = 0; i < rows; ++i) {
+            sql += i ? ",(?,?,?,?,?,?,?,?)" : "(?,?,?,?,?,?,?,?)";
+        }
+        sql += " ON CONFLICT (symbol, date) DO UPDATE SET open = excluded.open, high = excluded.high,"
+               " low = excluded.low, close = excluded.close, adj_close = excluded.adj_close,"
+               " volume = excluded.volume";
+        return sql;
+    }
+
+    class Statement {
+    public:
+        Statement(sqlite3* db, const std::string& sql) {
+            sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt_, nullptr);
+        }
+        ~Statement() { sqlite3_finalize(stmt_); }
+        Statement(const Statement&) = delete;
+        Statement& operator=(const Statement&) = delete;
+
+        sqlite3_stmt* get() const { return stmt_; }
+        explicit operator bool() const { return stmt_ != nullptr; }
+
+    private:
+        sqlite3_stmt* stmt_ = nullptr;
+    };
+
+    class SqlitePriceStore : public PriceStore {
+    public:
+        explicit SqlitePriceStore(sqlite3* db) : db_(db) {}
+        ~SqlitePriceStore() override { sqlite3_close(db_); }
+
+        bool init(std::string& error) {
+            if (!exec("PRAGMA journal_mode = WAL; PRAGMA synchronous = NORMAL;", error) ||
+                !exec(kSchema, error)) {
+                return false;
+            }
+            Statement stmt(db_, "SELECT symbol, max(date) FROM prices GROUP BY symbol");
+            if (!stmt) return fail(error);
+            while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+                note_last_date(text(stmt.get(), 0), quant::parse_date(text(stmt.get(), 1)));
+            }
+            return true;
+        }
+
+        bool upsert(const std::string& symbol, const quant::BarSeries& bars, std::string& error) override {
+            if (bars.empty()) return true;
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!exec("BEGIN", error)) return false;
+
+            Statement full(db_, upsert_sql(std::min(kRowsPerStatement, bars.size())));
+            if (!full) return rollback(error);
+            for (size_t start = 0; start < bars.size(); start += kRowsPerStatement) {
+                size_t rows = std::min(kRowsPerStatement, bars.size() - start);
+                std::unique_ptr<Statement> tail;
+                sqlite3_stmt* stmt = full.get();
+                if (rows != std::min(kRowsPerStatement, bars.size())) {
+                    tail = std::make_unique<Statement>(db_, upsert_sql(rows));
+                    if (!*tail) return rollback(error);
+                    stmt = tail->get();
+                }
+
+                int param = 1;
+                for (size_t i = start; i < start + rows; ++i) {
+                    std::string date = quant::format_date(bars.date[i]);
+                    sqlite3_bind_text(stmt, param++, symbol.c_str(), static_cast<int>(symbol.size()), SQLITE_TRANSIENT);
+                    sqlite3_bind_text(stmt, param++, date.c_str(), static_cast<int>(date.size()), SQLITE_TRANSIENT);
+                    sqlite3_bind_double(stmt, param++, bars.open[i]);
+                    sqlite3_bind_double(stmt, param++, bars.high[i]);
+                    sqlite3_bind_double(stmt, param++, bars.low[i]);
+                    sqlite3_bind_double(stmt, param++, bars.close[i]);
+                    sqlite3_bind_double(stmt, param++, bars.adj_close[i]);
+                    sqlite3_bind_int64(stmt, param++, bars.volume[i]);
+                }
+                if (sqlite3_step(stmt) != SQLITE_DONE) return rollback(error);
+                sqlite3_reset(stmt);
+                sqlite3_clear_bindings(stmt);
+            }
+
+            if (!exec("COMMIT", error)) return rollback(error);
+            note_stored(symbol, bars);
+            return true;
+        }
+
+        bool load(const std::string& symbol, size_t limit, quant::BarSeries& out, std::string& error) override {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Statement stmt(db_,
+                "SELECT date, open, high, low, close, adj_close, volume FROM ("
+                "  SELECT * FROM prices WHERE symbol = ? ORDER BY date DESC LIMIT ?"
+                ") ORDER BY date");
+            if (!stmt) return fail(error);
+            sqlite3_bind_text(stmt.get(), 1, symbol.c_str(), static_cast<int>(symbol.size()), SQLITE_TRANSIENT);
+            sqlite3_bind_int64(stmt.get(), 2, limit ? static_cast<sqlite3_int64>(limit) : -1);
+
+            out = quant::BarSeries();
+            if (limit) out.reserve(limit);
+            int rc;
+            while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+                out.push_back(quant::parse_date(text(stmt.get(), 0)),
+                              sqlite3_column_double(stmt.get(), 1),
+                              sqlite3_column_double(stmt.get(), 2),
+                              sqlite3_column_double(stmt.get(), 3),
+                              sqlite3_column_double(stmt.get(), 4),
+                              sqlite3_column_double(stmt.get(), 5),
+                              sqlite3_column_int64(stmt.get(), 6));
+            }
+            return rc == SQLITE_DONE || fail(error);
+        }
+
+        const char* backend() const override { return "sqlite"; }
+
+    private:
+        sqlite3* db_;
+        std::mutex mutex_;
+
+        static std::string text(sqlite3_stmt* stmt, int column) {
+            const unsigned char* value = sqlite3_column_text(stmt, column);
+            return value ? reinterpret_cast<const char*>(value) : "";
+        }
+
+        bool fail(std::string& error) {
+            error = std::string("SQLite: ") + sqlite3_errmsg(db_);
+            return false;
+        }
+
+        bool rollback(std::string& error) {
+            fail(error);
+            sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            return false;
+        }
+
+        bool exec(const char* sql, std::string& error) {
+            char* message = nullptr;
+            if (sqlite3_exec(db_, sql, nullptr, nullptr, &message) == SQLITE_OK) return true;
+            error = std::string("SQLite: ") + (message ? message : "unknown error");
+            sqlite3_free(message);
+            return false;
+        }
+    };
+}
+
+std::unique_ptr<PriceStore> open_sqlite_store(const std::string& path, std::string& error) {
+    sqlite3* db = nullptr;
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX;
+    if (sqlite3_open_v2(path.c_str(), &db, flags, nullptr) != SQLITE_OK) {
+        error = "SQLite: cannot open " + path + ": " + (db ? sqlite3_errmsg(db) : "out of memory");
+        sqlite3_close(db);
+        return nullptr;
+    }
+    auto store = std::make_unique<SqlitePriceStore>(db);
+    if (!store->init(error)) return nullptr;
+    return store;
+}
+
+} // namespace store
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/bar_store.h"
+#include "../include/csv_ingest.h"
+#include "../include/dates.h"
+#include "../include/prob_model.h"
+
+int main(int argc, char** argv) {
+    const char* usage =
+        "Usage: train_model [--threads N] [--horizon BARS] [--l2 X] [--holdout FRACTION] [--version NAME]\n"
+        "                   <prices.csv|prices.qbars> <model.json>\n";
+    model::TrainOptions options;
+    int horizon = 20;
+    double holdout = 0.2;
+    std::string version;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            if (arg == "--threads" && i + 1 < argc) {
+                options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else if (arg == "--horizon" && i + 1 < argc) {
+                horizon = std::stoi(argv[++i]);
+            } else if (arg == "--l2" && i + 1 < argc) {
+                options.l2 = std::stod(argv[++i]);
+            } else if (arg == "--holdout" && i + 1 < argc) {
+                holdout = std::stod(argv[++i]);
+            } else if (arg == "--version" && i + 1 < argc) {
+                version = argv[++i];
+            } else {
+                paths.push_back(arg);
+            }
+        } catch (...) {
+            std::cerr << usage;
+            return 1;
+        }
+    }
+    if (paths.size() != 2 || holdout < 0 || holdout >= 1) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    quant::BarStore store;
+    quant::PriceTable table;
+    std::vector<quant::BarView> universe;
+    if (quant::BarStore::is_bar_store(paths[0])) {
+        std::string error;
+        if (!store.open(paths[0], error)) { std::cerr << error << "\n"; return 2; }
+        for (size_t i = 0; i < store.size(); ++i) universe.push_back(store.at(i));
+    } else {
+        table = quant::load_price_csv(paths[0], options.threads);
+        if (!table.ok()) { std::cerr << table.error << "\n"; return 2; }
+        for (const auto& [symbol, series] : table.symbols) universe.push_back(series.view(symbol));
+    }
+
+    auto data = model::build_training_set(universe, horizon, options.threads);
+    if (data.y.empty()) { std::cerr << "No training rows (need " << model::kMinHistory + horizon << "+ bars per symbol)\n"; return 2; }
+    int32_t last_date = *std::max_element(data.date.begin(), data.date.end());
+
+    // Walk-forward check: fit on the earlier dates, score the most recent ones
+    if (holdout > 0) {
+        std::vector<int32_t> dates = data.date;
+        auto cut = dates.begin() + static_cast<std::ptrdiff_t>(dates.size() * (1.0 - holdout));
+        std::nth_element(dates.begin(), cut, dates.end());
+        auto [fit, test] = data.split(*cut);
+        if (!fit.y.empty() && !test.y.empty()) {
+            auto fitted = model::train(std::move(fit.x), fit.y, options);
+            if (!fitted.ok()) { std::cerr << fitted.error << "\n"; return 2; }
+            std::vector<double> probs;
+            fitted.model.predict(test.x, probs);
+            std::printf("holdout from %s: rows=%zu auc=%.4f log_loss=%.5f\n", quant::format_date(*cut).c_str(),
+                        test.y.size(), model::auc(probs, test.y), model::log_loss(probs, test.y));
+        }
+    }
+
+    auto result = model::train(std::move(data.x), data.y, options);
+    if (!result.ok()) { std::cerr << result.error << "\n"; return 2; }
+    result.model.version = version.empty() ? "logit-" + quant::format_date(last_date) : version;
+    result.model.horizon = horizon;
+
+    std::string error;
+    if (!result.model.save(paths[1], error)) { std::cerr << error << "\n"; return 2; }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::printf("model %s: rows=%zu iterations=%d%s log_loss=%.5f (%.2fs)\n", result.model.version.c_str(),
+                result.model.trained_rows, result.iterations, result.converged ? "" : " (not converged)",
+                result.log_loss, elapsed);
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "universe.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unordered_set>
+
+namespace signals {
+
+namespace {
+    std::string upper(std::string_view text) {
+        std::string out(text);
+        for (char& c : out) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        return out;
+    }
+
+    bool is_separator(char c) {
+        return c == ',' || std::isspace(static_cast<unsigned char>(c));
+    }
+}
+
+std::vector<std::string> parse_universe(std::string_view text) {
+    std::vector<std::string> symbols;
+    std::unordered_set<std::string> seen;
+    size_t i = 0;
+    while (i < text.size()) {
+        if (text[i] == '#') {
+            while (i < text.size() && text[i] != '\n') ++i;
+        } else if (is_separator(text[i])) {
+            ++i;
+        } else {
+            size_t start = i;
+            while (i < text.size() && !is_separator(text[i]) && text[i] != '#') ++i;
+            std::string symbol = upper(text.substr(start, i - start));
+            if (seen.insert(symbol).second) symbols.push_back(std::move(symbol));
+        }
+    }
+    return symbols;
+}
+
+bool normalize_symbols(const std::vector<std::string>& raw, std::vector<std::string>& out, std::string& error) {
+    std::unordered_set<std::string> seen;
+    for (const auto& entry : raw) {
+        size_t begin = 0, end = entry.size();
+        while (begin < end && std::isspace(static_cast<unsigned char>(entry[begin]))) ++begin;
+        while (end > begin && std::isspace(static_cast<unsigned char>(entry[end - 1]))) --end;
+        if (begin == end) continue;
+
+        std::string symbol = upper(std::string_view(entry).substr(begin, end - begin));
+        bool valid = symbol.size() <= kMaxSymbolLength &&
+            std::all_of(symbol.begin(), symbol.end(), [](char c) {
+                return std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '-' || c == '^' || c == '=';
+            });
+        if (!valid) {
+            error = "Invalid symbol '" + entry + "'";
+            return false;
+        }
+        if (seen.insert(symbol).second) out.push_back(std::move(symbol));
+    }
+    return true;
+}
+
+bool load_universes(const std::string& dir, std::vector<Universe>& out, std::string& error) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    if (!fs::exists(dir, ec)) return true;
+
+    std::vector<fs::path> files;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() == ".txt" && it->is_regular_file(ec)) files.push_back(it->path());
+    }
+    if (ec) {
+        error = "Cannot list universe directory " + dir + ": " + ec.message();
+        return false;
+    }
+    std::sort(files.begin(), files.end());
+
+    // Built aside and appended only once every file has loaded
+    std::vector<Universe> loaded;
+    for (const auto& path : files) {
+        std::ifstream file(path);
+        if (!file) {
+            error = "Cannot read universe file " + path.string();
+            return false;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+        Universe universe{upper(path.stem().string()), parse_universe(text.str())};
+        if (universe.symbols.empty()) continue;
+        if (find_universe(out, universe.name) || find_universe(loaded, universe.name)) {
+            error = "Universe " + universe.name + " is defined twice";
+            return false;
+        }
+        loaded.push_back(std::move(universe));
+    }
+    out.insert(out.end(), std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.end()));
+    return true;
+}
+
+const Universe* find_universe(const std::vector<Universe>& universes, std::string_view name) {
+    std::string wanted = upper(name);
+    for (const auto& universe : universes) {
+        if (universe.name == wanted) return &universe;
+    }
+    return nullptr;
+}
+
+} // namespace signals
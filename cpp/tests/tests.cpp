@@ -3,21 +3,90 @@
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include "../include/arena.h"
 #include "../include/indicators.h"
+#include "../include/metrics.h"
+#include "../include/rolling.h"
+#include "../include/simd.h"
+#include "../include/universe.h"
+#include "../include/cross_section.h"
+#include "../include/csv_ingest.h"
+#include "../include/bar_store.h"
+#include "../include/dates.h"
+#include "../include/fused.h"
+#include "../include/parallel.h"
+#include "../include/bar_cache.h"
+#include "../include/signal_refresher.h"
+#include "../include/signal_stream.h"
+#include "../include/http_cache.h"
+#include "../include/json_writer.h"
+#include "../include/price_sync.h"
+#include "../include/backtest.h"
+#include "../include/prob_model.h"
+#include "../include/ranking.h"
+#include <zlib.h>
+
+// Heap allocations made by the current thread, to check that steady-state
+// requests stay off the allocator
+thread_local uint64_t heap_allocations = 0;
+
+// Out of line, or GCC pairs the inlined malloc/free against new/delete
+// and warns about a mismatch
+__attribute__((noinline)) void* operator new(size_t size) {
+    ++heap_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { std::free(p); }
 
 void assert_close(double a, double b, double tol=1e-6) {
     if (std::isnan(a) && std::isnan(b)) return;
-    if (std::abs(a-b) > tol) {
+    if (std::isnan(a) || std::isnan(b) || std::abs(a-b) > tol) {
         std::cerr << "Assertion failed: " << a << " vs " << b << "\n";
         std::exit(2);
     }
 }
 
+// One bar on 2024-01-02, as a canned upstream response
+alphavantage::FetchResult one_bar() {
+    alphavantage::FetchResult result;
+    result.bars.push_back(quant::parse_date("2024-01-02"), 1, 2, 0.5, 1.5, 1.5, 100);
+    return result;
+}
+
 int main() {
     // sma test
     std::vector<double> xs = {1,2,3,4,5,6,7,8,9,10};
     double s = quant::sma(xs, 5);
     assert_close(s, 8.0);
+    // sma sums with SIMD lanes, so only the last ulps may differ from a plain
+    // left-to-right loop, across periods that exercise every tail length
+    std::vector<double> wide;
+    for (int i = 0; i < 300; ++i) wide.push_back((i % 7 == 0 ? 1e6 : 1.0) * (1.0 + std::sin(i * 0.37)));
+    for (int period = 1; period <= 257; period += (period < 20 ? 1 : 17)) {
+        double naive = 0.0;
+        for (size_t i = wide.size() - period; i < wide.size(); ++i) naive += wide[i];
+        naive /= period;
+        double fast = quant::sma(wide, period);
+        if (std::abs(fast - naive) > 1e-12 * std::abs(naive)) {
+            std::cerr << "sma(" << period << ") drifted from the scalar loop: " << fast << " vs " << naive << "\n";
+            return 2;
+        }
+    }
 
     // ema basic run
     double e = quant::ema(xs, 5);
@@ -27,12 +96,1147 @@ int main() {
     std::vector<double> up = {1,2,3,4,5,6,7,8,9,10};
     double r = quant::rsi(up, 5);
     if (r < 99.9) { std::cerr << "RSI expected ~100, got "<<r<<"\n"; return 2; }
+    // rsi reads only the first 'period' changes; rsi_wilder smooths the rest
+    std::vector<double> up_then_down = up;
+    up_then_down.push_back(5);
+    if (quant::rsi(up_then_down, 5) != r || !(quant::rsi_wilder(up_then_down, 5) < r) ||
+        quant::rsi_wilder(std::vector<double>(up.begin(), up.begin() + 6), 5) != quant::rsi(up, 5)) {
+        std::cerr << "rsi / rsi_wilder disagree on their windows\n"; return 2;
+    }
 
     // max drawdown
     std::vector<double> p = {100, 120, 80, 90, 70};
     double dd = quant::max_drawdown(p);
     assert_close(dd, (120.0-70.0)/120.0);
 
+    // rolling indicators agree with the batch functions at every step
+    std::vector<double> closes, highs, lows, rets;
+    double px = 100.0;
+    for (int i = 0; i < 300; ++i) {
+        px *= 1.0 + 0.02 * std::sin(i * 0.7) + 0.005 * std::cos(i * 1.3);
+        closes.push_back(px);
+        highs.push_back(px * 1.01);
+        lows.push_back(px * 0.985);
+    }
+    quant::RollingSMA rsma(20);
+    quant::RollingEMA rema(20);
+    quant::RollingRSI rrsi(14);
+    quant::RollingATR ratr(14);
+    quant::RollingVariance rvar, rvar20(20);
+    quant::RollingMaxDrawdown rdd;
+    for (size_t i = 0; i < closes.size(); ++i) {
+        std::vector<double> head(closes.begin(), closes.begin() + i + 1);
+        std::vector<double> hh(highs.begin(), highs.begin() + i + 1), ll(lows.begin(), lows.begin() + i + 1);
+        rsma.push(closes[i]); rema.push(closes[i]); rrsi.push(closes[i]); rdd.push(closes[i]);
+        ratr.push(highs[i], lows[i], closes[i]);
+        if (i > 0) {
+            rets.push_back(closes[i] / closes[i-1] - 1.0);
+            rvar.push(rets.back());
+            rvar20.push(rets.back());
+        }
+        assert_close(rsma.value(), quant::sma(head, 20), 1e-9);
+        assert_close(rema.value(), quant::ema(head, 20), 1e-9);
+        assert_close(rrsi.value(), quant::rsi_wilder(head, 14), 1e-9);
+        assert_close(ratr.value(), quant::atr(hh, ll, head, 14), 1e-9);
+        assert_close(rdd.value(), quant::max_drawdown(head), 1e-12);
+        if (!rets.empty()) {
+            assert_close(rvar.stddev(), quant::realized_vol(rets), 1e-12);
+            std::vector<double> last20(rets.end() - std::min<size_t>(20, rets.size()), rets.end());
+            assert_close(rvar20.stddev(), quant::realized_vol(last20), 1e-12);
+        }
+    }
+
+    // series variants match the scalar indicator at every bar
+    auto sma_s = quant::sma_series(closes, 20);
+    auto ema_s = quant::ema_series(closes, 20);
+    auto rsi_s = quant::rsi_series(closes, 14);
+    auto atr_s = quant::atr_series(highs, lows, closes, 14);
+    for (size_t i = 0; i < closes.size(); ++i) {
+        std::vector<double> head(closes.begin(), closes.begin() + i + 1);
+        std::vector<double> hh(highs.begin(), highs.begin() + i + 1), ll(lows.begin(), lows.begin() + i + 1);
+        assert_close(sma_s[i], quant::sma(head, 20), 1e-9);
+        assert_close(ema_s[i], quant::ema(head, 20), 1e-9);
+        assert_close(rsi_s[i], quant::rsi_wilder(head, 14), 1e-9);
+        assert_close(atr_s[i], quant::atr(hh, ll, head, 14), 1e-9);
+    }
+
+    // fused kernel matches the scalar indicators on every prefix, short ones included
+    for (size_t n = 1; n <= closes.size(); ++n) {
+        using namespace quant::fused;
+        quant::Span<const double> head = quant::Span<const double>(closes).first(n);
+        Kernel<Sma<20>, Sma<20, true>, Ema<20>, Vol<0>, Vol<20>, Slope<20>, Change<29>, Change<29, true>> k(head);
+        std::vector<double> head_rets;
+        for (size_t i = 1; i < n; ++i) head_rets.push_back((closes[i] - closes[i-1]) / closes[i-1]);
+        std::vector<double> last20_rets(head_rets.end() - std::min<size_t>(20, head_rets.size()), head_rets.end());
+        double base = closes[n - std::min<size_t>(30, n)];
+        assert_close(k.get<Sma<20>>(), quant::sma(head, 20), 1e-9);
+        assert_close(k.get<Sma<20, true>>(), quant::sma(head, static_cast<int>(std::min<size_t>(20, n))), 1e-9);
+        assert_close(k.get<Ema<20>>(), quant::ema(head, 20), 1e-12);
+        assert_close(k.get<Vol<0>>(), n > 1 ? quant::realized_vol(head_rets) : NAN, 1e-12);
+        assert_close(k.get<Vol<20>>(), n > 1 ? quant::realized_vol(last20_rets) : NAN, 1e-12);
+        assert_close(k.get<Slope<20>>(), quant::slope_logprice(head.last(std::min<size_t>(20, n))).value_or(NAN), 1e-12);
+        assert_close(k.get<Change<29>>(), n >= 30 ? (closes[n-1] - base) / base : NAN, 1e-15);
+        assert_close(k.get<Change<29, true>>(), (closes[n-1] - base) / base, 1e-15);
+        static_assert(Kernel<Sma<50>, Slope<20>>::kLookback == 50 && Kernel<Sma<5>, Ema<3>>::kLookback == 0 &&
+                      Kernel<Slope<20>>::kUsesLog && !Kernel<Sma<5>>::kUsesLog, "fused kernel configuration");
+    }
+
+    // SIMD reductions agree with a naive loop, including the scalar tail
+    for (size_t n : {0, 1, 7, 8, 13, 300}) {
+        double naive = 0.0, naive_sq = 0.0;
+        for (size_t i = 0; i < n; ++i) naive += closes[i];
+        double mean = n ? naive / n : 0.0;
+        for (size_t i = 0; i < n; ++i) naive_sq += (closes[i] - mean) * (closes[i] - mean);
+        assert_close(quant::simd::sum(closes.data(), n), naive, 1e-9);
+        assert_close(quant::simd::sum_sq_dev(closes.data(), n, mean), naive_sq, 1e-9);
+    }
+
+    // snapshot/restore resumes exactly where the original left off
+    auto sma_state = rsma.snapshot();
+    auto rsi_state = rrsi.snapshot();
+    auto var_state = rvar20.snapshot();
+    quant::RollingSMA sma_copy(1);
+    quant::RollingRSI rsi_copy(1);
+    quant::RollingVariance var_copy;
+    sma_copy.restore(sma_state);
+    rsi_copy.restore(rsi_state);
+    var_copy.restore(var_state);
+    for (double x : {101.0, 99.5, 102.25}) {
+        rsma.push(x); sma_copy.push(x);
+        rrsi.push(x); rsi_copy.push(x);
+        rvar20.push(x / 100.0 - 1.0); var_copy.push(x / 100.0 - 1.0);
+    }
+    assert_close(sma_copy.value(), rsma.value(), 1e-12);
+    assert_close(rsi_copy.value(), rrsi.value(), 1e-12);
+    assert_close(var_copy.stddev(), rvar20.stddev(), 1e-12);
+
+    // dates round-trip through day numbers
+    if (quant::parse_date("1970-01-01") != 0 || quant::format_date(quant::parse_date("2024-02-29")) != "2024-02-29" ||
+        quant::parse_date("2024-13-01") != quant::kInvalidDate || quant::parse_date("2024-02-30") != quant::kInvalidDate ||
+        quant::parse_date("2023-02-29") != quant::kInvalidDate || quant::parse_date("2023-04-31") != quant::kInvalidDate ||
+        quant::parse_date("2000-02-29") == quant::kInvalidDate || quant::parse_date("1900-02-29") != quant::kInvalidDate) {
+        std::cerr << "date parsing failed\n"; return 2;
+    }
+
+    // CSV ingest: per-symbol columns in file order, unparsable closes dropped
+    auto small = quant::parse_price_csv(
+        "symbol,date,open,high,low,close,adj_close,volume\r\n"
+        "AAA,2024-01-02,1,2,0.5,1.5,1.4,100\r\n"
+        "BBB,2024-01-02,10,11,9,10.5,10.5,200\n"
+        "AAA,2024-01-03,1.5,2.5,1,n/a,2,300\n"
+        "\n"
+        "AAA,2024-01-04,2,3,1.5,2.5,2.5,400");
+    const auto& aaa = small.symbols["AAA"];
+    if (small.rows != 3 || small.skipped != 1 || aaa.size() != 2 || aaa.close[1] != 2.5 ||
+        aaa.adj_close[0] != 1.4 || aaa.volume[1] != 400 || quant::format_date(aaa.date[1]) != "2024-01-04") {
+        std::cerr << "parse_price_csv small input failed\n"; return 2;
+    }
+
+    // multi-threaded ingest matches the single-threaded result exactly
+    std::string big = "symbol,date,open,high,low,close,adj_close,volume\n";
+    for (int i = 0; i < 60000; ++i) {
+        std::string sym = "S" + std::to_string(i % 37);
+        std::string close = i % 997 == 0 ? "bad" : std::to_string(100 + (i % 101) * 0.25);
+        big += sym + ",2024-01-02,1,2,0.5," + close + "," + close + "," + std::to_string(i) + "\n";
+    }
+    while (big.size() < (3u << 20)) big += "PAD,2024-01-02,1,1,1,1,1,1\n";
+    auto serial = quant::parse_price_csv(big, 1);
+    auto parallel = quant::parse_price_csv(big, 4);
+    if (serial.rows != parallel.rows || serial.skipped != parallel.skipped || serial.symbols.size() != 38) {
+        std::cerr << "parallel ingest row counts differ\n"; return 2;
+    }
+    for (const auto& [sym, cols] : serial.symbols) {
+        const auto& other = parallel.symbols[sym];
+        if (cols.close != other.close || cols.volume != other.volume) {
+            std::cerr << "parallel ingest differs for " << sym << "\n"; return 2;
+        }
+    }
+
+    // bar store round-trips columns and rejects files that are not stores
+    std::string store_path = "unit_tests_bars.qbars";
+    std::string store_error;
+    if (!quant::BarStore::write(store_path, small.symbols, store_error)) {
+        std::cerr << "BarStore::write failed: " << store_error << "\n"; return 2;
+    }
+    quant::BarStore store;
+    if (!store.open(store_path, store_error) || store.size() != 2) {
+        std::cerr << "BarStore::open failed: " << store_error << "\n"; return 2;
+    }
+    auto stored = store.find("AAA");
+    if (!stored || stored->symbol != "AAA" || stored->to_series().close != aaa.close ||
+        stored->to_series().date != aaa.date || stored->volume[1] != 400 || store.find("ZZZ")) {
+        std::cerr << "BarStore lookup failed\n"; return 2;
+    }
+    // a row count whose block size wraps to 0 is rejected, not mapped
+    std::string corrupt_path = "unit_tests_corrupt.qbars";
+    {
+        std::ifstream in(store_path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        uint64_t index_offset;
+        std::memcpy(&index_offset, bytes.data() + 16, sizeof(index_offset));
+        uint64_t huge_rows = uint64_t(1) << 62;
+        std::memcpy(&bytes[index_offset + 8], &huge_rows, sizeof(huge_rows));
+        std::ofstream(corrupt_path, std::ios::binary) << bytes;
+    }
+    quant::BarStore corrupt_store;
+    if (corrupt_store.open(corrupt_path, store_error) || store_error.find("corrupt entry 0") == std::string::npos) {
+        std::cerr << "BarStore should reject an overflowing row count: " << store_error << "\n"; return 2;
+    }
+    std::remove(corrupt_path.c_str());
+    quant::BarStore not_store;
+    std::remove(store_path.c_str());
+    { std::ofstream junk(store_path); junk << "symbol,date\n"; }
+    if (quant::BarStore::is_bar_store(store_path) || not_store.open(store_path, store_error)) {
+        std::cerr << "BarStore should reject non-store files\n"; return 2;
+    }
+    std::remove(store_path.c_str());
+
+    // parallel_for visits every index once and propagates exceptions
+    std::vector<int> visits(1000, 0);
+    quant::parallel_for(visits.size(), 4, [&visits](size_t i) { visits[i]++; }, 7);
+    if (std::count(visits.begin(), visits.end(), 1) != 1000) { std::cerr << "parallel_for missed indices\n"; return 2; }
+    bool rethrown = false;
+    try {
+        quant::parallel_for(100, 4, [](size_t i) { if (i == 42) throw std::runtime_error("boom"); });
+    } catch (const std::runtime_error&) { rethrown = true; }
+    if (!rethrown) { std::cerr << "parallel_for should rethrow worker exceptions\n"; return 2; }
+
+    // bar cache: hits after first fetch, ttl 0 never caches, failures not cached
+    std::atomic<int> fetches{0};
+    auto fetch = [&fetches](const std::string& symbol, const std::string&) {
+        ++fetches;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (symbol == "BAD") return alphavantage::FetchResult::failure("bad symbol");
+        return one_bar();
+    };
+    alphavantage::BarCache cache(fetch, std::chrono::seconds(60));
+    auto first = cache.get("AAPL");
+    auto second = cache.get("AAPL");
+    if (first.hit || !second.hit || fetches != 1 || second.bars->size() != 1) {
+        std::cerr << "BarCache expected one fetch then a hit\n"; return 2;
+    }
+    cache.get("AAPL", "full");
+    if (fetches != 2) { std::cerr << "BarCache should key on outputsize\n"; return 2; }
+    if (cache.get("BAD").error != "bad symbol" || cache.get("BAD").hit || fetches != 4) {
+        std::cerr << "BarCache should not cache failures\n"; return 2;
+    }
+
+    // concurrent lookups of a cold key share a single fetch
+    fetches = 0;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) threads.emplace_back([&cache]() { cache.get("MSFT"); });
+    for (auto& t : threads) t.join();
+    auto stats = cache.stats();
+    if (fetches != 1 || stats.entries != 3) {
+        std::cerr << "BarCache single-flight expected 1 fetch, got " << fetches << "\n"; return 2;
+    }
+    // expired entries are neither served nor reported before they are swept
+    alphavantage::BarCache expiring([](const std::string&, const std::string&) {
+        alphavantage::FetchResult result;
+        result.bars.push_back(19000, 1, 1, 1, 1, 1, 1);
+        return result;
+    }, std::chrono::seconds(0));
+    expiring.get("A");
+    if (expiring.get("A").hit || expiring.stats().entries != 0 || !expiring.entries().empty()) {
+        std::cerr << "BarCache reported expired entries\n"; return 2;
+    }
+
+    // a fetcher throwing a non-std exception still releases waiters
+    alphavantage::BarCache throwing_cache([](const std::string&, const std::string&) -> alphavantage::FetchResult {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        throw 42;
+    }, std::chrono::seconds(60));
+    std::vector<std::string> throw_errors(4);
+    std::vector<std::thread> throw_threads;
+    for (size_t i = 0; i < throw_errors.size(); ++i) {
+        throw_threads.emplace_back([&throwing_cache, &throw_errors, i]() { throw_errors[i] = throwing_cache.get("X").error; });
+    }
+    for (auto& t : throw_threads) t.join();
+    if (std::any_of(throw_errors.begin(), throw_errors.end(), [](const std::string& e) { return e != "Fetch failed"; })) {
+        std::cerr << "BarCache should turn a non-std exception into an error result\n"; return 2;
+    }
+
+    alphavantage::BarCache uncached(fetch, std::chrono::seconds(0));
+    uncached.get("AAPL");
+    if (uncached.get("AAPL").hit) { std::cerr << "BarCache ttl 0 should always miss\n"; return 2; }
+
+    // get_many: fresh keys served from cache, cold keys fetched in one batch
+    std::vector<std::string> batched;
+    std::vector<alphavantage::Priority> batch_priorities;
+    alphavantage::BarCache batch_cache(fetch, std::chrono::seconds(60),
+        [&](const std::vector<std::string>& syms, const std::string&,
+            const alphavantage::Client::BatchCallback& on_done, alphavantage::Priority priority) {
+            batched.insert(batched.end(), syms.begin(), syms.end());
+            batch_priorities.push_back(priority);
+            for (size_t i = syms.size(); i-- > 0;) {
+                on_done(i, one_bar());
+            }
+        });
+    batch_cache.get("AAPL");
+    std::vector<std::string> universe = {"AAPL", "MSFT", "GOOG"};
+    std::vector<int> ready(universe.size(), 0);
+    batch_cache.get_many(universe, "compact",
+        [&ready](size_t i, const alphavantage::BarCache::Result& r) { ready[i] += r.bars->empty() ? 0 : 1; });
+    if (batched.size() != 2 || ready != std::vector<int>{1, 1, 1} || batch_cache.stats().hits != 1) {
+        std::cerr << "BarCache::get_many expected one batch of 2 cold symbols\n"; return 2;
+    }
+    batch_cache.get_many({"IBM"}, "compact", [](size_t, const alphavantage::BarCache::Result&) {},
+                         alphavantage::Priority::Interactive);
+    if (batch_priorities != std::vector<alphavantage::Priority>{alphavantage::Priority::Bulk,
+                                                                alphavantage::Priority::Interactive}) {
+        std::cerr << "BarCache::get_many should pass its priority to the batch fetcher\n"; return 2;
+    }
+
+    // unconfigured client reports an error per symbol without touching the network
+    const alphavantage::Client offline("");
+    int errors = 0;
+    offline.fetch_many(universe, "compact",
+        [&errors](size_t, alphavantage::FetchResult result) { errors += !result.ok() && result.bars.empty(); });
+    if (errors != 3 || offline.fetch_daily_adjusted("AAPL").error != "API key not configured") {
+        std::cerr << "unconfigured client expected per-call errors\n"; return 2;
+    }
+
+    // responses parse into results without touching client state
+    auto parsed = alphavantage::Client::parse_daily_response(
+        R"json({"Time Series (Daily)": {"2024-01-03": {"1. open": "2", "2. high": "3", "3. low": "1", "4. close": "2.5", "6. volume": "10"},
+                                    "2024-01-02": {"1. open": "1", "2. high": "2", "3. low": "1", "4. close": "1.5", "6. volume": "20"}}})json");
+    if (!parsed.ok() || parsed.bars.size() != 2 || parsed.bars.date[0] != quant::parse_date("2024-01-02") || parsed.bars.adj_close[1] != 2.5) {
+        std::cerr << "parse_daily_response failed: " << parsed.error << "\n"; return 2;
+    }
+    if (alphavantage::Client::parse_daily_response(R"({"Note": "slow down"})").error != "Rate limit: slow down") {
+        std::cerr << "parse_daily_response should surface rate-limit notes\n"; return 2;
+    }
+
+    // rate limiter: minute bucket, daily quota, interactive ahead of bulk
+    alphavantage::RateLimiter per_minute({2, 0});
+    if (per_minute.try_acquire(alphavantage::Priority::Bulk) != alphavantage::RateLimiter::Clock::duration::zero() ||
+        per_minute.try_acquire(alphavantage::Priority::Bulk) != alphavantage::RateLimiter::Clock::duration::zero() ||
+        per_minute.try_acquire(alphavantage::Priority::Bulk).value() <= std::chrono::seconds(25)) {
+        std::cerr << "RateLimiter minute bucket failed\n"; return 2;
+    }
+    alphavantage::RateLimiter per_day({0, 2});
+    if (!per_day.acquire(alphavantage::Priority::Interactive) || !per_day.acquire(alphavantage::Priority::Bulk) ||
+        per_day.acquire(alphavantage::Priority::Interactive) || per_day.try_acquire(alphavantage::Priority::Bulk) ||
+        per_day.used_today() != 2) {
+        std::cerr << "RateLimiter daily quota failed\n"; return 2;
+    }
+    alphavantage::RateLimiter contended({600, 0});
+    while (contended.try_acquire(alphavantage::Priority::Bulk) == alphavantage::RateLimiter::Clock::duration::zero()) {}
+    std::atomic<bool> interactive_done{false};
+    std::thread interactive([&] { contended.acquire(alphavantage::Priority::Interactive); interactive_done = true; });
+    while (contended.waiting(alphavantage::Priority::Interactive) == 0 && !interactive_done) std::this_thread::yield();
+    while (contended.try_acquire(alphavantage::Priority::Bulk) != alphavantage::RateLimiter::Clock::duration::zero()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    bool bulk_waited = interactive_done;
+    interactive.join();
+    if (!bulk_waited) { std::cerr << "bulk request jumped ahead of a waiting interactive one\n"; return 2; }
+    // a polling interactive batch (try_acquire) holds off bulk ones too
+    alphavantage::RateLimiter polled({600, 0});
+    while (polled.try_acquire(alphavantage::Priority::Bulk) == alphavantage::RateLimiter::Clock::duration::zero()) {}
+    auto interactive_wait = polled.try_acquire(alphavantage::Priority::Interactive).value();
+    std::this_thread::sleep_for(interactive_wait + std::chrono::milliseconds(20));
+    if (polled.try_acquire(alphavantage::Priority::Bulk) == alphavantage::RateLimiter::Clock::duration::zero() ||
+        polled.try_acquire(alphavantage::Priority::Interactive) != alphavantage::RateLimiter::Clock::duration::zero()) {
+        std::cerr << "bulk batch jumped ahead of a polling interactive one\n"; return 2;
+    }
+    auto information = alphavantage::Client::parse_daily_response(
+        R"({"Information": "Thank you for using Alpha Vantage! Our standard API rate limit is 25 requests per day."})");
+    auto per_minute_information = alphavantage::Client::parse_daily_response(
+        R"({"Information": "Please consider spreading out your free API requests more sparingly (rate limit is 5 requests per minute)."})");
+    if (alphavantage::Client::is_rate_limited(information) || !alphavantage::Client::is_quota_exhausted(information) ||
+        !alphavantage::Client::is_rate_limited(per_minute_information) ||
+        !alphavantage::Client::is_rate_limited(alphavantage::FetchResult::failure("HTTP error: 429")) ||
+        alphavantage::Client::is_rate_limited(alphavantage::FetchResult::failure("HTTP error: 500"))) {
+        std::cerr << "rate-limited responses not recognized\n"; return 2;
+    }
+    alphavantage::RateLimiter upstream_spent({0, 0});
+    upstream_spent.on_quota_exhausted();
+    if (upstream_spent.try_acquire(alphavantage::Priority::Interactive) ||
+        upstream_spent.acquire(alphavantage::Priority::Interactive)) {
+        std::cerr << "RateLimiter should refuse requests after the daily quota notice\n"; return 2;
+    }
+
+    // streaming parse writes columns oldest first whatever the input order
+    quant::BarSeries streamed;
+    std::string parse_error;
+    bool streamed_ok = alphavantage::Client::parse_daily_columns(
+        R"json({"Meta Data": {"2. Symbol": "X"}, "Time Series (Daily)": {
+            "2024-01-03": {"1. open": "2", "2. high": "3", "3. low": "1", "4. close": "2.5", "5. adjusted close": "2.4", "6. volume": "10", "7. dividend amount": "0.0"},
+            "2024-01-05": {"1. open": "3", "2. high": "4", "3. low": "2", "4. close": "3.5", "5. volume": "30"},
+            "2024-01-02": {"1. open": "1", "2. high": "2", "3. low": "1", "4. close": "1.5", "6. volume": "20"}}})json",
+        streamed, parse_error);
+    if (!streamed_ok || streamed.size() != 3 || quant::format_date(streamed.date[0]) != "2024-01-02" ||
+        streamed.adj_close[1] != 2.4 || streamed.adj_close[2] != 3.5 || streamed.volume[2] != 30) {
+        std::cerr << "parse_daily_columns failed: " << parse_error << "\n"; return 2;
+    }
+    if (alphavantage::Client::parse_daily_columns(
+            R"json({"Time Series (Daily)": {"2024-01-02": {"1. open": "1", "4. close": "x"}}})json", streamed, parse_error) ||
+        !streamed.empty() || parse_error.empty() ||
+        alphavantage::Client::parse_daily_response(R"json({"Time Series (Daily)": {)json").ok()) {
+        std::cerr << "malformed responses should be rejected\n"; return 2;
+    }
+
+    // HTTP caching: content ETags, If-None-Match matching, encoding negotiation
+    auto cached_body = http::CachedBody::make(std::string(2000, 'x') + "{\"signals\": []}");
+    if (cached_body.etag != http::content_etag(cached_body.identity) ||
+        cached_body.etag == http::content_etag("other") || cached_body.etag.front() != '"' ||
+        !http::etag_matches("\"nope\", W/" + cached_body.etag, cached_body.etag) ||
+        !http::etag_matches("*", cached_body.etag) || http::etag_matches("", cached_body.etag) ||
+        cached_body.etag_for(http::Encoding::Gzip) == cached_body.etag) {
+        std::cerr << "ETag handling failed\n"; return 2;
+    }
+    if (http::negotiate_encoding("gzip, deflate, br") != http::Encoding::Gzip ||
+        http::negotiate_encoding("deflate, gzip;q=0.5") != http::Encoding::Deflate ||
+        http::negotiate_encoding("gzip;q=0, *") != http::Encoding::Deflate ||
+        http::negotiate_encoding("") != http::Encoding::Identity ||
+        http::negotiate_encoding("identity") != http::Encoding::Identity) {
+        std::cerr << "Accept-Encoding negotiation failed\n"; return 2;
+    }
+    std::string inflated(cached_body.identity.size(), '\0');
+    uLongf inflated_size = static_cast<uLongf>(inflated.size());
+    const auto& zlib_bytes = cached_body.encoded(http::Encoding::Deflate);
+    if (uncompress(reinterpret_cast<Bytef*>(&inflated[0]), &inflated_size,
+                   reinterpret_cast<const Bytef*>(zlib_bytes.data()), static_cast<uLong>(zlib_bytes.size())) != Z_OK ||
+        inflated != cached_body.identity || cached_body.gzip.size() >= 100 ||
+        static_cast<unsigned char>(cached_body.gzip[0]) != 0x1f || static_cast<unsigned char>(cached_body.gzip[1]) != 0x8b) {
+        std::cerr << "precompressed bodies do not round-trip\n"; return 2;
+    }
+    auto one_off = http::CachedBody::make_for(cached_body.identity, http::Encoding::Gzip);
+    if (one_off.gzip != cached_body.gzip || !one_off.deflate.empty() || one_off.etag != cached_body.etag ||
+        !http::CachedBody::make_for("x", http::Encoding::Identity).gzip.empty()) {
+        std::cerr << "CachedBody::make_for compressed the wrong encodings\n"; return 2;
+    }
+
+    // live moving averages cover the most recent closes; MA20 averages the
+    // whole history when it is shorter than 20 bars
+    alphavantage::BarCache ma_cache([](const std::string&, const std::string&) {
+        alphavantage::FetchResult result;
+        for (int i = 1; i <= 12; ++i) result.bars.push_back(19723 + i, i, i, i, i, i, 1000);
+        return result;
+    }, std::chrono::seconds(60));
+    signals::SignalService ma_service(ma_cache);
+    auto ma_signal = ma_service.compute_signal("MA");
+    if (ma_signal.ma5 != 10 || ma_signal.ma20 != 6.5 || ma_signal.trend != "strong_up") {
+        std::cerr << "signal MA5/MA20 should use the most recent closes\n"; return 2;
+    }
+
+    // signal snapshots: published whole, failed symbols keep their last good signal
+    int flaky_calls = 0;
+    alphavantage::BarCache snapshot_cache([&flaky_calls](const std::string& symbol, const std::string&) {
+        if (symbol == "FLAKY" && ++flaky_calls > 1) return alphavantage::FetchResult::failure("upstream down");
+        alphavantage::FetchResult result;
+        for (int i = 0; i < 30; ++i) {
+            double px = 100 + i;
+            result.bars.push_back(19723 + i, px, px + 1, px - 1, px, px, 1000);
+        }
+        return result;
+    }, std::chrono::seconds(60));
+    signals::SignalService snapshot_service(snapshot_cache);
+    signals::SignalRefresher refresher(snapshot_service, {"GOOD", "FLAKY"}, std::chrono::seconds(60));
+    if (refresher.current()) { std::cerr << "snapshot published before first refresh\n"; return 2; }
+    refresher.refresh_now();
+    auto before = refresher.current();
+    snapshot_cache.clear();
+    refresher.refresh_now();
+    auto after = refresher.current();
+    if (!before || before->version != 1 || after->version != 2 || after->signals.size() != 2 ||
+        !after->signals[1].error.empty() || after->signals[1].current_price != 129 ||
+        after->signals[1].stale_as_of != before->as_of || !after->signals[0].stale_as_of.empty() ||
+        after->body.identity.find(R"("stale":true,"symbol":"FLAKY")") == std::string::npos ||
+        after->body.identity != signals::SignalService::to_json(after->signals, after->as_of).dump() ||
+        after->body.gzip.empty() || after->body.etag != http::content_etag(after->body.identity)) {
+        std::cerr << "SignalRefresher snapshot failed\n"; return 2;
+    }
+    // snapshots are stamped with the UTC date, as the dashboard sends ?date=
+    auto utc_day = static_cast<int32_t>(std::time(nullptr) / 86400);
+    if (quant::parse_date(after->as_of) != utc_day && quant::parse_date(after->as_of) != utc_day - 1) {
+        std::cerr << "SignalRefresher should stamp UTC dates, got " << after->as_of << "\n"; return 2;
+    }
+    if (after->signals[0].ma5 != 127 || after->signals[0].ma20 != 119.5 || after->signals[0].trend != "strong_up") {
+        std::cerr << "signal moving averages must use the most recent closes\n"; return 2;
+    }
+    refresher.start();
+    refresher.stop();
+    if (refresher.current()->version != 3) { std::cerr << "SignalRefresher background refresh failed\n"; return 2; }
+
+    // added universes get their own snapshot from the same round of fetches
+    signals::SignalRefresher multi(snapshot_service, {"GOOD"}, std::chrono::seconds(60));
+    multi.add_universe({"TECH", {"MSFT", "GOOD"}});
+    if (multi.current("tech")) { std::cerr << "universe snapshot published before first refresh\n"; return 2; }
+    multi.refresh_now();
+    auto tech = multi.current("tech");
+    if (!tech || tech->version != 1 || tech->signals.size() != 2 || tech->signals[0].symbol != "MSFT" ||
+        tech->signals[1].current_price != multi.current()->signals[0].current_price ||
+        tech->body.identity != signals::SignalService::to_json(tech->signals, tech->as_of).dump() ||
+        multi.current("DEFAULT") || multi.current()->signals.size() != 1) {
+        std::cerr << "SignalRefresher universe snapshots failed\n"; return 2;
+    }
+
+    // signal stream: snapshot on subscribe, then only changed signals, coalesced
+    auto make_snapshot = [](uint64_t version, std::vector<std::pair<std::string, double>> prices) {
+        auto snap = std::make_shared<signals::SignalSnapshot>();
+        snap->version = version;
+        snap->as_of = "2024-01-02";
+        for (const auto& [symbol, price] : prices) {
+            signals::Signal sig{symbol, "up", 0.6, price, 1.0, 20.0, price, price, 30, "", ""};
+            snap->signals.push_back(sig);
+        }
+        return signals::SignalRefresher::Snapshot(snap);
+    };
+    signals::SignalStream stream(std::chrono::milliseconds(0));
+    std::vector<std::string> early, late;
+    stream.subscribe([&early](const std::string& m) { early.push_back(m); });
+    stream.publish(make_snapshot(1, {{"AAA", 10}, {"BBB", 20}}));
+    auto late_id = stream.subscribe([&late](const std::string& m) { late.push_back(m); });
+    stream.flush();
+    stream.publish(make_snapshot(2, {{"AAA", 10}, {"BBB", 21}}));
+    stream.publish(make_snapshot(3, {{"AAA", 10}, {"BBB", 21}}));     // no change: nothing to send
+    stream.set_filter(late_id, {"AAA"});
+    stream.flush();
+    if (early.size() != 2 || late.size() != 2 || stream.version() != 2 ||
+        early[0].find("\"AAA\"") == std::string::npos || late[0].find("\"type\":\"snapshot\"") == std::string::npos ||
+        early[1].find("\"BBB\"") == std::string::npos || early[1].find("\"AAA\"") != std::string::npos ||
+        late[1].find("\"BBB\"") != std::string::npos) {
+        std::cerr << "SignalStream diffs failed\n"; return 2;
+    }
+    std::vector<std::string> slow;
+    signals::SignalStream throttled(std::chrono::milliseconds(60000));
+    throttled.publish(make_snapshot(1, {{"AAA", 10}, {"BBB", 20}}));
+    throttled.subscribe([&slow](const std::string& m) { slow.push_back(m); });
+    throttled.publish(make_snapshot(2, {{"AAA", 11}, {"BBB", 20}}));
+    throttled.publish(make_snapshot(3, {{"AAA", 11}, {"BBB", 22}}));
+    throttled.flush();
+    if (slow.size() != 1 || throttled.subscribers() != 1) {
+        std::cerr << "SignalStream should hold updates for throttled clients\n"; return 2;
+    }
+    // a client over its unacknowledged-bytes budget waits for an ack, then
+    // gets one coalesced diff; sends happen outside the stream's lock
+    signals::SignalStream bounded(std::chrono::milliseconds(0), 10);
+    bounded.publish(make_snapshot(1, {{"AAA", 10}, {"BBB", 20}}));
+    std::vector<std::string> backlogged;
+    uint64_t bounded_id = 0;
+    size_t queued_in_send = 0;
+    bounded_id = bounded.subscribe([&](const std::string& m) {
+        backlogged.push_back(m);
+        if (bounded_id) queued_in_send = bounded.queued_bytes(bounded_id);
+    });
+    size_t snapshot_bytes = bounded.queued_bytes(bounded_id);
+    bounded.publish(make_snapshot(2, {{"AAA", 11}, {"BBB", 20}}));
+    bounded.flush();
+    bounded.publish(make_snapshot(3, {{"AAA", 11}, {"BBB", 22}}));
+    bounded.flush();
+    size_t held = backlogged.size();
+    bounded.ack(bounded_id, 1);
+    bounded.flush();
+    if (held != 1 || snapshot_bytes != backlogged[0].size() || backlogged.size() != 2 ||
+        backlogged[1].find("\"version\":3") == std::string::npos || backlogged[1].find("\"AAA\"") == std::string::npos ||
+        backlogged[1].find("\"BBB\"") == std::string::npos || queued_in_send != backlogged[1].size()) {
+        std::cerr << "SignalStream should hold a backlogged client until it acknowledges\n"; return 2;
+    }
+    bounded.ack(bounded_id, 3);
+    if (bounded.queued_bytes(bounded_id) != 0) { std::cerr << "SignalStream ack failed\n"; return 2; }
+
+    // Price store: cold symbols are fetched in full, warm ones topped up compact
+    std::string db_error;
+    auto prices_db = store::open_price_store("sqlite::memory:", db_error);
+    if (!prices_db) { std::cerr << "open_price_store failed: " << db_error << "\n"; return 2; }
+    const int32_t store_today = static_cast<int32_t>(std::time(nullptr) / 86400);
+    std::vector<std::string> requested_sizes;
+    double revised_close = 0;
+    store::PriceSync price_sync(*prices_db, [&](const std::string&, const std::string& outputsize) {
+        requested_sizes.push_back(outputsize);
+        alphavantage::FetchResult r;
+        int days = outputsize == "full" ? 300 : 5;
+        for (int d = days - 1; d >= 0; --d) {
+            double close = d == 0 && revised_close ? revised_close : 100.0 + d;
+            r.bars.push_back(store_today - d, close, close, close, close, close, 1000);
+        }
+        return r;
+    }, std::chrono::seconds(0));
+    auto ingested = price_sync.ingest({"AAA", "BBB"});
+    revised_close = 42.5;
+    auto topped_up = price_sync.fetch("AAA", "compact");
+    quant::BarSeries stored_bars;
+    if (ingested.records_written != 600 || !ingested.failed.empty() || requested_sizes.size() != 3 ||
+        requested_sizes[0] != "full" || requested_sizes[2] != "compact" ||
+        prices_db->last_date("AAA") != store_today || prices_db->last_date("ZZZ") != quant::kInvalidDate ||
+        !prices_db->load("AAA", 0, stored_bars, db_error) || stored_bars.size() != 300 ||
+        topped_up.bars.size() != 100 || topped_up.bars.close.back() != 42.5 ||
+        topped_up.bars.date.front() != store_today - 99) {
+        std::cerr << "PriceSync ingest/top-up failed\n"; return 2;
+    }
+    if (store::PriceSync::upstream_outputsize(quant::kInvalidDate, 20000) != "full" ||
+        store::PriceSync::upstream_outputsize(19990, 20000) != "compact" ||
+        store::PriceSync::upstream_outputsize(19800, 20000) != "full") {
+        std::cerr << "PriceSync::upstream_outputsize failed\n"; return 2;
+    }
+    // fetch_many reports each symbol as its sync lands, and a failed sync is
+    // not retried upstream until the failure expires
+    std::vector<std::string> sync_fetched, sync_order;
+    store::PriceSync batch_sync(*prices_db, nullptr, std::chrono::seconds(3600),
+        [&](const std::vector<std::string>& syms, const std::string&, const alphavantage::Client::BatchCallback& on_done,
+            alphavantage::Priority) {
+            for (size_t j = 0; j < syms.size(); ++j) {
+                sync_fetched.push_back(syms[j]);
+                alphavantage::FetchResult r;
+                if (syms[j] == "DOWN") r = alphavantage::FetchResult::failure("upstream down");
+                else r.bars.push_back(store_today, 10, 10, 10, 10, 10, 1000);
+                on_done(j, std::move(r));
+                sync_order.push_back("fetched " + syms[j]);
+            }
+        });
+    auto collect = [&](size_t, alphavantage::FetchResult result) {
+        sync_order.push_back(result.ok() ? "ok" : result.error);
+    };
+    batch_sync.fetch_many({"CCC", "DOWN"}, "compact", collect);
+    batch_sync.fetch_many({"CCC", "DOWN"}, "compact", collect);
+    if (sync_fetched != std::vector<std::string>{"CCC", "DOWN"} ||
+        sync_order != std::vector<std::string>{"ok", "fetched CCC", "upstream down", "fetched DOWN", "ok", "upstream down"}) {
+        std::cerr << "PriceSync::fetch_many should stream results and cache failures\n"; return 2;
+    }
+    // a symbol already being synced (ingest) is not fetched again by a lookup
+    std::atomic<int> shared_fetches{0};
+    store::PriceSync shared_sync(*prices_db, [&](const std::string&, const std::string&) {
+        ++shared_fetches;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        alphavantage::FetchResult r;
+        r.bars.push_back(store_today, 20, 20, 20, 20, 20, 1000);
+        return r;
+    }, std::chrono::seconds(0));
+    std::thread ingesting([&] { shared_sync.ingest({"EEE"}); });
+    while (shared_fetches == 0) std::this_thread::yield();
+    std::string joined_error = "-";
+    shared_sync.fetch_many({"EEE"}, "compact", [&](size_t, alphavantage::FetchResult result) {
+        joined_error = result.error;
+    });
+    ingesting.join();
+    if (shared_fetches != 1 || !joined_error.empty()) {
+        std::cerr << "PriceSync should share an in-progress sync, fetched " << shared_fetches << " times\n"; return 2;
+    }
+
+    // backtest: constant-drift symbols, so signal rank and forward return rank agree
+    // Views borrow their symbol, so the names are owned (and sized) up front
+    std::vector<quant::BarSeries> drift_history(21);
+    std::vector<std::string> drift_names(21);
+    std::vector<quant::BarView> drift_universe;
+    for (int k = 0; k < 21; ++k) {
+        drift_names[k] = "S" + std::to_string(k);
+        auto& cols = drift_history[k];
+        double px = 100;
+        for (int d = 0; d < 100; ++d) {
+            cols.push_back(19000 + d, px, px, px, px, px, 1000);
+            px *= 1.0 + (k - 10) * 0.001;
+        }
+        drift_universe.push_back(cols.view(drift_names[k]));
+    }
+    auto bt = backtest::run(drift_universe);
+    if (bt.folds.size() != 5 || bt.overall.observations != 21 * 51 || bt.overall.dates != 51 ||
+        bt.overall.first_date != 19029 || bt.overall.last_date != 19079 || bt.overall.hit_rate != 1.0 ||
+        !(bt.overall.mean_ic > 0.9) || !(bt.overall.decile_spread > 0) ||
+        bt.folds[0].observations + bt.folds[4].observations >= bt.overall.observations) {
+        std::cerr << "backtest::run metrics failed\n"; return 2;
+    }
+    backtest::Config single_thread;
+    single_thread.threads = 1;
+    auto bt_serial = backtest::run(drift_universe, single_thread);
+    if (bt_serial.overall.mean_ic != bt.overall.mean_ic || bt_serial.overall.decile_returns != bt.overall.decile_returns) {
+        std::cerr << "backtest::run should not depend on thread count\n"; return 2;
+    }
+
+    // prob model: feature columns match the scalar indicators on the last bar
+    const auto& walk = drift_history[14].close;
+    std::vector<double> walk_prices(walk.begin(), walk.end());
+    for (size_t i = 0; i < walk_prices.size(); ++i) walk_prices[i] *= 1.0 + 0.02 * std::sin(i * 0.7);
+    model::FeatureMatrix latest;
+    latest.resize(2);
+    std::vector<double> last20(walk_prices.end() - 20, walk_prices.end()), walk_returns;
+    for (size_t i = walk_prices.size() - 20; i < walk_prices.size(); ++i) {
+        walk_returns.push_back((walk_prices[i] - walk_prices[i - 1]) / walk_prices[i - 1]);
+    }
+    if (!model::latest_features(walk_prices, latest, 1) ||
+        model::latest_features(quant::Span<const double>(walk_prices).first(49), latest, 0) ||
+        std::abs(latest.at(1, model::kMa50Gap) - (walk_prices.back() / quant::sma(walk_prices, 50) - 1)) > 1e-12 ||
+        std::abs(latest.at(1, model::kSlope20) - *quant::slope_logprice(last20)) > 1e-12 ||
+        std::abs(latest.at(1, model::kRv20) - quant::realized_vol(walk_returns)) > 1e-12) {
+        std::cerr << "model::latest_features mismatch\n"; return 2;
+    }
+    // ... and the training series agrees on that bar
+    std::vector<double> walk_series(walk_prices.size() * model::kFeatureCount);
+    model::feature_series(walk_prices, walk_series.data(), walk_prices.size());
+    for (size_t j = 0; j < model::kFeatureCount; ++j) {
+        if (std::abs(walk_series[(j + 1) * walk_prices.size() - 1] - latest.at(1, j)) > 1e-12) {
+            std::cerr << "model::feature_series differs from latest_features on " << model::kFeatureNames[j] << "\n"; return 2;
+        }
+    }
+
+    // IRLS recovers a planted signal and does not depend on the thread count
+    model::FeatureMatrix planted;
+    planted.resize(20000);
+    std::vector<double> planted_y(planted.rows);
+    uint64_t lcg = 12345;
+    auto uniform = [&lcg]() { lcg = lcg * 6364136223846793005ULL + 1442695040888963407ULL; return (lcg >> 11) * 0x1.0p-53; };
+    for (size_t i = 0; i < planted.rows; ++i) {
+        for (size_t j = 0; j < model::kFeatureCount; ++j) planted.column(j)[i] = uniform() * 0.1 - 0.05;
+        double z = 40.0 * planted.column(model::kReturn20)[i] - 0.2;
+        planted_y[i] = uniform() < 1.0 / (1.0 + std::exp(-z)) ? 1.0 : 0.0;
+    }
+    model::TrainOptions one_thread;
+    one_thread.threads = 1;
+    auto fit = model::train(planted, planted_y);
+    auto fit_serial = model::train(planted, planted_y, one_thread);
+    std::vector<double> planted_probs;
+    fit.model.predict(planted, planted_probs);
+    if (!fit.ok() || !fit.converged || std::abs(fit.model.weights[model::kReturn20] - 40.0) > 6.0 ||
+        std::abs(fit.model.weights[model::kRv20]) > 6.0 || fit.model.weights != fit_serial.model.weights ||
+        !(model::auc(planted_probs, planted_y) > 0.75) ||
+        std::abs(planted_probs[7] - fit.model.predict(planted, 7)) > 1e-12 ||
+        std::abs(model::log_loss(planted_probs, planted_y) - fit.log_loss) > 1e-9) {
+        std::cerr << "model::train failed to recover the planted weights\n"; return 2;
+    }
+    fit.model.version = "test-1";
+    model::ProbModel reloaded;
+    std::string model_error;
+    if (!model::ProbModel::from_json(fit.model.to_json(), reloaded, model_error) || reloaded.version != "test-1" ||
+        reloaded.weights != fit.model.weights || reloaded.intercept != fit.model.intercept ||
+        model::ProbModel::from_json(R"({"version":"x","features":["ma50_gap"],"weights":[1],"intercept":0})", reloaded, model_error)) {
+        std::cerr << "ProbModel JSON round trip failed\n"; return 2;
+    }
+    auto training = model::build_training_set(drift_universe, 20);
+    auto [train_part, test_part] = training.split(19060);
+    if (training.y.size() != 21 * 31 || train_part.y.size() + test_part.y.size() != training.y.size() ||
+        train_part.date.back() >= 19060 || test_part.date.front() < 19060) {
+        std::cerr << "model::build_training_set rows failed\n"; return 2;
+    }
+
+    // signal service scores prob_up with the model once enough history exists
+    alphavantage::BarCache model_cache([&walk_prices](const std::string& symbol, const std::string&) {
+        alphavantage::FetchResult result;
+        size_t bars = symbol == "LONG" ? walk_prices.size() : 30;
+        for (size_t i = 0; i < bars; ++i) {
+            double px = walk_prices[i];
+            result.bars.push_back(19000 + static_cast<int32_t>(i), px, px, px, px, px, 1000);
+        }
+        return result;
+    }, std::chrono::seconds(60));
+    signals::SignalService model_service(model_cache);
+    auto constant_model = std::make_shared<model::ProbModel>();
+    constant_model->intercept = std::log(0.7 / 0.3);
+    model_service.set_model(constant_model);
+    auto modelled = model_service.compute_signals({"LONG", "SHORT"});
+    if (std::abs(modelled[0].prob_up - 0.7) > 1e-12 || modelled[1].prob_up == 0.7 ||
+        std::abs(model_service.compute_signal("LONG").prob_up - 0.7) > 1e-12) {
+        std::cerr << "SignalService model scoring failed\n"; return 2;
+    }
+    std::vector<signals::Signal> streamed_signals(2);
+    std::vector<int> streamed_calls(2, 0);
+    model_service.stream_signals({"LONG", "SHORT"}, [&](size_t index, const signals::Signal& signal) {
+        ++streamed_calls[index];
+        streamed_signals[index] = signal;
+    });
+    if (streamed_calls != std::vector<int>{1, 1} || streamed_signals[0].prob_up != modelled[0].prob_up ||
+        streamed_signals[1].prob_up != modelled[1].prob_up || streamed_signals[1].ma20 != modelled[1].ma20) {
+        std::cerr << "SignalService::stream_signals differs from compute_signals\n"; return 2;
+    }
+    // only max_fetches uncached symbols go upstream, the rest are reported
+    std::vector<std::string> capped_errors(4, "-");
+    model_service.stream_signals({"LONG", "NEW1", "SHORT", "NEW2"}, [&](size_t index, const signals::Signal& signal) {
+        capped_errors[index] = signal.error;
+    }, 1);
+    if (capped_errors[0] != "" || capped_errors[1] != "" || capped_errors[2] != "" ||
+        capped_errors[3].rfind(signals::SignalService::kNotFetched, 0) != 0 ||
+        !model_cache.fresh("NEW1", "compact") || model_cache.fresh("NEW2", "compact")) {
+        std::cerr << "SignalService::stream_signals fetch cap failed\n"; return 2;
+    }
+
+    // arena: rewinding reuses the same memory, nested scopes unwind in order
+    quant::Arena arena(1024);
+    void* arena_first = arena.allocate(100, 8);
+    auto mark = arena.mark();
+    void* spilled = arena.allocate(5000, 64);
+    arena.rewind(mark);
+    void* again = arena.allocate(16, 16);
+    arena.reset();
+    if (arena.allocate(100, 8) != arena_first || reinterpret_cast<uintptr_t>(again) % 16 != 0 ||
+        reinterpret_cast<uintptr_t>(spilled) % 64 != 0 ||
+        arena.stats().heap_blocks != 2 || arena.stats().high_water < 5100) {
+        std::cerr << "quant::Arena rewind failed\n"; return 2;
+    }
+    void* outer_ptr;
+    {
+        quant::ArenaScope outer;
+        outer_ptr = outer.resource()->allocate(64, 8);
+        { quant::ArenaScope inner; (void)inner.resource()->allocate(256, 8); }
+        if (outer.resource()->allocate(64, 8) != static_cast<char*>(outer_ptr) + 64) {
+            std::cerr << "quant::ArenaScope nesting failed\n"; return 2;
+        }
+    }
+    { quant::ArenaScope scope; if (scope.resource()->allocate(64, 8) != outer_ptr) { std::cerr << "quant::ArenaScope rewind failed\n"; return 2; } }
+
+    // warm compute_signals: heap allocations do not grow with the symbol count
+    alphavantage::BarCache warm_cache([&walk_prices](const std::string&, const std::string&) {
+        alphavantage::FetchResult result;
+        for (size_t i = 0; i < walk_prices.size(); ++i) {
+            double px = walk_prices[i];
+            result.bars.push_back(19000 + static_cast<int32_t>(i), px, px, px, px, px, 1000);
+        }
+        return result;
+    }, std::chrono::seconds(60));
+    signals::SignalService warm_service(warm_cache);
+    warm_service.set_model(constant_model);
+    std::vector<std::string> few, many;
+    for (int i = 0; i < 64; ++i) (i < 8 ? few : many).push_back("S" + std::to_string(i));
+    many.insert(many.end(), few.begin(), few.end());
+    warm_service.compute_signals(many);
+    warm_service.compute_signals(many);
+    uint64_t before_few = heap_allocations;
+    auto few_signals = warm_service.compute_signals(few);
+    uint64_t few_allocations = heap_allocations - before_few;
+    uint64_t before_many = heap_allocations;
+    auto many_signals = warm_service.compute_signals(many);
+    uint64_t many_allocations = heap_allocations - before_many;
+    if (few_allocations != many_allocations || many_allocations > 4 ||
+        std::abs(many_signals.back().prob_up - 0.7) > 1e-12) {
+        std::cerr << "steady-state compute_signals allocated " << few_allocations << " / "
+                  << many_allocations << " times\n"; return 2;
+    }
+
+    // as-of signals: binary search into the full history, then the live window
+    quant::BarSeries asof_history;
+    for (int i = 0; i < 400; ++i) {
+        double px = 100 + 10 * std::sin(i * 0.05) + i * 0.1;
+        asof_history.push_back(19000 + i + (i / 5) * 2, px, px, px, px, px, 1000);   // weekends skipped
+    }
+    auto asof_day = [&asof_history](size_t i) { return asof_history.date[i]; };
+    if (asof_history.view().as_of(asof_day(250)).size() != 251 ||
+        asof_history.view().as_of(asof_day(249) + 1).size() != 250 ||  // weekend maps back to Friday
+        !asof_history.view().as_of(18999).empty() ||
+        asof_history.view().as_of(asof_day(250)).last(100).date.front() != asof_day(151)) {
+        std::cerr << "quant::BarView::as_of failed\n"; return 2;
+    }
+    // as-of history comes from the cache or local storage, never upstream
+    std::vector<std::string> asof_outputsizes;
+    alphavantage::BarCache asof_cache([](const std::string&, const std::string&) {
+        return alphavantage::FetchResult::failure("as-of lookup went upstream");
+    }, std::chrono::seconds(60));
+    alphavantage::BarCache live_cache([&](const std::string&, const std::string&) {
+        alphavantage::FetchResult result;
+        result.bars = asof_history.view().slice(151, 251).to_series();
+        return result;
+    }, std::chrono::seconds(60));
+    signals::SignalService asof_service(asof_cache), live_service(live_cache);
+    auto uncached_asof = asof_service.compute_signal("X", asof_day(250));
+    if (!alphavantage::BarCache::is_not_cached(uncached_asof.error) || uncached_asof.data_points != 0) {
+        std::cerr << "SignalService as-of without local history should fail as not cached\n"; return 2;
+    }
+    asof_cache.set_local_fetch([&](const std::string& symbol, const std::string& outputsize) {
+        asof_outputsizes.push_back(outputsize);
+        if (symbol == "MISSING") return alphavantage::FetchResult::failure("No stored data for MISSING");
+        alphavantage::FetchResult result;
+        result.bars = asof_history;
+        return result;
+    });
+    auto missing_asof = asof_service.compute_signal("MISSING", asof_day(250));
+    asof_outputsizes.clear();
+    if (missing_asof.error != "History not cached: No stored data for MISSING") {
+        std::cerr << "SignalService as-of missing history error: " << missing_asof.error << "\n"; return 2;
+    }
+    auto past = asof_service.compute_signal("X", asof_day(250));
+    auto live = live_service.compute_signal("X");
+    if (past.current_price != live.current_price || past.ma20 != live.ma20 || past.volatility != live.volatility ||
+        past.trend != live.trend || past.prob_up != live.prob_up || past.data_points != 100 ||
+        asof_outputsizes != std::vector<std::string>{"full"}) {
+        std::cerr << "SignalService as-of signal differs from the live one on the same window\n"; return 2;
+    }
+    asof_service.compute_signals({"X"}, asof_day(250));
+    auto memo_after_hit = asof_service.memo_stats();
+    asof_cache.invalidate("X");
+    asof_service.compute_signal("X", asof_day(250));
+    auto memo_after_refetch = asof_service.memo_stats();
+    if (memo_after_hit.hits != 1 || memo_after_hit.misses != 1 || memo_after_hit.entries != 1 ||
+        memo_after_refetch.misses != 2 ||
+        asof_service.compute_signal("X", 18000).error.rfind("No bars on or before", 0) != 0) {
+        std::cerr << "SignalService as-of memo failed\n"; return 2;
+    }
+    std::vector<std::string> streamed_symbols;
+    asof_service.stream_signals({"X", "Y"}, asof_day(250), [&](size_t index, const signals::Signal& signal) {
+        if (index < 2 && signal.current_price == past.current_price) streamed_symbols.push_back(signal.symbol);
+    });
+    std::sort(streamed_symbols.begin(), streamed_symbols.end());
+    if (streamed_symbols != std::vector<std::string>{"X", "Y"}) {
+        std::cerr << "SignalService::stream_signals as-of failed\n"; return 2;
+    }
+    // batch as-of scoring matches the streamed rows, memo hits keep their score
+    asof_service.set_model(constant_model);
+    auto scored_asof = asof_service.compute_signals({"X", "Y"}, asof_day(250));
+    auto rescored_asof = asof_service.compute_signals({"X", "Y"}, asof_day(250));
+    std::vector<double> streamed_probs(2);
+    asof_service.stream_signals({"X", "Y"}, asof_day(250), [&](size_t index, const signals::Signal& signal) {
+        streamed_probs[index] = signal.prob_up;
+    });
+    if (std::abs(scored_asof[0].prob_up - 0.7) > 1e-12 || scored_asof[1].prob_up != scored_asof[0].prob_up ||
+        rescored_asof[1].prob_up != scored_asof[1].prob_up || streamed_probs[0] != scored_asof[0].prob_up ||
+        asof_service.memo_stats().hits < 4) {
+        std::cerr << "SignalService as-of batch scoring failed\n"; return 2;
+    }
+
+    // metrics: histogram buckets tile the range and quantiles stay within a bucket
+    for (uint64_t v : {0ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, 1ull << 40}) {
+        size_t b = metrics::Histogram::bucket_index(v);
+        if (v < metrics::Histogram::bucket_lower(b) || v >= metrics::Histogram::bucket_upper(b) ||
+            (b + 1 < metrics::Histogram::kBuckets &&
+             metrics::Histogram::bucket_upper(b) != metrics::Histogram::bucket_lower(b + 1))) {
+            std::cerr << "metrics::Histogram bucket " << b << " does not hold " << v << "\n"; return 2;
+        }
+    }
+    metrics::Registry metric_registry;
+    auto& latency = metric_registry.histogram("test_latency_seconds", "test", {{"route", "/a\"b"}});
+    for (uint64_t v = 1; v <= 1000; ++v) latency.record(v * 1000);     // 1us .. 1ms
+    auto latency_snap = latency.snapshot();
+    double p50 = latency_snap.quantile(0.5), p99 = latency_snap.quantile(0.99);
+    if (latency_snap.count != 1000 || latency_snap.sum != 500500000 ||
+        std::abs(p50 - 500000) > 500000 * 0.125 || std::abs(p99 - 990000) > 990000 * 0.125 ||
+        &metric_registry.histogram("test_latency_seconds", "test", {{"route", "/a\"b"}}) != &latency) {
+        std::cerr << "metrics::Histogram quantiles failed: p50 " << p50 << " p99 " << p99 << "\n"; return 2;
+    }
+    auto& events = metric_registry.counter("test_events_total", "test");
+    std::vector<std::thread> incrementers;
+    for (int t = 0; t < 4; ++t) incrementers.emplace_back([&events]() { for (int i = 0; i < 10000; ++i) events.inc(); });
+    for (auto& t : incrementers) t.join();
+    metric_registry.gauge_fn("test_depth", "test", {}, []() { return 2.5; });
+    bool type_clash = false;
+    try { metric_registry.counter("test_depth", "test"); } catch (const std::logic_error&) { type_clash = true; }
+    std::string exposition = metric_registry.expose();
+    if (events.value() != 40000 || !type_clash ||
+        exposition.find("# TYPE test_latency_seconds histogram\n") == std::string::npos ||
+        exposition.find("test_latency_seconds_bucket{route=\"/a\\\"b\",le=\"+Inf\"} 1000\n") == std::string::npos ||
+        exposition.find("test_latency_seconds_count{route=\"/a\\\"b\"} 1000\n") == std::string::npos ||
+        exposition.find("test_latency_seconds_sum{route=\"/a\\\"b\"} 0.5005\n") == std::string::npos ||
+        exposition.find("test_events_total 40000\n") == std::string::npos ||
+        exposition.find("test_depth 2.5\n") == std::string::npos) {
+        std::cerr << "metrics::Registry exposition failed:\n" << exposition; return 2;
+    }
+    // bounds sit on bucket edges: 1.024us holds only the 1us sample, 10s everything
+    if (exposition.find("le=\"1.024e-06\"} 1\n") == std::string::npos ||
+        exposition.find("le=\"9.663676416\"} 1000\n") == std::string::npos) {
+        std::cerr << "metrics::Registry bucket bounds failed:\n" << exposition; return 2;
+    }
+    // timers store raw ticks and convert on the way out; a disabled timer records nothing
+    auto& timed = metric_registry.timer("test_timer_seconds", "test");
+    { metrics::ScopedTimer timer(timed); std::this_thread::sleep_for(std::chrono::milliseconds(5)); }
+    { metrics::ScopedTimer timer(timed, false); }
+    auto timed_snap = timed.snapshot();
+    double timed_ns = timed_snap.quantile(0.5);
+    if (timed_snap.count != 1 || timed_ns < 4e6 || timed_ns > 5e8 ||
+        std::abs(static_cast<double>(timed_snap.sum) - timed_ns) > timed_ns * 0.125) {
+        std::cerr << "metrics::ScopedTimer recorded " << timed_ns << "ns for a 5ms sleep\n"; return 2;
+    }
+    if (timed_snap.count_below(1e10) != 1 ||
+        metric_registry.expose().find("test_timer_seconds_count 1\n") == std::string::npos) {
+        std::cerr << "metrics timer exposition failed\n"; return 2;
+    }
+    bool unit_clash = false;
+    try { metric_registry.histogram("test_timer_seconds", "test"); } catch (const std::logic_error&) { unit_clash = true; }
+    uint32_t sample_calls = 0;
+    std::vector<int> sampled;
+    for (int i = 1; i <= 8; ++i) {
+        if (metrics::sample(sample_calls, 4)) sampled.push_back(i);
+    }
+    if (!unit_clash || sampled != std::vector<int>{4, 8}) {
+        std::cerr << "metrics timer registration or sampling failed\n"; return 2;
+    }
+
+    // universe files: comments, mixed separators, case and duplicates
+    auto parsed_universe = signals::parse_universe("# header\naapl, MSFT\tgoog # trailing\n\nAAPL,,tsla");
+    if (parsed_universe != std::vector<std::string>{"AAPL", "MSFT", "GOOG", "TSLA"}) {
+        std::cerr << "signals::parse_universe failed\n"; return 2;
+    }
+    std::vector<std::string> normalized;
+    std::string normalize_error;
+    if (!signals::normalize_symbols({" aapl", "BRK.B", "", "AAPL ", "^gspc", "\t"}, normalized, normalize_error) ||
+        normalized != std::vector<std::string>{"AAPL", "BRK.B", "^GSPC"}) {
+        std::cerr << "signals::normalize_symbols failed: " << normalize_error << "\n"; return 2;
+    }
+    normalized.clear();
+    if (signals::normalize_symbols({"AAPL", "MS FT"}, normalized, normalize_error) ||
+        normalize_error != "Invalid symbol 'MS FT'" ||
+        signals::normalize_symbols({std::string(signals::kMaxSymbolLength + 1, 'A')}, normalized, normalize_error)) {
+        std::cerr << "signals::normalize_symbols accepted an invalid symbol\n"; return 2;
+    }
+    std::string universe_dir = "unit_tests_universes";
+    std::filesystem::remove_all(universe_dir);
+    std::filesystem::create_directory(universe_dir);
+    { std::ofstream f(universe_dir + "/tech.txt"); f << "AAPL MSFT\n"; }
+    { std::ofstream f(universe_dir + "/Banks.txt"); f << "JPM,BAC\n"; }
+    { std::ofstream f(universe_dir + "/empty.txt"); f << "# nothing yet\n"; }
+    { std::ofstream f(universe_dir + "/notes.md"); f << "IBM\n"; }
+    std::vector<signals::Universe> universes{{signals::kDefaultUniverse, {"IBM"}}};
+    std::string universe_error;
+    bool universes_loaded = signals::load_universes(universe_dir, universes, universe_error);
+    if (!universes_loaded || universes.size() != 3 || universes[1].name != "BANKS" || universes[2].name != "TECH" ||
+        !signals::find_universe(universes, "tech") || signals::find_universe(universes, "EMPTY") ||
+        signals::find_universe(universes, "tech")->symbols != std::vector<std::string>{"AAPL", "MSFT"}) {
+        std::cerr << "signals::load_universes failed: " << universe_error << "\n"; return 2;
+    }
+    { std::ofstream f(universe_dir + "/default.txt"); f << "SPY\n"; }
+    std::vector<signals::Universe> clashing{{signals::kDefaultUniverse, {"IBM"}}};
+    // BANKS sorts before the clashing DEFAULT, and is not left behind
+    if (signals::load_universes(universe_dir, clashing, universe_error) || clashing.size() != 1 ||
+        !signals::load_universes("unit_tests_no_such_dir", clashing, universe_error)) {
+        std::cerr << "signals::load_universes should reject duplicates whole and skip missing dirs\n"; return 2;
+    }
+    std::filesystem::remove_all(universe_dir);
+
+    // rank: the radix path (n >= 256) orders like a comparison sort, ties averaged
+    std::vector<float> rank_values;
+    for (int i = 0; i < 1000; ++i) rank_values.push_back(static_cast<float>((i * 7919) % 500) - 250.5f);
+    std::vector<uint64_t> rank_sorted(rank_values.size()), rank_expected(rank_values.size());
+    std::vector<double> rank_out(rank_values.size());
+    quant::rank(rank_values.data(), rank_values.size(), rank_sorted.data(), rank_out.data());
+    for (size_t i = 0; i < rank_values.size(); ++i) {
+        rank_expected[i] = uint64_t(quant::order_key(rank_values[i])) << 32 | i;
+    }
+    std::sort(rank_expected.begin(), rank_expected.end());
+    if (rank_sorted != rank_expected || rank_out[0] != 0.5 || rank_out[500] != 0.5 ||
+        rank_out[1] != std::count_if(rank_values.begin(), rank_values.end(), [&](float v) { return v < rank_values[1]; }) + 0.5) {
+        std::cerr << "quant::rank failed\n"; return 2;
+    }
+
+    // cross-section: ranks, z-scores and deciles over the valid rows only
+    std::vector<double> cs_returns, cs_vols;
+    std::vector<uint8_t> cs_valid;
+    for (int i = 0; i < 21; ++i) {
+        cs_returns.push_back(i == 20 ? NAN : i - 5.0);     // -5 .. 14, then a NaN row
+        cs_vols.push_back(40.0 - i);
+        cs_valid.push_back(i != 3);                         // row 3 failed
+    }
+    auto cs = signals::cross_section(cs_returns.data(), cs_vols.data(), cs_valid.data(), cs_returns.size());
+    double cs_mean = 92.0 / 19;                          // mean of -5..14 without -2
+    double cs_var = 0;
+    for (int i = 0; i < 20; ++i) if (i != 3) cs_var += (i - 5.0 - cs_mean) * (i - 5.0 - cs_mean);
+    double cs_std = std::sqrt(cs_var / 19);
+    if (cs.scored != 19 || std::abs(cs.return_mean - cs_mean) > 1e-9 || std::abs(cs.return_std - cs_std) > 1e-9 ||
+        cs.return_percentile[0] != 0.0 || cs.return_percentile[19] != 100.0 || cs.volatility_percentile[0] != 100.0 ||
+        std::abs(cs.return_percentile[10] - 900.0 / 18) > 1e-12 ||
+        std::abs(cs.return_zscore[19] - (14.0 - cs_mean) / cs_std) > 1e-9 ||
+        !std::isnan(cs.return_percentile[3]) || !std::isnan(cs.volatility_zscore[20]) ||
+        cs.return_decile[0] != 1 || cs.return_decile[1] != 1 || cs.return_decile[2] != 2 ||
+        cs.return_decile[19] != 10 || cs.return_decile[3] != 0 || cs.return_decile[20] != 0) {
+        std::cerr << "signals::cross_section failed\n"; return 2;
+    }
+    std::vector<double> flat(4, 2.0);
+    std::vector<uint8_t> all_valid(4, 1);
+    auto cs_flat = signals::cross_section(flat.data(), flat.data(), all_valid.data(), 4);
+    if (cs_flat.return_percentile[0] != 50.0 || cs_flat.return_zscore[2] != 0.0 || cs_flat.return_decile[3] != 4) {
+        std::cerr << "signals::cross_section ties failed\n"; return 2;
+    }
+
+    std::vector<signals::Signal> ranked_signals;
+    for (int i = 0; i < 20; ++i) {
+        signals::Signal signal{"S" + std::to_string(i), "neutral", 0.5, 100.0, i * 1.0, 20.0 + (i % 3), 100.0, 100.0, 100, "", ""};
+        if (i == 7) signal.error = "No data";
+        ranked_signals.push_back(signal);
+    }
+    auto ranked_json = signals::SignalService::to_json(ranked_signals, "2024-01-02");
+    if (ranked_json["cross_section"]["scored"] != 19 ||
+        ranked_json["cross_section"]["top_decile"] != nlohmann::json({"S19"}) ||
+        ranked_json["cross_section"]["bottom_decile"] != nlohmann::json({"S0", "S1"}) ||
+        ranked_json["signals"][19]["cross_section"]["return_percentile"] != 100.0 ||
+        ranked_json["signals"][7].contains("cross_section")) {
+        std::cerr << "SignalService::to_json cross-section failed:\n" << ranked_json.dump(2) << "\n"; return 2;
+    }
+
+    std::mt19937_64 json_rng(7);
+    std::vector<double> json_numbers = {0.0, -0.0, 1.0, -1.0, 0.1, 123.45, 1e-5, 1e-4, 0.0001234, 1e15, 1e16,
+                                        123456789012345.0, 1234567890123456.0, 5e-324, 1.7976931348623157e308,
+                                        NAN, INFINITY, -INFINITY, 100.0 / 3.0};
+    for (int i = 0; i < 2000; ++i) {
+        json_numbers.push_back(std::round(std::normal_distribution<double>(0.0, 500.0)(json_rng) * 100) / 100.0);
+        uint64_t bits = json_rng();
+        double any;
+        std::memcpy(&any, &bits, sizeof(any));
+        json_numbers.push_back(any);
+    }
+    for (double x : json_numbers) {
+        std::string written;
+        http::JsonWriter::append_number(written, x);
+        if (written != nlohmann::json(x).dump()) {
+            std::cerr << "JsonWriter::append_number(" << x << ") = " << written
+                      << ", dump() = " << nlohmann::json(x).dump() << "\n"; return 2;
+        }
+    }
+    for (std::string text : {std::string(""), std::string("plain"), std::string("q\"b\\s/\b\f\n\r\t\x01\x1f\x7f"),
+                             std::string("caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x93\x88")}) {
+        std::string written;
+        http::JsonWriter::append_string(written, text);
+        if (written != nlohmann::json(text).dump()) {
+            std::cerr << "JsonWriter::append_string failed: " << written << "\n"; return 2;
+        }
+    }
+    std::string invalid_utf8;
+    http::JsonWriter::append_string(invalid_utf8, "a\xFF" "b\xC3");
+    if (invalid_utf8 != "\"a\xEF\xBF\xBD" "b\xEF\xBF\xBD\"") {
+        std::cerr << "JsonWriter::append_string invalid UTF-8 failed: " << invalid_utf8 << "\n"; return 2;
+    }
+    std::string nested;
+    http::JsonWriter nested_writer(nested);
+    nested_writer.begin_array();
+    nested_writer.begin_object();
+    nested_writer.key("a");
+    nested_writer.begin_array();
+    nested_writer.end_array();
+    nested_writer.key("b");
+    nested_writer.null();
+    nested_writer.end_object();
+    nested_writer.integer(-3);
+    nested_writer.begin_object();
+    nested_writer.end_object();
+    nested_writer.end_array();
+    if (nested != R"([{"a":[],"b":null},-3,{}])") {
+        std::cerr << "JsonWriter nesting failed: " << nested << "\n"; return 2;
+    }
+    std::string deep;
+    http::JsonWriter deep_writer(deep);
+    bool too_deep = false;
+    try {
+        for (int d = 0; d <= http::JsonWriter::kMaxDepth; ++d) deep_writer.begin_array();
+    } catch (const std::length_error&) {
+        too_deep = true;
+    }
+    if (!too_deep || deep != std::string(http::JsonWriter::kMaxDepth, '[')) {
+        std::cerr << "JsonWriter should refuse to nest past kMaxDepth\n"; return 2;
+    }
+
+    // The direct writer matches dump() on the same signals, including
+    // unpriced, errored and NaN-valued ones
+    for (size_t count : {size_t(0), size_t(1), size_t(7), size_t(250)}) {
+        std::vector<signals::Signal> random_signals;
+        std::uniform_real_distribution<double> uniform(-50.0, 150.0);
+        for (size_t i = 0; i < count; ++i) {
+            signals::Signal signal{"SYM" + std::to_string(i), i % 2 ? "up" : "strong_down", uniform(json_rng) / 150.0,
+                                   uniform(json_rng), uniform(json_rng), uniform(json_rng) + 50.0,
+                                   uniform(json_rng), uniform(json_rng), static_cast<int>(i), "", ""};
+            if (i % 7 == 4) signal.stale_as_of = "2024-01-01";
+            if (i % 11 == 3) signal.error = "Rate \"limited\"\n";
+            if (i % 13 == 5) signal.volatility = NAN;
+            if (i % 17 == 2) signal.monthly_return = 1e17;
+            random_signals.push_back(signal);
+        }
+        std::string direct;
+        signals::SignalService::write_json(direct, random_signals, "2024-01-02");
+        std::string expected = signals::SignalService::to_json(random_signals, "2024-01-02").dump();
+        if (direct != expected) {
+            std::cerr << "SignalService::write_json differs from to_json:\n" << direct << "\n" << expected << "\n"; return 2;
+        }
+        for (const auto& signal : random_signals) {
+            std::string single;
+            signals::SignalService::write_signal_json(single, signal);
+            if (single != signals::SignalService::signal_to_json(signal).dump()) {
+                std::cerr << "SignalService::write_signal_json differs: " << single << "\n"; return 2;
+            }
+        }
+    }
+
     std::cout << "All tests passed" << std::endl;
     return 0;
 }